@@ -26,13 +26,203 @@
 #include "StcClient.h"
 
 #include "StcMisc.h"
+
+#include <string.h>
+#ifdef _WIN32
 #include <sddl.h>
+#endif
 
 #pragma comment(lib, "dxguid")
 #pragma warning(disable : 4710)
 #pragma warning(disable : 4711)
 #pragma warning(disable : 5045)
 
+static void CloseConnection(StcClientBase* const pBase) {
+    StcEventSignal(&pBase->serverWake);
+    StcEventClose(&pBase->clientWake);
+    StcEventClose(&pBase->serverWake);
+#ifdef STC_TRANSPORT_PASSES_DESCRIPTORS
+    StcChannelClose(&pBase->channel);
+#endif
+    StcMappingClose(&pBase->mapping);
+    StcMappingClose(&pBase->globalMapping);
+    pBase->pInfo = NULL;
+}
+
+// Kept across reconnects. The server only reads it when deciding whether to copy the next frame, so no ordering is needed.
+static void SetFrameInterval(StcClientBase* const pBase, const uint32_t intervalMicroseconds) {
+    pBase->frameIntervalMicroseconds = intervalMicroseconds;
+    if (pBase->pInfo != NULL) {
+        StcAtomicUint32StoreRelaxed(&pBase->pInfo->frameIntervalMicroseconds, intervalMicroseconds);
+    }
+}
+
+// Only the client writes the tail and only the server writes the head, so a full ring is reported back rather than
+// overwritten. The release on the tail publishes the message along with it.
+static StcClientStatus SendControl(StcClientBase* const pBase, const uint32_t type, const void* const pData, const size_t size) {
+    StcClientStatus status = STC_CLIENT_STATUS_FAIL_NOT_CONNECTED;
+
+    StcInfo* const pInfo = pBase->pInfo;
+    if (pInfo != NULL) {
+        const uint32_t tail = StcAtomicUint32LoadRelaxed(&pInfo->controlTail);
+        if ((pBase->capabilities & STC_CAPABILITY_FLAG_CONTROL) == 0) {
+            status = STC_CLIENT_STATUS_FAIL_CAPABILITY_UNSUPPORTED;
+        } else if (size > STC_CONTROL_PAYLOAD_SIZE) {
+            status = STC_CLIENT_STATUS_FAIL_CONTROL_TOO_LARGE;
+        } else if ((tail - StcAtomicUint32Load(&pInfo->controlHead)) >= STC_CONTROL_RING_SIZE) {
+            status = STC_CLIENT_STATUS_FAIL_CONTROL_RING_FULL;
+        } else {
+            StcControlMessage* const pMessage = &pInfo->controlMessages[tail & (STC_CONTROL_RING_SIZE - 1)];
+            pMessage->type = type;
+            pMessage->size = (uint32_t)size;
+            if (size > 0) {
+                memcpy(pMessage->payload, pData, size);
+            }
+
+            StcAtomicUint32StoreRelease(&pInfo->controlTail, tail + 1);
+            StcEventSignal(&pBase->serverWake);
+            status = STC_CLIENT_STATUS_SUCCESS;
+        }
+    }
+
+    return status;
+}
+
+#ifdef _WIN32
+// Only lasts for the current connection, since Connect takes the parameters again. The release on the generation
+// publishes both values together, and the server recreates each frame with them as its slot comes around.
+static StcClientStatus UpdateParameters(StcClientBase* const pBase, const StcBindFlags bindFlags,
+                                        const StcSrgbChannelType srgbChannelType) {
+    StcClientStatus status = STC_CLIENT_STATUS_FAIL_NOT_CONNECTED;
+
+    StcInfo* const pInfo = pBase->pInfo;
+    if (pInfo != NULL) {
+        status = STC_CLIENT_STATUS_FAIL_CAPABILITY_UNSUPPORTED;
+        if ((pBase->capabilities & STC_CAPABILITY_FLAG_LIVE_PARAMETERS) != 0) {
+            StcAtomicUint32StoreRelaxed(&pInfo->requestedBindFlags, bindFlags);
+            StcAtomicUint32StoreRelaxed(&pInfo->requestedSrgbChannelType, (uint32_t)srgbChannelType);
+            StcAtomicUint32StoreRelease(&pInfo->parameterGeneration,
+                                        StcAtomicUint32LoadRelaxed(&pInfo->parameterGeneration) + 1);
+            StcEventSignal(&pBase->serverWake);
+            status = STC_CLIENT_STATUS_SUCCESS;
+        }
+    }
+
+    return status;
+}
+#endif
+
+static StcClientStatus CheckStream(const StcClientBase* const pBase, const size_t stream) {
+    StcClientStatus status = STC_CLIENT_STATUS_FAIL_NOT_CONNECTED;
+    if (pBase->pInfo != NULL) {
+        status = (stream < pBase->streamCount) ? STC_CLIENT_STATUS_SUCCESS : STC_CLIENT_STATUS_FAIL_INVALID_STREAM;
+    }
+
+    return status;
+}
+
+// Valid from WaitForServerWrite until SignalRead. The server cannot write a slot the client holds, so the seqlock only
+// retries if the shared memory was scribbled on. Metadata left over from an earlier frame in the slot reads back as empty.
+static StcClientStatus ReadFrameMetadata(const StcClientBase* const pBase, const size_t stream, void* const pData,
+                                         const size_t capacity, size_t* const pSize) {
+    StcClientStatus status = CheckStream(pBase, stream);
+    *pSize = 0;
+
+    StcInfo* const pInfo = pBase->pInfo;
+    if (status == STC_CLIENT_STATUS_SUCCESS) {
+        const StcClientStream* const pStream = &pBase->streams[stream];
+        if (pStream->hasValidImage && (pBase->metadataCapacity > 0)) {
+            const StcFrameMetadata* const pMetadata =
+                StcGetFrameMetadata(pInfo, pBase->metadataCapacity, pStream->serverStream, pStream->copyIndex);
+
+            // A size beyond the capacity can only come from a torn read, the server refuses to write one
+            status = STC_CLIENT_STATUS_FAIL_READ_METADATA;
+            for (size_t attempt = 0; (status == STC_CLIENT_STATUS_FAIL_READ_METADATA) && (attempt < 4); ++attempt) {
+                const uint32_t lock = StcAtomicUint32Load(&pMetadata->lock);
+                const size_t size = (pMetadata->frameSequence == pStream->frameSequence) ? pMetadata->size : 0;
+                const bool valid = size <= pBase->metadataCapacity;
+                if (valid && (size <= capacity)) {
+                    memcpy(pData, pMetadata + 1, size);
+                }
+
+                StcAtomicFenceAcquire();
+                if (valid && ((lock & 1) == 0) && (StcAtomicUint32LoadRelaxed(&pMetadata->lock) == lock)) {
+                    *pSize = size;
+                    status = (size <= capacity) ? STC_CLIENT_STATUS_SUCCESS : STC_CLIENT_STATUS_FAIL_METADATA_BUFFER_TOO_SMALL;
+                }
+            }
+        }
+    }
+
+    return status;
+}
+
+// The server does not touch a record until auxHead is released past it, so it is read in place. A size the server could
+// not have written means the ring was scribbled on, and everything pending is dropped rather than trusted.
+static StcClientStatus ReadAuxRecord(StcClientBase* const pBase, StcAuxRecord* const pRecord, void* const pData,
+                                     const size_t capacity) {
+    StcClientStatus status = STC_CLIENT_STATUS_FAIL_NOT_CONNECTED;
+
+    StcInfo* const pInfo = pBase->pInfo;
+    if (pInfo != NULL) {
+        status = STC_CLIENT_STATUS_FAIL_CAPABILITY_UNSUPPORTED;
+        if (pBase->pAuxRing != NULL) {
+            const uint32_t tail = StcAtomicUint32Load(&pInfo->auxTail);
+            uint32_t head = StcAtomicUint32LoadRelaxed(&pInfo->auxHead);
+            const StcAuxRecordHeader* pHeader = StcGetAuxRecordHeader(pBase->pAuxRing, head);
+            if ((head != tail) && (pHeader->type == STC_AUX_RECORD_TYPE_WRAP)) {
+                head += STC_AUX_RING_SIZE - (head & (STC_AUX_RING_SIZE - 1));
+                pHeader = StcGetAuxRecordHeader(pBase->pAuxRing, head);
+            }
+
+            status = STC_CLIENT_STATUS_FAIL_NO_AUX_RECORD;
+            if ((head != tail) && ((pHeader->size > STC_MAX_AUX_RECORD_SIZE) || (pHeader->type == STC_AUX_RECORD_TYPE_WRAP))) {
+                head = tail;
+            } else if (head != tail) {
+                pRecord->type = pHeader->type;
+                pRecord->size = pHeader->size;
+                pRecord->stream = pHeader->stream;
+                for (size_t stream = 0; stream < pBase->streamCount; ++stream) {
+                    if (pBase->streams[stream].serverStream == pHeader->stream) {
+                        pRecord->stream = stream;
+                    }
+                }
+                pRecord->ticks = pHeader->ticks;
+                pRecord->frameSequence = pHeader->frameSequence;
+                pRecord->droppedBefore = pHeader->droppedBefore;
+
+                status = STC_CLIENT_STATUS_FAIL_AUX_BUFFER_TOO_SMALL;
+                if (pHeader->size <= capacity) {
+                    memcpy(pData, pHeader + 1, pHeader->size);
+                    head += StcGetAuxRecordStride(pHeader->size);
+                    status = STC_CLIENT_STATUS_SUCCESS;
+                }
+            }
+
+            StcAtomicUint32StoreRelease(&pInfo->auxHead, head);
+        }
+    }
+
+    return status;
+}
+
+static void ResetFrameStats(StcClientBase* const pBase) {
+    for (size_t stream = 0; stream < STC_MAX_STREAM_COUNT; ++stream) {
+        StcClientFrameStats* const pStats = &pBase->streams[stream].frameStats;
+        pStats->framesAcquired = 0;
+        pStats->framesDropped = 0;
+        pStats->dropEvents = 0;
+        pStats->largestGap = 0;
+        for (size_t i = 0; i < STC_FRAME_AGE_BUCKETS; ++i) {
+            pStats->ageHistogram[i] = 0;
+        }
+        pStats->totalAgeMicroseconds = 0;
+        pStats->maxAgeMicroseconds = 0;
+        pStats->totalHoldMicroseconds = 0;
+    }
+}
+
+#ifdef _WIN32
 static bool StcCreateFunctionD3D11Null(void* pUserData, size_t index, ID3D11Texture2D* pTexture) {
     (void)pUserData;
     (void)index;
@@ -97,6 +287,10 @@ StcClientStatus StcClientD3D11Create(StcClientD3D11* const pClient, ID3D11Device
     }
 
     pBase->pInfo = NULL;
+    pBase->streamCount = 0;
+    pBase->tickFrequency = StcGetTickFrequency();
+    pBase->frameIntervalMicroseconds = 0;
+    ResetFrameStats(pBase);
     pClient->pDevice = pDevice;
     pClient->usesLegacyHandles = usesLegacyHandles;
     pClient->pDevice1 = pDevice1;
@@ -142,6 +336,10 @@ StcClientStatus StcClientD3D12Create(StcClientD3D12* const pClient, ID3D12Device
     }
 
     pClient->base.pInfo = NULL;
+    pBase->streamCount = 0;
+    pBase->tickFrequency = StcGetTickFrequency();
+    pBase->frameIntervalMicroseconds = 0;
+    ResetFrameStats(pBase);
     pClient->hFenceClearedAutoEvent = hFenceClearedAutoEvent;
     pClient->pDevice = pDevice;
 
@@ -161,9 +359,9 @@ static void StcClientD3D11Disconnect(StcClientD3D11* const pClient, const StcCli
     StcInfo* const pInfo = pBase->pInfo;
 
     if (pInfo != NULL) {
-        StcAtomicUint32Store(&pInfo->clientStopReason, reason);
+        StcAtomicUint32StoreRelease(&pInfo->clientStopReason, reason);
 
-        for (size_t i = 0; i < STC_TEXTURE_COUNT; ++i) {
+        for (size_t i = 0; i < pBase->textureCount; ++i) {
             if (pClient->pTextures[i]) {
                 pClient->allocator.pfnDestroy(pClient->allocator.pUserData, i);
 
@@ -174,8 +372,7 @@ static void StcClientD3D11Disconnect(StcClientD3D11* const pClient, const StcCli
             }
         }
 
-        UnmapViewOfFile(pInfo);
-        pBase->pInfo = NULL;
+        CloseConnection(pBase);
 
         CloseHandle(pBase->hProcess);
     }
@@ -186,17 +383,17 @@ static void StcClientD3D12Disconnect(StcClientD3D12* const pClient, const StcCli
     StcInfo* const pInfo = pBase->pInfo;
 
     if (pInfo != NULL) {
-        StcAtomicUint32Store(&pInfo->clientStopReason, reason);
+        StcAtomicUint32StoreRelease(&pInfo->clientStopReason, reason);
 
-        const size_t copyIndex = pBase->copyIndex;
+        const size_t copyIndex = pBase->streams[0].copyIndex;
         if (pClient->pTextures[copyIndex]) {
             const HANDLE hFenceClearedAutoEvent = pClient->hFenceClearedAutoEvent;
-            ID3D12Fence_SetEventOnCompletion(pClient->pReadFences[copyIndex], pInfo->readFenceValues12[copyIndex],
+            ID3D12Fence_SetEventOnCompletion(pClient->pReadFences[copyIndex], pInfo->streams[0].readFenceValues12[copyIndex],
                                              hFenceClearedAutoEvent);
             WaitForSingleObject(hFenceClearedAutoEvent, INFINITE);
         }
 
-        for (size_t i = 0; i < STC_TEXTURE_COUNT; ++i) {
+        for (size_t i = 0; i < pBase->textureCount; ++i) {
             if (pClient->pTextures[i]) {
                 pClient->allocator.pfnDestroy(pClient->allocator.pUserData, i);
 
@@ -209,8 +406,7 @@ static void StcClientD3D12Disconnect(StcClientD3D12* const pClient, const StcCli
             }
         }
 
-        UnmapViewOfFile(pInfo);
-        pBase->pInfo = NULL;
+        CloseConnection(pBase);
     }
 }
 
@@ -242,7 +438,102 @@ void StcClientD3D12Destroy(StcClientD3D12* const pClient) {
 
     StcLogMessage(&pBase->messenger, STC_MESSAGE_ID_CLIENT_DESTROY_D3D12_SUCCESS);
 }
+#endif
+
+static bool StcCreateFunctionCpuNull(void* pUserData, size_t index, void* pData, size_t rowPitch) {
+    (void)pUserData;
+    (void)index;
+    (void)pData;
+    (void)rowPitch;
+
+    return true;
+}
+
+static void StcDestroyFunctionCpuNull(void* pUserData, size_t index) {
+    (void)pUserData;
+    (void)index;
+}
+
+StcClientStatus StcClientCpuCreate(StcClientCpu* const pClient, const StcCpuAllocationCallbacks* const pAllocator,
+                                   const StcMessageCallbacks* pMessenger) {
+    StcClientBase* const pBase = &pClient->base;
+
+    if (pMessenger) {
+        pBase->messenger = *pMessenger;
+    } else {
+        pBase->messenger.pUserData = NULL;
+        pBase->messenger.pfnMessage = NULL;
+        pMessenger = &pBase->messenger;
+    }
+
+    StcLogMessage(pMessenger, STC_MESSAGE_ID_CLIENT_VERSION, STC_MAJOR_VERSION, STC_MINOR_VERSION, STC_PATCH_VERSION,
+                  StcGetApiName(STC_API_CPU));
+
+    if (pAllocator) {
+        pClient->allocator = *pAllocator;
+    } else {
+        pClient->allocator.pfnCreate = StcCreateFunctionCpuNull;
+        pClient->allocator.pfnDestroy = StcDestroyFunctionCpuNull;
+    }
+
+    pBase->pInfo = NULL;
+    pBase->streamCount = 0;
+    pBase->tickFrequency = StcGetTickFrequency();
+    pBase->frameIntervalMicroseconds = 0;
+    ResetFrameStats(pBase);
+    pBase->initialized = true;
+
+    StcLogMessage(pMessenger, STC_MESSAGE_ID_CLIENT_CREATE_CPU_SUCCESS);
+
+    return STC_CLIENT_STATUS_SUCCESS;
+}
+
+static void StcClientCpuDisconnect(StcClientCpu* const pClient, const StcClientStopReason reason) {
+    StcClientBase* const pBase = &pClient->base;
+    StcInfo* const pInfo = pBase->pInfo;
+
+    if (pInfo != NULL) {
+        StcAtomicUint32StoreRelease(&pInfo->clientStopReason, reason);
+
+        for (size_t stream = 0; stream < pBase->streamCount; ++stream) {
+            StcClientCpuStream* const pCpuStream = &pClient->streams[stream];
+            for (size_t i = 0; i < pBase->textureCount; ++i) {
+                if (pCpuStream->pFrameHeaders[i]) {
+                    pClient->allocator.pfnDestroy(pClient->allocator.pUserData, stream * STC_MAX_TEXTURE_COUNT + i);
+
+                    StcMappingClose(&pCpuStream->frameMappings[i]);
+                    pCpuStream->pFrameHeaders[i] = NULL;
+                }
+
+#ifdef STC_TRANSPORT_PASSES_DESCRIPTORS
+                if (pCpuStream->receivedGenerations[i] != 0) {
+                    StcMappingClose(&pCpuStream->receivedMappings[i]);
+                    pCpuStream->receivedGenerations[i] = 0;
+                }
+#endif
+            }
+        }
+
+        CloseConnection(pBase);
+
+#ifdef _WIN32
+        CloseHandle(pBase->hProcess);
+#endif
+    }
+}
+
+void StcClientCpuDestroy(StcClientCpu* const pClient) {
+    StcClientBase* const pBase = &pClient->base;
+    if (pBase->initialized) {
+        StcClientCpuDisconnect(pClient, STC_CLIENT_STOP_REASON_DESTROY);
+
+        pBase->initialized = false;
+    }
+
+    StcLogMessage(&pBase->messenger, STC_MESSAGE_ID_CLIENT_DESTROY_CPU_SUCCESS);
+}
 
+#ifdef _WIN32
 static StcClientStatus StcComputeGlobalName(const TCHAR* const pPrefix, const DWORD processId, size_t bufferCount,
                                             TCHAR* pGlobalNameBuffer) {
     StcClientStatus status = STC_CLIENT_STATUS_SUCCESS;
@@ -303,100 +594,328 @@ static StcClientStatus StcComputeGlobalName(const TCHAR* const pPrefix, const DW
 
     return status;
 }
+#else
+static StcClientStatus StcComputeGlobalName(const TCHAR* const pPrefix, const DWORD processId, size_t bufferCount,
+                                            TCHAR* pGlobalNameBuffer) {
+    StcClientStatus status = STC_CLIENT_STATUS_SUCCESS;
+
+    const int result = stc_stprintf(pGlobalNameBuffer, bufferCount, TEXT("%") STC_TSTRINGWIDTH TEXT("s_%lu"), pPrefix,
+                                    (unsigned long)processId);
+    if (result < 0 || (result >= (int)bufferCount)) {
+        status = STC_CLIENT_STATUS_FAIL_STRING_FORMAT;
+    }
+
+    return status;
+}
+#endif
+
+#ifdef STC_TRANSPORT_PASSES_DESCRIPTORS
+static bool ConnectWakeChannel(StcChannel* const pChannel, const TCHAR* const pName, const StcEvent* const pClientWake,
+                               int* const pError) {
+    if (!StcChannelConnect(pChannel, pName, pError)) {
+        return false;
+    }
+
+    StcWakeDescriptorMessage message;
+    message.reserved = 0;
+    if (!StcChannelSend(pChannel, &message, sizeof(message), &pClientWake->fd, 1, pError)) {
+        StcChannelClose(pChannel);
+        return false;
+    }
+
+    return true;
+}
+
+// The server sends it before it finishes the handshake, so it is already queued ahead of any frame batch
+static bool ReceiveWakeDescriptor(StcClientBase* const pBase) {
+    StcWakeDescriptorMessage message;
+    int fd;
+    int error;
+    if (!StcChannelReceiveDescriptor(&pBase->channel, &message, sizeof(message), &fd, &error)) {
+        return false;
+    }
+
+    StcEventAttachDescriptor(&pBase->serverWake, fd);
+    return true;
+}
+#endif
 
+// With no stream names the client subscribes to the unnamed stream 0, which every server has
 StcClientStatus StcClientConnect(StcClientBase* const pBase, const TCHAR* const pPrefix, const DWORD processId,
-                                 const StcBindFlags bindFlags, const StcSrgbChannelType srgbChannelType, const StcApi api) {
-    TCHAR pGlobalNameBuffer[256];
-    StcClientStatus status = StcComputeGlobalName(pPrefix, processId, _countof(pGlobalNameBuffer), pGlobalNameBuffer);
+                                 const StcBindFlags bindFlags, const StcSrgbChannelType srgbChannelType, const StcApi api,
+                                 uint32_t textureCount, const StcSwapMode swapMode, const char* const* const ppStreamNames,
+                                 size_t streamCount) {
+    if (textureCount == 0) {
+        textureCount = STC_DEFAULT_TEXTURE_COUNT;
+    }
+
+    TCHAR* const pGlobalNameBuffer = pBase->pGlobalNameBuffer;
+    StcClientStatus status = STC_CLIENT_STATUS_FAIL_INVALID_TEXTURE_COUNT;
+    if ((textureCount < STC_MIN_TEXTURE_COUNT) || (textureCount > STC_MAX_TEXTURE_COUNT)) {
+        goto fail0;
+    }
+
+    status = STC_CLIENT_STATUS_FAIL_INVALID_SWAP_MODE;
+    if ((swapMode != STC_SWAP_MODE_FIFO) && (swapMode != STC_SWAP_MODE_MAILBOX)) {
+        goto fail0;
+    }
+
+    status = StcComputeGlobalName(pPrefix, processId, _countof(pBase->pGlobalNameBuffer), pGlobalNameBuffer);
     if (status != STC_CLIENT_STATUS_SUCCESS) {
         goto fail0;
     }
 
-    const HANDLE hGlobalMapFile = OpenFileMapping(FILE_MAP_ALL_ACCESS, FALSE, pGlobalNameBuffer);
-    if (hGlobalMapFile == NULL) {
+    StcMapping globalMapping;
+    int error;
+    StcMappingResult mappingResult = StcMappingOpen(&globalMapping, pGlobalNameBuffer, STC_MAP_SIZE, &error);
+    if (mappingResult == STC_MAPPING_RESULT_FAIL_OPEN) {
         status = STC_CLIENT_STATUS_FAIL_OPEN_GLOBAL_FILE_MAPPING;
         goto fail0;
     }
 
-    StcGlobalInfo* const pGlobalInfo = MapViewOfFile(hGlobalMapFile, FILE_MAP_ALL_ACCESS, 0, 0, sizeof(StcGlobalInfo));
-    CloseHandle(hGlobalMapFile);
-
-    if (pGlobalInfo == NULL) {
+    if (mappingResult != STC_MAPPING_RESULT_SUCCESS) {
         status = STC_CLIENT_STATUS_FAIL_MAP_GLOBAL_INFO;
         goto fail0;
     }
 
+    StcGlobalInfo* const pGlobalInfo = globalMapping.pView;
+
     if ((pGlobalInfo->version != STC_MAJOR_VERSION)) {
         status = STC_CLIENT_STATUS_FAIL_VERSION_MISMATCH;
         goto fail1;
     }
 
+    // Features only one side knows about drop back to the baseline protocol. Named streams cannot, since the caller
+    // asked for frames an older server does not have.
+    const StcCapabilityFlags capabilities = pGlobalInfo->capabilities & STC_SUPPORTED_CAPABILITIES;
+    const StcSwapMode connectionSwapMode =
+        ((capabilities & STC_CAPABILITY_FLAG_MAILBOX) != 0) ? swapMode : STC_SWAP_MODE_FIFO;
+
+    // Leave the token for a compatible client instead of making the server reject us after the handshake
+    if (!StcIsClientApiSupported(pGlobalInfo->serverApi, api)) {
+        status = STC_CLIENT_STATUS_FAIL_API_MISMATCH;
+        goto fail1;
+    }
+
+    // Names are resolved before taking the token for the same reason. Naming a stream twice would give it two readers.
+    size_t serverStreams[STC_MAX_STREAM_COUNT] = {0};
+    uint32_t streamMask = 1;
+    if (streamCount > 0) {
+        const uint32_t serverStreamCount =
+            ((capabilities & STC_CAPABILITY_FLAG_STREAMS) != 0) ? StcAtomicUint32Load(&pGlobalInfo->streamCount) : 0;
+        streamMask = 0;
+        for (size_t i = 0; i < streamCount; ++i) {
+            size_t serverStream = 0;
+            while ((serverStream < serverStreamCount) &&
+                   (strncmp(pGlobalInfo->streamNames[serverStream], ppStreamNames[i], STC_STREAM_NAME_SIZE) != 0)) {
+                ++serverStream;
+            }
+
+            if ((i >= STC_MAX_STREAM_COUNT) || (serverStream == serverStreamCount) || ((streamMask & (1u << serverStream)) != 0)) {
+                status = STC_CLIENT_STATUS_FAIL_UNKNOWN_STREAM;
+                goto fail1;
+            }
+
+            serverStreams[i] = serverStream;
+            streamMask |= 1u << serverStream;
+        }
+    } else {
+        streamCount = 1;
+    }
+
     int64_t connectToken = StcAtomicInt64Load(&pGlobalInfo->connectToken);
     if (connectToken == 0 || StcAtomicInt64CompareExchange(&pGlobalInfo->connectToken, 0, connectToken) != connectToken) {
         status = STC_CLIENT_STATUS_FAIL_CONNECTION_UNAVAILABLE;
         goto fail1;
     }
 
-    TCHAR pConnectionNameBuffer[256];
-    const int result = stc_stprintf(pConnectionNameBuffer, _countof(pConnectionNameBuffer),
+    TCHAR* const pConnectionNameBuffer = pBase->pConnectionNameBuffer;
+    const int result = stc_stprintf(pConnectionNameBuffer, _countof(pBase->pConnectionNameBuffer),
                                     TEXT("%") STC_TSTRINGWIDTH TEXT("s_%lld"), pGlobalNameBuffer, (long long)connectToken);
-    if (result < 0 || result >= _countof(pConnectionNameBuffer)) {
+    if (result < 0 || (result >= (int)_countof(pBase->pConnectionNameBuffer))) {
         status = STC_CLIENT_STATUS_FAIL_STRING_FORMAT;
         goto fail1;
     }
 
-    const HANDLE hMapFile = OpenFileMapping(FILE_MAP_ALL_ACCESS, FALSE, pConnectionNameBuffer);
-    if (hMapFile == NULL) {
+    // Metadata for every slot follows StcInfo, so the mapping grows with the capacity the server was created with. The
+    // auxiliary ring comes after all of it, so a client that reads records maps the metadata even if it never reads that.
+    const size_t metadataCapacity =
+        ((capabilities & STC_CAPABILITY_FLAG_FRAME_METADATA) != 0) ? pGlobalInfo->metadataCapacity : 0;
+    const bool auxRecords = (capabilities & STC_CAPABILITY_FLAG_AUX_RECORDS) != 0;
+    const size_t layoutCapacity = auxRecords ? pGlobalInfo->metadataCapacity : metadataCapacity;
+    StcMapping mapping;
+    mappingResult =
+        StcMappingOpen(&mapping, pConnectionNameBuffer, StcGetConnectionMapSize(layoutCapacity, auxRecords), &error);
+    if (mappingResult == STC_MAPPING_RESULT_FAIL_OPEN) {
         status = STC_CLIENT_STATUS_FAIL_OPEN_CONNECTION_FILE_MAPPING;
         goto fail1;
     }
 
-    StcInfo* const pInfo = MapViewOfFile(hMapFile, FILE_MAP_ALL_ACCESS, 0, 0, sizeof(StcInfo));
-    if (pInfo == NULL) {
+    if (mappingResult != STC_MAPPING_RESULT_SUCCESS) {
         status = STC_CLIENT_STATUS_FAIL_MAP_CONNECTION_INFO;
+        goto fail1;
+    }
+
+    StcInfo* const pInfo = mapping.pView;
+
+    // The server wakes for all of its clients through one event, while each client has its own
+    TCHAR pEventNameBuffer[_countof(pBase->pConnectionNameBuffer) + 16];
+    stc_stprintf(pEventNameBuffer, _countof(pEventNameBuffer), TEXT("%") STC_TSTRINGWIDTH TEXT("s_ServerWake"), pGlobalNameBuffer);
+    StcEvent serverWake;
+    if (!StcEventOpen(&serverWake, pEventNameBuffer, &error)) {
+        status = STC_CLIENT_STATUS_FAIL_OPEN_EVENT;
         goto fail2;
     }
 
+    stc_stprintf(pEventNameBuffer, _countof(pEventNameBuffer), TEXT("%") STC_TSTRINGWIDTH TEXT("s_ClientWake"),
+                 pConnectionNameBuffer);
+    StcEvent clientWake;
+    if (!StcEventOpen(&clientWake, pEventNameBuffer, &error)) {
+        status = STC_CLIENT_STATUS_FAIL_OPEN_EVENT;
+        goto fail3;
+    }
+
+    serverWake.pWord = &pGlobalInfo->serverWake;
+    clientWake.pWord = &pInfo->clientWake;
+
+#ifdef _WIN32
     const HANDLE hProcess = OpenProcess(PROCESS_DUP_HANDLE, FALSE, processId);
     if (hProcess == NULL) {
         status = STC_CLIENT_STATUS_FAIL_OPEN_PROCESS;
-        goto fail3;
+        goto fail4;
+    }
+#endif
+
+#ifdef STC_TRANSPORT_PASSES_DESCRIPTORS
+    const bool wakeDescriptors = (capabilities & STC_CAPABILITY_FLAG_WAKE_DESCRIPTORS) != 0;
+    if (wakeDescriptors && !StcEventCreateDescriptor(&clientWake, &error)) {
+        status = STC_CLIENT_STATUS_FAIL_CREATE_EVENT;
+        goto fail4;
     }
 
-    StcAtomicInt64Store(&pInfo->clientKeepAlive, StcGetCurrentTicks());
+    // Older servers accept as soon as they see clientParametersSpecified, so the client must already be queued then
+    StcChannel channel;
+    if (!wakeDescriptors && !StcChannelConnect(&channel, pConnectionNameBuffer, &error)) {
+        status = STC_CLIENT_STATUS_FAIL_CONNECT_CHANNEL;
+        goto fail4;
+    }
+#endif
+
+    StcAtomicInt64StoreRelaxed(&pInfo->clientKeepAlive, StcGetCurrentTicks());
 
     pInfo->clientBindFlags = bindFlags;
     pInfo->srgbChannelType = srgbChannelType;
     pInfo->clientApi = api;
-    StcAtomicBoolStore(&pInfo->clientParametersSpecified, true);
+    pInfo->textureCount = textureCount;
+    pInfo->swapMode = connectionSwapMode;
+    pInfo->streamMask = streamMask;
+    pInfo->clientMinorVersion = STC_MINOR_VERSION;
+    pInfo->clientCapabilities = capabilities;
+    StcAtomicUint32StoreRelaxed(&pInfo->frameIntervalMicroseconds, pBase->frameIntervalMicroseconds);
+    StcAtomicBoolStoreRelease(&pInfo->clientParametersSpecified, true);
+
+#ifdef STC_TRANSPORT_PASSES_DESCRIPTORS
+    // Otherwise the client connects once the parameters are out, since that is all that wakes a server polling its wake
+    // descriptor until it holds this side's, which follows right away
+    if (wakeDescriptors && !ConnectWakeChannel(&channel, pConnectionNameBuffer, &clientWake, &error)) {
+        status = STC_CLIENT_STATUS_FAIL_CONNECT_CHANNEL;
+        goto fail4;
+    }
+#endif
+
+    StcEventSignal(&serverWake);
 
     pBase->serverApi = pGlobalInfo->serverApi;
     pBase->pInfo = pInfo;
-    pBase->copyIndex = STC_TEXTURE_COUNT - 1;
-    pBase->hasValidImage = false;
+    pBase->globalMapping = globalMapping;
+    pBase->mapping = mapping;
+    pBase->serverWake = serverWake;
+    pBase->clientWake = clientWake;
+#ifdef STC_TRANSPORT_PASSES_DESCRIPTORS
+    pBase->channel = channel;
+#endif
+    pBase->wakeToken = StcEventGetToken(&clientWake);
+    pBase->textureCount = textureCount;
+    pBase->swapMode = connectionSwapMode;
+    pBase->capabilities = capabilities;
+#ifdef _WIN32
     pBase->hProcess = hProcess;
+#endif
+    pBase->streamCount = streamCount;
+    for (size_t i = 0; i < streamCount; ++i) {
+        StcClientStream* const pStream = &pBase->streams[i];
+        pStream->serverStream = serverStreams[i];
+        pStream->copyIndex = textureCount - 1;
+        pStream->hasValidImage = false;
+        pStream->slotHeld = true;
+        pStream->frameSequence = 0;
+        pStream->framesBehind = 0;
+        for (size_t index = 0; index < STC_MAX_TEXTURE_COUNT; ++index) {
+            pStream->leased[index] = false;
+        }
+        pStream->leaseCount = 0;
+        pStream->resizeGeneration = 0;
+    }
+    pBase->metadataCapacity = metadataCapacity;
+    pBase->pAuxRing = auxRecords ? StcGetAuxRing(pInfo, layoutCapacity) : NULL;
+    pBase->standby = false;
+    pBase->standbyRequestTicks = 0;
 
     goto success;
 
+#if defined(_WIN32) || defined(STC_TRANSPORT_PASSES_DESCRIPTORS)
+fail4:
+    StcEventClose(&clientWake);
+#endif
 fail3:
-    UnmapViewOfFile(pInfo);
+    StcEventClose(&serverWake);
 fail2:
-success:
-    CloseHandle(hMapFile);
+    StcMappingClose(&mapping);
 fail1:
-    UnmapViewOfFile(pGlobalInfo);
+    StcMappingClose(&globalMapping);
 fail0:
+success:
+    return status;
+}
+
+StcClientStatus StcClientCpuConnectStreams(StcClientCpu* const pClient, const TCHAR* const pPrefix, const DWORD processId,
+                                           const uint32_t textureCount, const StcSwapMode swapMode,
+                                           const char* const* const ppStreamNames, const size_t streamCount) {
+    StcClientCpuDisconnect(pClient, STC_CLIENT_STOP_REASON_NEW_CONNECTION);
+
+    StcClientStatus status = StcClientConnect(&pClient->base, pPrefix, processId, STC_BIND_FLAG_NONE, STC_SRGB_CHANNEL_TYPE_UNORM,
+                                              STC_API_CPU, textureCount, swapMode, ppStreamNames, streamCount);
+    if (status == STC_CLIENT_STATUS_SUCCESS) {
+        for (size_t stream = 0; stream < STC_MAX_STREAM_COUNT; ++stream) {
+            for (size_t i = 0; i < STC_MAX_TEXTURE_COUNT; ++i) {
+                pClient->streams[stream].pFrameHeaders[i] = NULL;
+#ifdef STC_TRANSPORT_PASSES_DESCRIPTORS
+                pClient->streams[stream].receivedGenerations[i] = 0;
+#endif
+            }
+        }
+    }
+
     return status;
 }
 
+StcClientStatus StcClientCpuConnect(StcClientCpu* const pClient, const TCHAR* const pPrefix, const DWORD processId,
+                                    const uint32_t textureCount, const StcSwapMode swapMode) {
+    return StcClientCpuConnectStreams(pClient, pPrefix, processId, textureCount, swapMode, NULL, 0);
+}
+
+#ifdef _WIN32
 StcClientStatus StcClientD3D11Connect(StcClientD3D11* const pClient, const TCHAR* const pPrefix, const DWORD processId,
-                                      const StcBindFlags bindFlags, const StcSrgbChannelType srgbChannelType) {
+                                      const StcBindFlags bindFlags, const StcSrgbChannelType srgbChannelType,
+                                      const uint32_t textureCount, const StcSwapMode swapMode) {
     StcClientD3D11Disconnect(pClient, STC_CLIENT_STOP_REASON_NEW_CONNECTION);
 
-    StcClientStatus status = StcClientConnect(&pClient->base, pPrefix, processId, bindFlags, srgbChannelType, STC_API_D3D11);
+    StcClientStatus status = StcClientConnect(&pClient->base, pPrefix, processId, bindFlags, srgbChannelType, STC_API_D3D11,
+                                              textureCount, swapMode, NULL, 0);
     if (status == STC_CLIENT_STATUS_SUCCESS) {
-        for (size_t i = 0; i < STC_TEXTURE_COUNT; ++i) {
+        for (size_t i = 0; i < STC_MAX_TEXTURE_COUNT; ++i) {
             pClient->pTextures[i] = NULL;
+            pClient->keyHeld[i] = false;
         }
     }
 
@@ -404,12 +923,14 @@ StcClientStatus StcClientD3D11Connect(StcClientD3D11* const pClient, const TCHAR
 }
 
 StcClientStatus StcClientD3D12Connect(StcClientD3D12* const pClient, const TCHAR* const pPrefix, const DWORD processId,
-                                      const StcBindFlags bindFlags, const StcSrgbChannelType srgbChannelType) {
+                                      const StcBindFlags bindFlags, const StcSrgbChannelType srgbChannelType,
+                                      const uint32_t textureCount, const StcSwapMode swapMode) {
     StcClientD3D12Disconnect(pClient, STC_CLIENT_STOP_REASON_NEW_CONNECTION);
 
-    StcClientStatus status = StcClientConnect(&pClient->base, pPrefix, processId, bindFlags, srgbChannelType, STC_API_D3D12);
+    StcClientStatus status = StcClientConnect(&pClient->base, pPrefix, processId, bindFlags, srgbChannelType, STC_API_D3D12,
+                                              textureCount, swapMode, NULL, 0);
     if (status == STC_CLIENT_STATUS_SUCCESS) {
-        for (size_t i = 0; i < STC_TEXTURE_COUNT; ++i) {
+        for (size_t i = 0; i < STC_MAX_TEXTURE_COUNT; ++i) {
             pClient->pTextures[i] = NULL;
             pClient->pWriteFences[i] = NULL;
             pClient->pReadFences[i] = NULL;
@@ -436,7 +957,7 @@ static StcClientStopReason OpenD3D11ResourceFrame(const StcClientD3D11* const pC
     StcClientStopReason reason = STC_CLIENT_STOP_REASON_NONE;
 
     const StcClientBase* const pBase = &pClient->base;
-    StcInfo* const pInfo = pBase->pInfo;
+    const StcStreamInfo* const pInfo = &pBase->pInfo->streams[0];
     ID3D11Device* const pDevice = pClient->pDevice;
 
     ID3D11Texture2D* pTexture = NULL;
@@ -486,7 +1007,7 @@ static StcClientStopReason OpenD3D12ResourceFrame(const StcClientD3D12* const pC
     StcClientStopReason reason = STC_CLIENT_STOP_REASON_NONE;
 
     const StcClientBase* const pBase = &pClient->base;
-    StcInfo* const pInfo = pBase->pInfo;
+    const StcStreamInfo* const pInfo = &pBase->pInfo->streams[0];
     ID3D12Device* const pDevice = pClient->pDevice;
     const HANDLE hProcess = pBase->hProcess;
 
@@ -548,43 +1069,479 @@ fail0:
 success:
     return reason;
 }
+#endif
 
-static StcClientStatus TickClient(StcClientBase* const pBase, StcClientStopReason* const pReason) {
-    StcClientStatus status = STC_CLIENT_STATUS_FAIL_NOT_CONNECTED;
+typedef struct ResourceFrameCpu {
+    StcMapping mapping;
+    StcCpuFrameHeader* pHeader;
+} ResourceFrameCpu;
+
+#ifdef STC_TRANSPORT_PASSES_DESCRIPTORS
+// Batches come in the order the server sent them, so one for another stream is filed away for when that stream gets to it
+static bool ReceiveCpuResourceFrames(StcClientCpu* const pClient) {
+    StcCpuFrameBatch batch;
+    StcMapping mappings[STC_MAX_TEXTURE_COUNT];
+    size_t mappingCount = STC_MAX_TEXTURE_COUNT;
+    int error;
+    if (!StcChannelReceive(&pClient->base.channel, &batch, sizeof(batch), mappings, &mappingCount, &error)) {
+        return false;
+    }
 
-    StcInfo* const pInfo = pBase->pInfo;
-    if (pInfo) {
-        const int64_t count = StcGetCurrentTicks();
-        StcAtomicInt64Store(&pInfo->clientKeepAlive, count);
+    size_t stream = 0;
+    while ((stream < pClient->base.streamCount) && (pClient->base.streams[stream].serverStream != batch.stream)) {
+        ++stream;
+    }
 
-        if (StcAtomicUint32Load(&pInfo->serverStopReason) != STC_SERVER_STOP_REASON_NONE) {
-            *pReason = STC_CLIENT_STOP_REASON_SERVER_REQUESTED;
-        } else if ((count - StcAtomicInt64Load(&pInfo->serverKeepAlive)) >= StcGetTimeoutTicks()) {
-            *pReason = STC_CLIENT_STOP_REASON_SERVER_TIMED_OUT;
-        } else {
-            status = STC_CLIENT_STATUS_SUCCESS;
+    size_t expectedCount = 0;
+    for (size_t i = 0; i < pClient->base.textureCount; ++i) {
+        expectedCount += (batch.generations[i] != 0) ? 1 : 0;
+    }
+
+    if ((stream == pClient->base.streamCount) || (expectedCount != mappingCount)) {
+        for (size_t i = 0; i < mappingCount; ++i) {
+            StcMappingClose(&mappings[i]);
         }
+
+        return false;
     }
 
-    return status;
-}
+    // A batch can supersede one whose frames were never published, e.g. after back-to-back resizes
+    StcClientCpuStream* const pCpuStream = &pClient->streams[stream];
+    size_t next = 0;
+    for (size_t i = 0; i < pClient->base.textureCount; ++i) {
+        if (batch.generations[i] != 0) {
+            if (pCpuStream->receivedGenerations[i] != 0) {
+                StcMappingClose(&pCpuStream->receivedMappings[i]);
+            }
 
-static StcClientStatus StcClientD3D11ConnectionTick(StcClientD3D11* const pClient) {
-    StcClientBase* const pBase = &pClient->base;
-    StcClientStopReason reason = STC_CLIENT_STOP_REASON_NONE;
-    StcClientStatus status = TickClient(pBase, &reason);
-    if (reason != STC_CLIENT_STOP_REASON_NONE) {
-        StcClientD3D11Disconnect(pClient, reason);
-        status = STC_CLIENT_STATUS_FAIL_DISCONNECTED;
+            pCpuStream->receivedMappings[i] = mappings[next++];
+            pCpuStream->receivedGenerations[i] = batch.generations[i];
+        }
     }
 
-    return status;
+    return true;
 }
+#endif
 
-static StcClientStatus StcClientD3D12ConnectionTick(StcClientD3D12* const pClient) {
-    StcClientBase* const pBase = &pClient->base;
+static StcClientStopReason OpenCpuResourceFrame(StcClientCpu* const pClient, const size_t stream, ResourceFrameCpu* const pFrame,
+                                                const size_t index) {
     StcClientStopReason reason = STC_CLIENT_STOP_REASON_NONE;
-    StcClientStatus status = TickClient(pBase, &reason);
+
+    const StcClientBase* const pBase = &pClient->base;
+    const StcStreamInfo* const pInfo = &pBase->pInfo->streams[pBase->streams[stream].serverStream];
+
+#ifdef STC_TRANSPORT_PASSES_DESCRIPTORS
+    // The server sends a batch before publishing any frame in it, so this never blocks for long
+    StcClientCpuStream* const pCpuStream = &pClient->streams[stream];
+    const uint32_t generation = pInfo->hTextures[index];
+    while (pCpuStream->receivedGenerations[index] < generation) {
+        if (!ReceiveCpuResourceFrames(pClient)) {
+            reason = STC_CLIENT_STOP_REASON_FAIL_RECEIVE_CPU_BUFFERS;
+            goto fail0;
+        }
+    }
+
+    if (pCpuStream->receivedGenerations[index] != generation) {
+        reason = STC_CLIENT_STOP_REASON_FAIL_RECEIVE_CPU_BUFFERS;
+        goto fail0;
+    }
+
+    StcMapping mapping = pCpuStream->receivedMappings[index];
+    pCpuStream->receivedGenerations[index] = 0;
+#else
+    TCHAR pNameBuffer[256];
+    if (!StcFormatCpuFrameName(pNameBuffer, _countof(pNameBuffer), pBase->pGlobalNameBuffer, index, pInfo->hTextures[index])) {
+        reason = STC_CLIENT_STOP_REASON_FAIL_OPEN_CPU_BUFFER;
+        goto fail0;
+    }
+
+    StcMapping mapping;
+    int error;
+    if (StcMappingOpen(&mapping, pNameBuffer, 0, &error) != STC_MAPPING_RESULT_SUCCESS) {
+        reason = STC_CLIENT_STOP_REASON_FAIL_OPEN_CPU_BUFFER;
+        goto fail0;
+    }
+#endif
+
+    // The header is server-written, so make sure it describes memory we actually mapped
+    StcCpuFrameHeader* const pHeader = mapping.pView;
+    const size_t rowPitch = pHeader->rowPitch;
+    if ((mapping.size < STC_CPU_DATA_OFFSET) || (rowPitch < StcComputeCpuRowPitch(pHeader->width, pHeader->format)) ||
+        (((mapping.size - STC_CPU_DATA_OFFSET) / rowPitch) < pHeader->height)) {
+        reason = STC_CLIENT_STOP_REASON_FAIL_OPEN_CPU_BUFFER;
+        goto fail1;
+    }
+
+    pFrame->mapping = mapping;
+    pFrame->pHeader = pHeader;
+    goto success;
+
+fail1:
+    StcMappingClose(&mapping);
+fail0:
+success:
+    return reason;
+}
+
+static StcClientStatus TickClient(StcClientBase* const pBase, StcClientStopReason* const pReason) {
+    StcClientStatus status = STC_CLIENT_STATUS_FAIL_NOT_CONNECTED;
+
+    StcInfo* const pInfo = pBase->pInfo;
+    if (pInfo) {
+        pBase->wakeToken = StcEventGetToken(&pBase->clientWake);
+        const int64_t count = StcGetCurrentTicks();
+        if ((count - StcAtomicInt64LoadRelaxed(&pInfo->clientKeepAlive)) >= (StcGetTimeoutTicks() / STC_KEEP_ALIVE_DIVISOR)) {
+            StcAtomicInt64StoreRelaxed(&pInfo->clientKeepAlive, count);
+        }
+
+        if (StcAtomicUint32Load(&pInfo->serverStopReason) != STC_SERVER_STOP_REASON_NONE) {
+            *pReason = STC_CLIENT_STOP_REASON_SERVER_REQUESTED;
+        } else if ((count - StcAtomicInt64LoadRelaxed(&pInfo->serverKeepAlive)) >= StcGetTimeoutTicks()) {
+            *pReason = STC_CLIENT_STOP_REASON_SERVER_TIMED_OUT;
+        } else {
+            // A server that already feeds other clients keeps its ring depth and hands it back with the handshake. The
+            // depth is server-written and sizes every slot scan, so a value outside the ring limits ends the connection.
+            const uint32_t textureCount = pInfo->textureCount;
+            if (!StcAtomicBoolLoad(&pInfo->serverInitialized) || (textureCount == pBase->textureCount)) {
+                status = STC_CLIENT_STATUS_SUCCESS;
+            } else if ((textureCount < STC_MIN_TEXTURE_COUNT) || (textureCount > STC_MAX_TEXTURE_COUNT)) {
+                *pReason = STC_CLIENT_STOP_REASON_INVALID_TEXTURE_COUNT;
+            } else {
+                pBase->textureCount = textureCount;
+                for (size_t stream = 0; stream < pBase->streamCount; ++stream) {
+                    pBase->streams[stream].copyIndex = pBase->textureCount - 1;
+                    pBase->streams[stream].slotHeld = true;
+                }
+
+                status = STC_CLIENT_STATUS_SUCCESS;
+            }
+        }
+
+#ifdef STC_TRANSPORT_PASSES_DESCRIPTORS
+        if ((status == STC_CLIENT_STATUS_SUCCESS) && ((pBase->capabilities & STC_CAPABILITY_FLAG_WAKE_DESCRIPTORS) != 0) &&
+            (pBase->serverWake.fd < 0) && StcAtomicBoolLoad(&pInfo->serverInitialized) && !ReceiveWakeDescriptor(pBase)) {
+            *pReason = STC_CLIENT_STOP_REASON_FAIL_RECEIVE_WAKE_DESCRIPTOR;
+            status = STC_CLIENT_STATUS_FAIL_NOT_CONNECTED;
+        }
+#endif
+    }
+
+    return status;
+}
+
+static StcClientStatus StcClientWait(StcClientBase* const pBase, const uint32_t timeoutMs) {
+    StcClientStatus status = STC_CLIENT_STATUS_FAIL_NOT_CONNECTED;
+
+    if (pBase->pInfo != NULL) {
+        status = StcEventWait(&pBase->clientWake, pBase->wakeToken, timeoutMs) ? STC_CLIENT_STATUS_SUCCESS
+                                                                                : STC_CLIENT_STATUS_FAIL_WAIT_TIMEOUT;
+    }
+
+    return status;
+}
+
+static int64_t TicksToMicroseconds(const StcClientBase* const pBase, const int64_t ticks) {
+    return (ticks * 1000000) / pBase->tickFrequency;
+}
+
+// Moves a published slot to READING. FIFO claims the oldest frame, mailbox claims the newest and hands the older ones
+// back to the server.
+static bool ClaimReadySlot(StcClientBase* const pBase, const size_t stream, size_t* const pCopyIndex,
+                           uint32_t* const pFramesBehind) {
+    StcStreamInfo* const pInfo = &pBase->pInfo->streams[pBase->streams[stream].serverStream];
+    const size_t textureCount = pBase->textureCount;
+    const bool newest = pBase->swapMode == STC_SWAP_MODE_MAILBOX;
+
+    bool claimed = false;
+    size_t claimIndex = textureCount;
+    uint32_t claimState = 0;
+    uint32_t readyCount = 0;
+    do {
+        claimIndex = textureCount;
+        readyCount = 0;
+        for (size_t index = 0; index < textureCount; ++index) {
+            const uint32_t state = StcAtomicUint32Load(&pInfo->slotStates[index]);
+            if ((state & STC_SLOT_STATE_MASK) == STC_SLOT_STATE_READY) {
+                ++readyCount;
+                if ((claimIndex == textureCount) || (StcSlotIsOlder(state, claimState) != newest)) {
+                    claimIndex = index;
+                    claimState = state;
+                }
+            }
+        }
+
+        // The server may take back the same frame in mailbox mode, in which case the scan is repeated
+        if (claimIndex != textureCount) {
+            const uint32_t reading = (claimState & ~STC_SLOT_STATE_MASK) | STC_SLOT_STATE_READING;
+            claimed = StcAtomicUint32CompareExchange(&pInfo->slotStates[claimIndex], reading, claimState) == claimState;
+        }
+    } while (!claimed && (claimIndex != textureCount));
+
+    if (claimed) {
+        if (newest) {
+            for (size_t index = 0; index < textureCount; ++index) {
+                const uint32_t state = StcAtomicUint32Load(&pInfo->slotStates[index]);
+                if (((state & STC_SLOT_STATE_MASK) == STC_SLOT_STATE_READY) && StcSlotIsOlder(state, claimState)) {
+                    StcAtomicUint32CompareExchange(&pInfo->slotStates[index], STC_SLOT_STATE_FREE, state);
+                }
+            }
+
+            *pFramesBehind = 0;
+        } else {
+            *pFramesBehind = readyCount - 1;
+        }
+
+        *pCopyIndex = claimIndex;
+    }
+
+    return claimed;
+}
+
+// Called with the slot just moved to READING, so the server finished writing its record before publishing it
+static void AcquireFrameRecord(StcClientBase* const pBase, const size_t stream, const size_t copyIndex,
+                               const uint32_t framesBehind) {
+    StcClientStream* const pStream = &pBase->streams[stream];
+    StcStreamInfo* const pStreamInfo = &pBase->pInfo->streams[pStream->serverStream];
+    const StcFrameRecord* const pRecord = &pStreamInfo->frameRecords[copyIndex];
+    StcFrameReadTicks* const pReadTicks = &pStreamInfo->frameReadTicks[copyIndex];
+    const int64_t now = StcGetCurrentTicks();
+    pReadTicks->acquireTicks = now;
+    pReadTicks->releaseTicks = 0;
+
+    StcClientFrameStats* const pStats = &pStream->frameStats;
+    const uint64_t sequence = pRecord->sequence;
+    if ((pStream->frameSequence != 0) && (sequence > pStream->frameSequence + 1)) {
+        const uint64_t gap = sequence - pStream->frameSequence - 1;
+        pStats->framesDropped += gap;
+        ++pStats->dropEvents;
+        if (pStats->largestGap < gap) {
+            pStats->largestGap = gap;
+        }
+    }
+
+    pStream->frameSequence = sequence;
+    pStream->framesBehind = framesBehind;
+
+    const uint32_t bucket = (pStream->framesBehind < STC_FRAME_AGE_BUCKETS) ? pStream->framesBehind : (STC_FRAME_AGE_BUCKETS - 1);
+    ++pStats->ageHistogram[bucket];
+    ++pStats->framesAcquired;
+
+    const int64_t ageMicroseconds = TicksToMicroseconds(pBase, now - pRecord->publishTicks);
+    pStats->totalAgeMicroseconds += ageMicroseconds;
+    if (pStats->maxAgeMicroseconds < ageMicroseconds) {
+        pStats->maxAgeMicroseconds = ageMicroseconds;
+    }
+}
+
+// SignalRead may be called more than once for a repeated frame, only the first release counts
+static void ReleaseFrameRecord(StcClientBase* const pBase, const size_t stream) {
+    StcClientStream* const pStream = &pBase->streams[stream];
+    StcFrameReadTicks* const pReadTicks = &pBase->pInfo->streams[pStream->serverStream].frameReadTicks[pStream->copyIndex];
+    if (pReadTicks->releaseTicks == 0) {
+        pReadTicks->releaseTicks = StcGetCurrentTicks();
+        pStream->frameStats.totalHoldMicroseconds +=
+            TicksToMicroseconds(pBase, pReadTicks->releaseTicks - pReadTicks->acquireTicks);
+    }
+}
+
+// With resize generations a resize is reported once, with the first frame at the new size, however many slots are reopened
+// for it. Otherwise every reopened slot reports one.
+static bool TakeResize(StcClientBase* const pBase, const size_t stream, const size_t copyIndex, const bool reopened) {
+    bool resized = reopened;
+    if ((pBase->capabilities & STC_CAPABILITY_FLAG_RESIZE_GENERATIONS) != 0) {
+        StcClientStream* const pStream = &pBase->streams[stream];
+        const uint32_t generation = pBase->pInfo->streams[pStream->serverStream].frameRecords[copyIndex].resizeGeneration;
+        resized = generation != pStream->resizeGeneration;
+        pStream->resizeGeneration = generation;
+    }
+
+    return resized;
+}
+
+static int64_t GetFrameAgeMicroseconds(const StcClientBase* const pBase, const size_t stream, const size_t copyIndex) {
+    const StcFrameRecord* const pRecord = &pBase->pInfo->streams[pBase->streams[stream].serverStream].frameRecords[copyIndex];
+    return TicksToMicroseconds(pBase, StcGetCurrentTicks() - pRecord->publishTicks);
+}
+
+// Hands a slot the client no longer reads back to the server
+static void ReturnSlot(StcClientBase* const pBase, const size_t stream, const size_t index) {
+    StcAtomicUint32StoreRelease(&pBase->pInfo->streams[pBase->streams[stream].serverStream].slotStates[index], STC_SLOT_STATE_FREE);
+    StcEventSignal(&pBase->serverWake);
+}
+
+// A leased slot stays READING, which already keeps the server from writing or reclaiming it. The server hands out the
+// limit so that the leases of all its readers still leave it a slot to write, and holds back new readers while they don't.
+static StcClientStatus RetainFrame(StcClientBase* const pBase, const size_t stream, StcClientFrameLease* const pLease) {
+    StcClientStatus status = CheckStream(pBase, stream);
+
+    StcInfo* const pInfo = pBase->pInfo;
+    if (status == STC_CLIENT_STATUS_SUCCESS) {
+        StcClientStream* const pStream = &pBase->streams[stream];
+        const size_t copyIndex = pStream->copyIndex;
+        status = STC_CLIENT_STATUS_FAIL_NO_FRAME;
+        if (pStream->hasValidImage) {
+            status = STC_CLIENT_STATUS_SUCCESS;
+            if (!pStream->leased[copyIndex]) {
+                if (pStream->leaseCount < StcAtomicUint32Load(&pInfo->leaseLimit)) {
+                    pStream->leased[copyIndex] = true;
+                    ++pStream->leaseCount;
+                    StcAtomicUint32Store(&pInfo->streams[pStream->serverStream].leaseCount, (uint32_t)pStream->leaseCount);
+                } else {
+                    status = STC_CLIENT_STATUS_FAIL_LEASE_LIMIT;
+                }
+            }
+
+            if (status == STC_CLIENT_STATUS_SUCCESS) {
+                pLease->stream = stream;
+                pLease->index = copyIndex;
+                pLease->sequence = pStream->frameSequence;
+            }
+        }
+    }
+
+    return status;
+}
+
+// The record of a leased slot is left alone by the server, so its sequence tells a stale or repeated lease apart. The
+// slot goes back to the server once the client has also moved past it.
+static StcClientStatus EndLease(StcClientBase* const pBase, const StcClientFrameLease* const pLease, bool* const pReturn) {
+    StcClientStatus status = STC_CLIENT_STATUS_FAIL_NOT_CONNECTED;
+    *pReturn = false;
+
+    StcInfo* const pInfo = pBase->pInfo;
+    if (pInfo != NULL) {
+        status = STC_CLIENT_STATUS_FAIL_INVALID_LEASE;
+        if ((pLease->stream < pBase->streamCount) && (pLease->index < pBase->textureCount)) {
+            StcClientStream* const pStream = &pBase->streams[pLease->stream];
+            const StcFrameRecord* const pRecord = &pInfo->streams[pStream->serverStream].frameRecords[pLease->index];
+            if (pStream->leased[pLease->index] && (pRecord->sequence == pLease->sequence)) {
+                pStream->leased[pLease->index] = false;
+                --pStream->leaseCount;
+                StcAtomicUint32Store(&pInfo->streams[pStream->serverStream].leaseCount, (uint32_t)pStream->leaseCount);
+                *pReturn = (pLease->index != pStream->copyIndex) || !pStream->slotHeld;
+                status = STC_CLIENT_STATUS_SUCCESS;
+            }
+        }
+    }
+
+    return status;
+}
+
+// The server skips a paused connection, so the current frame goes back like any other the client moves past. The frames
+// missed on standby are not drops, hence the sequence starts over.
+static StcClientStatus SetStandby(StcClientBase* const pBase, const bool standby) {
+    StcClientStatus status = STC_CLIENT_STATUS_FAIL_NOT_CONNECTED;
+
+    if (pBase->pInfo != NULL) {
+        status = STC_CLIENT_STATUS_SUCCESS;
+        if (standby != pBase->standby) {
+            status = SendControl(pBase, standby ? STC_CONTROL_MESSAGE_TYPE_PAUSE : STC_CONTROL_MESSAGE_TYPE_RESUME, NULL, 0);
+        }
+
+        if ((status == STC_CLIENT_STATUS_SUCCESS) && (standby != pBase->standby)) {
+            pBase->standby = standby;
+            pBase->standbyRequestTicks = 0;
+            if (standby) {
+                for (size_t stream = 0; stream < pBase->streamCount; ++stream) {
+                    StcClientStream* const pStream = &pBase->streams[stream];
+                    if (pStream->slotHeld && !pStream->leased[pStream->copyIndex]) {
+                        ReturnSlot(pBase, stream, pStream->copyIndex);
+                    }
+                    pStream->hasValidImage = false;
+                    pStream->slotHeld = false;
+                    pStream->frameSequence = 0;
+                    pStream->framesBehind = 0;
+                }
+            } else {
+                // Also lifts the frame interval for the next frame, which the switch should not wait on
+                SendControl(pBase, STC_CONTROL_MESSAGE_TYPE_REQUEST_FRAME, NULL, 0);
+            }
+        }
+    }
+
+    return status;
+}
+
+// A FREE slot the server created or recreated since the client last opened it. The server only rewrites the flag while
+// the slot is WRITING, so a stale read at most asks for one frame too many.
+static bool HasUnopenedSlot(const StcClientBase* const pBase, const size_t stream) {
+    StcStreamInfo* const pInfo = &pBase->pInfo->streams[pBase->streams[stream].serverStream];
+    bool unopened = false;
+    for (size_t index = 0; !unopened && (index < pBase->textureCount); ++index) {
+        unopened = (StcAtomicUint32Load(&pInfo->slotStates[index]) == STC_SLOT_STATE_FREE) && pInfo->invalidated[index];
+    }
+
+    return unopened;
+}
+
+// Tick opens the slot of a frame sent on standby like any other, and the frame goes straight back
+static void ReturnStandbyFrame(StcClientBase* const pBase, const size_t stream) {
+    StcClientStream* const pStream = &pBase->streams[stream];
+    ReturnSlot(pBase, stream, pStream->copyIndex);
+    pStream->hasValidImage = false;
+    pStream->slotHeld = false;
+    pBase->standbyRequestTicks = 0;
+}
+
+// Frames are asked for one at a time until every slot is open. The server drops a request it cannot serve, e.g. when
+// another reader's mailbox takes the frame back, so one still outstanding after a keepalive interval is repeated.
+static void RequestStandbyFrame(StcClientBase* const pBase, const size_t stream) {
+    const int64_t now = StcGetCurrentTicks();
+    if (((pBase->standbyRequestTicks == 0) ||
+         ((now - pBase->standbyRequestTicks) >= (StcGetTimeoutTicks() / STC_KEEP_ALIVE_DIVISOR))) &&
+        HasUnopenedSlot(pBase, stream) &&
+        (SendControl(pBase, STC_CONTROL_MESSAGE_TYPE_REQUEST_FRAME, NULL, 0) == STC_CLIENT_STATUS_SUCCESS)) {
+        pBase->standbyRequestTicks = now;
+    }
+}
+
+// Slices finish in order, so a progress count past the requested slice means its rows are written. The last slice only
+// completes with the server's SignalWrite, once the whole frame is handed over.
+static StcClientStatus WaitForServerSlice(StcClientBase* const pBase, const size_t stream, const uint32_t slice,
+                                          const int64_t timeoutTicks) {
+    StcClientStatus status = CheckStream(pBase, stream);
+
+    StcInfo* const pInfo = pBase->pInfo;
+    if (status == STC_CLIENT_STATUS_SUCCESS) {
+        const StcClientStream* const pStream = &pBase->streams[stream];
+        StcAtomicUint32* const pProgress = &pInfo->streams[pStream->serverStream].sliceProgress[pStream->copyIndex];
+        const int64_t deadline = StcGetCurrentTicks() + timeoutTicks;
+
+        for (;;) {
+            const uint32_t token = StcEventGetToken(&pBase->clientWake);
+            if (StcAtomicUint32Load(pProgress) > slice) {
+                break;
+            }
+
+            const int64_t remaining = deadline - StcGetCurrentTicks();
+            const uint32_t remainingMs = (uint32_t)((remaining * 1000 + pBase->tickFrequency - 1) / pBase->tickFrequency);
+            if ((remaining <= 0) || !StcEventWait(&pBase->clientWake, token, remainingMs)) {
+                status = STC_CLIENT_STATUS_FAIL_WAIT_TIMEOUT;
+                break;
+            }
+        }
+    }
+
+    return status;
+}
+
+#ifdef _WIN32
+static StcClientStatus StcClientD3D11ConnectionTick(StcClientD3D11* const pClient) {
+    StcClientBase* const pBase = &pClient->base;
+    StcClientStopReason reason = STC_CLIENT_STOP_REASON_NONE;
+    StcClientStatus status = TickClient(pBase, &reason);
+    if (reason != STC_CLIENT_STOP_REASON_NONE) {
+        StcClientD3D11Disconnect(pClient, reason);
+        status = STC_CLIENT_STATUS_FAIL_DISCONNECTED;
+    }
+
+    return status;
+}
+
+static StcClientStatus StcClientD3D12ConnectionTick(StcClientD3D12* const pClient) {
+    StcClientBase* const pBase = &pClient->base;
+    StcClientStopReason reason = STC_CLIENT_STOP_REASON_NONE;
+    StcClientStatus status = TickClient(pBase, &reason);
     if (reason != STC_CLIENT_STOP_REASON_NONE) {
         StcClientD3D12Disconnect(pClient, reason);
         status = STC_CLIENT_STATUS_FAIL_DISCONNECTED;
@@ -599,30 +1556,44 @@ StcClientStatus StcClientD3D11Tick(StcClientD3D11* const pClient, StcClientD3D11
         StcClientBase* const pBase = &pClient->base;
         const StcMessageCallbacks* const pMessenger = &pBase->messenger;
         StcInfo* const pInfo = pBase->pInfo;
-        StcAtomicInt64Store(&pInfo->clientKeepAlive, StcGetCurrentTicks());
 
         pNextInfo->pTexture = NULL;
-        pNextInfo->index = STC_TEXTURE_COUNT;
+        pNextInfo->index = STC_MAX_TEXTURE_COUNT;
         pNextInfo->resized = false;
+        pNextInfo->sequence = 0;
+        pNextInfo->framesBehind = 0;
+        pNextInfo->ageMicroseconds = 0;
 
         if (StcAtomicBoolLoad(&pInfo->serverInitialized)) {
-            uint32_t pendingReads = StcAtomicUint32Load(&pInfo->pendingReads);
-            bool needCopy = pendingReads > 0;
-            size_t copyIndex = pBase->copyIndex;
-            if (needCopy) {
-                copyIndex = (copyIndex + 1) % STC_TEXTURE_COUNT;
-                StcAtomicUint32Decrement(&pInfo->pendingReads);
+            size_t copyIndex = pBase->streams[0].copyIndex;
+            uint32_t framesBehind;
+            if (ClaimReadySlot(pBase, 0, &copyIndex, &framesBehind)) {
+                if (!pBase->standby) {
+                    AcquireFrameRecord(pBase, 0, copyIndex, framesBehind);
+                }
 
-                StcAtomicUint32Increment(&pInfo->pendingWrites);
-                pBase->hasValidImage = true;
+                // A lease released while its frame was current may still hold the key, which the server needs back
+                const size_t previousIndex = pBase->streams[0].copyIndex;
+                if (!pBase->streams[0].leased[previousIndex]) {
+                    if (pClient->keyHeld[previousIndex]) {
+                        IDXGIKeyedMutex_ReleaseSync(pClient->pKeyedMutexes[previousIndex], STC_KEY_CLIENT);
+                        pClient->keyHeld[previousIndex] = false;
+                    }
 
-                pBase->copyIndex = copyIndex;
+                    if (pBase->streams[0].slotHeld) {
+                        ReturnSlot(pBase, 0, previousIndex);
+                    }
+                }
+                pBase->streams[0].hasValidImage = true;
+                pBase->streams[0].slotHeld = true;
+
+                pBase->streams[0].copyIndex = copyIndex;
             }
 
-            if (pBase->hasValidImage) {
+            if (pBase->streams[0].hasValidImage) {
                 StcClientStopReason reason = STC_CLIENT_STOP_REASON_NONE;
 
-                if (pInfo->invalidated[copyIndex]) {
+                if (pInfo->streams[0].invalidated[copyIndex]) {
                     StcLogMessage(pMessenger, STC_MESSAGE_ID_CLIENT_D3D11_OPEN_FRAME_ATTEMPT, (int)copyIndex);
 
                     ResourceFrameD3D11 frame;
@@ -638,7 +1609,7 @@ StcClientStatus StcClientD3D11Tick(StcClientD3D11* const pClient, StcClientD3D11
 
                         pClient->pTextures[copyIndex] = frame.pTexture;
                         pClient->pKeyedMutexes[copyIndex] = frame.pKeyedMutex;
-                        pInfo->invalidated[copyIndex] = false;
+                        pInfo->streams[0].invalidated[copyIndex] = false;
                         pNextInfo->resized = true;
 
                         if (pClient->allocator.pfnCreate(pClient->allocator.pUserData, copyIndex, frame.pTexture)) {
@@ -650,15 +1621,25 @@ StcClientStatus StcClientD3D11Tick(StcClientD3D11* const pClient, StcClientD3D11
                     }
                 }
 
-                if (reason == STC_CLIENT_STOP_REASON_NONE) {
+                if ((reason == STC_CLIENT_STOP_REASON_NONE) && pBase->standby) {
+                    ReturnStandbyFrame(pBase, 0);
+                } else if (reason == STC_CLIENT_STOP_REASON_NONE) {
                     pNextInfo->pTexture = pClient->pTextures[copyIndex];
                     pNextInfo->index = copyIndex;
+                    pNextInfo->resized = TakeResize(pBase, 0, copyIndex, pNextInfo->resized);
+                    pNextInfo->sequence = pBase->streams[0].frameSequence;
+                    pNextInfo->framesBehind = pBase->streams[0].framesBehind;
+                    pNextInfo->ageMicroseconds = GetFrameAgeMicroseconds(pBase, 0, copyIndex);
                 } else {
                     StcClientD3D11Disconnect(pClient, reason);
                     status = STC_CLIENT_STATUS_FAIL_TICK;
                 }
             }
         }
+
+        if ((status == STC_CLIENT_STATUS_SUCCESS) && pBase->standby) {
+            RequestStandbyFrame(pBase, 0);
+        }
     }
 
     return status;
@@ -670,29 +1651,36 @@ StcClientStatus StcClientD3D12Tick(StcClientD3D12* const pClient, StcClientD3D12
         StcClientBase* const pBase = &pClient->base;
         const StcMessageCallbacks* const pMessenger = &pBase->messenger;
         StcInfo* const pInfo = pBase->pInfo;
-        StcAtomicInt64Store(&pInfo->clientKeepAlive, StcGetCurrentTicks());
 
         pNextInfo->pTexture = NULL;
         pNextInfo->resized = false;
+        pNextInfo->sequence = 0;
+        pNextInfo->framesBehind = 0;
+        pNextInfo->ageMicroseconds = 0;
+        pNextInfo->sliceCount = 1;
+        pNextInfo->sliceHeight = 0;
 
         if (StcAtomicBoolLoad(&pInfo->serverInitialized)) {
-            uint32_t pendingReads = StcAtomicUint32Load(&pInfo->pendingReads);
-            bool needCopy = pendingReads > 0;
-            size_t copyIndex = pBase->copyIndex;
-            if (needCopy) {
-                copyIndex = (copyIndex + 1) % STC_TEXTURE_COUNT;
-                StcAtomicUint32Decrement(&pInfo->pendingReads);
+            size_t copyIndex = pBase->streams[0].copyIndex;
+            uint32_t framesBehind;
+            if (ClaimReadySlot(pBase, 0, &copyIndex, &framesBehind)) {
+                if (!pBase->standby) {
+                    AcquireFrameRecord(pBase, 0, copyIndex, framesBehind);
+                }
 
-                StcAtomicUint32Increment(&pInfo->pendingWrites);
-                pBase->hasValidImage = true;
+                if (pBase->streams[0].slotHeld && !pBase->streams[0].leased[pBase->streams[0].copyIndex]) {
+                    ReturnSlot(pBase, 0, pBase->streams[0].copyIndex);
+                }
+                pBase->streams[0].hasValidImage = true;
+                pBase->streams[0].slotHeld = true;
 
-                pBase->copyIndex = copyIndex;
+                pBase->streams[0].copyIndex = copyIndex;
             }
 
-            if (pBase->hasValidImage) {
+            if (pBase->streams[0].hasValidImage) {
                 StcClientStopReason reason = STC_CLIENT_STOP_REASON_NONE;
 
-                if (pInfo->invalidated[copyIndex]) {
+                if (pInfo->streams[0].invalidated[copyIndex]) {
                     StcLogMessage(pMessenger, STC_MESSAGE_ID_CLIENT_D3D12_OPEN_FRAME_ATTEMPT, (int)copyIndex);
 
                     ResourceFrameD3D12 frame;
@@ -701,8 +1689,8 @@ StcClientStatus StcClientD3D12Tick(StcClientD3D12* const pClient, StcClientD3D12
                     if (reason == STC_CLIENT_STOP_REASON_NONE) {
                         if (pClient->pTextures[copyIndex]) {
                             const HANDLE hFenceClearedAutoEvent = pClient->hFenceClearedAutoEvent;
-                            ID3D12Fence_SetEventOnCompletion(pClient->pReadFences[copyIndex], pInfo->readFenceValues12[copyIndex],
-                                                             hFenceClearedAutoEvent);
+                            const UINT64 fenceValue = pInfo->streams[0].readFenceValues12[copyIndex];
+                            ID3D12Fence_SetEventOnCompletion(pClient->pReadFences[copyIndex], fenceValue, hFenceClearedAutoEvent);
                             WaitForSingleObject(hFenceClearedAutoEvent, INFINITE);
 
                             pClient->allocator.pfnDestroy(pClient->allocator.pUserData, copyIndex);
@@ -715,7 +1703,9 @@ StcClientStatus StcClientD3D12Tick(StcClientD3D12* const pClient, StcClientD3D12
                         pClient->pTextures[copyIndex] = frame.pTexture;
                         pClient->pWriteFences[copyIndex] = frame.pWriteFence;
                         pClient->pReadFences[copyIndex] = frame.pReadFence;
-                        pInfo->invalidated[copyIndex] = false;
+                        // A new write fence counts from 0 again
+                        pClient->writeFenceCleared[copyIndex] = 0;
+                        pInfo->streams[0].invalidated[copyIndex] = false;
                         pNextInfo->resized = true;
 
                         if (pClient->allocator.pfnCreate(pClient->allocator.pUserData, copyIndex, frame.pTexture)) {
@@ -727,15 +1717,29 @@ StcClientStatus StcClientD3D12Tick(StcClientD3D12* const pClient, StcClientD3D12
                     }
                 }
 
-                if (reason == STC_CLIENT_STOP_REASON_NONE) {
+                if ((reason == STC_CLIENT_STOP_REASON_NONE) && pBase->standby) {
+                    ReturnStandbyFrame(pBase, 0);
+                } else if (reason == STC_CLIENT_STOP_REASON_NONE) {
                     pNextInfo->pTexture = pClient->pTextures[copyIndex];
                     pNextInfo->index = copyIndex;
+                    pNextInfo->resized = TakeResize(pBase, 0, copyIndex, pNextInfo->resized);
+                    pNextInfo->sequence = pBase->streams[0].frameSequence;
+                    pNextInfo->framesBehind = pBase->streams[0].framesBehind;
+                    pNextInfo->ageMicroseconds = GetFrameAgeMicroseconds(pBase, 0, copyIndex);
+
+                    const uint32_t sliceCount = pInfo->streams[0].frameRecords[copyIndex].sliceCount;
+                    pNextInfo->sliceCount = (sliceCount > 0) ? sliceCount : 1;
+                    pNextInfo->sliceHeight = pInfo->streams[0].sliceHeights[copyIndex];
                 } else {
                     StcClientD3D12Disconnect(pClient, reason);
                     status = STC_CLIENT_STATUS_FAIL_TICK;
                 }
             }
         }
+
+        if ((status == STC_CLIENT_STATUS_SUCCESS) && pBase->standby) {
+            RequestStandbyFrame(pBase, 0);
+        }
     }
 
     return status;
@@ -744,23 +1748,24 @@ StcClientStatus StcClientD3D12Tick(StcClientD3D12* const pClient, StcClientD3D12
 StcClientStatus StcClientD3D11WaitForServerWrite(StcClientD3D11* const pClient) {
     StcClientStatus status = STC_CLIENT_STATUS_SUCCESS;
 
-    const StcClientBase* const pBase = &pClient->base;
-    const HRESULT hr = IDXGIKeyedMutex_AcquireSync(pClient->pKeyedMutexes[pBase->copyIndex], STC_KEY_CLIENT, 0);
-    if (FAILED(hr) || (hr == WAIT_ABANDONED) || (hr == WAIT_TIMEOUT)) {
-        StcClientD3D11Disconnect(pClient, STC_CLIENT_STOP_REASON_FAIL_D3D11_ACQUIRE_SYNC);
-        status = STC_CLIENT_STATUS_FAIL_WAIT_SERVER_WRITE;
+    // A lease on the frame may already hold the key
+    const size_t copyIndex = pClient->base.streams[0].copyIndex;
+    if (!pClient->keyHeld[copyIndex]) {
+        const HRESULT hr = IDXGIKeyedMutex_AcquireSync(pClient->pKeyedMutexes[copyIndex], STC_KEY_CLIENT, 0);
+        if (FAILED(hr) || (hr == WAIT_ABANDONED) || (hr == WAIT_TIMEOUT)) {
+            StcClientD3D11Disconnect(pClient, STC_CLIENT_STOP_REASON_FAIL_D3D11_ACQUIRE_SYNC);
+            status = STC_CLIENT_STATUS_FAIL_WAIT_SERVER_WRITE;
+        } else {
+            pClient->keyHeld[copyIndex] = true;
+        }
     }
 
     return status;
 }
 
-StcClientStatus StcClientD3D12WaitForServerWrite(StcClientD3D12* const pClient, ID3D12CommandQueue* const pQueue) {
+static StcClientStatus WaitForD3D12WriteFence(StcClientD3D12* const pClient, ID3D12CommandQueue* const pQueue,
+                                             const size_t copyIndex, const UINT64 writeFenceValue) {
     StcClientStatus status = STC_CLIENT_STATUS_SUCCESS;
-
-    StcClientBase* const pBase = &pClient->base;
-    StcInfo* const pInfo = pBase->pInfo;
-    const size_t copyIndex = pBase->copyIndex;
-    const UINT64 writeFenceValue = pInfo->writeFenceValues12[copyIndex];
     if (pClient->writeFenceCleared[copyIndex] < writeFenceValue) {
         if (SUCCEEDED(ID3D12CommandQueue_Wait(pQueue, pClient->pWriteFences[copyIndex], writeFenceValue))) {
             pClient->writeFenceCleared[copyIndex] = writeFenceValue;
@@ -773,13 +1778,49 @@ StcClientStatus StcClientD3D12WaitForServerWrite(StcClientD3D12* const pClient,
     return status;
 }
 
+StcClientStatus StcClientD3D12WaitForServerWrite(StcClientD3D12* const pClient, ID3D12CommandQueue* const pQueue) {
+    StcClientBase* const pBase = &pClient->base;
+    const StcStreamInfo* const pStreamInfo = &pBase->pInfo->streams[0];
+    const size_t copyIndex = pBase->streams[0].copyIndex;
+
+    // A sliced frame is handed out before the server queues its final signal, which the queue should not wait on ahead of
+    // time. A timeout here leaves the wait to the queue.
+    const uint32_t sliceCount = pStreamInfo->frameRecords[copyIndex].sliceCount;
+    if (sliceCount > 1) {
+        WaitForServerSlice(pBase, 0, sliceCount - 1, StcGetTimeoutTicks());
+    }
+
+    return WaitForD3D12WriteFence(pClient, pQueue, copyIndex, pStreamInfo->writeFenceValues12[copyIndex]);
+}
+
+// writeFenceValues12 holds the value the whole frame finishes at, and each slice before the last one signals one less
+StcClientStatus StcClientD3D12WaitForServerSlice(StcClientD3D12* const pClient, ID3D12CommandQueue* const pQueue,
+                                                 const uint32_t slice, const uint32_t timeoutMs) {
+    StcClientBase* const pBase = &pClient->base;
+    StcClientStatus status = WaitForServerSlice(pBase, 0, slice, ((int64_t)timeoutMs * pBase->tickFrequency) / 1000);
+    if (status == STC_CLIENT_STATUS_SUCCESS) {
+        const StcStreamInfo* const pStreamInfo = &pBase->pInfo->streams[0];
+        const size_t copyIndex = pBase->streams[0].copyIndex;
+        const uint32_t sliceCount = pStreamInfo->frameRecords[copyIndex].sliceCount;
+        const UINT64 writeFenceValue = pStreamInfo->writeFenceValues12[copyIndex] - sliceCount + slice + 1;
+        status = WaitForD3D12WriteFence(pClient, pQueue, copyIndex, writeFenceValue);
+    }
+
+    return status;
+}
+
 StcClientStatus StcClientD3D11SignalRead(StcClientD3D11* const pClient) {
     StcClientStatus status = STC_CLIENT_STATUS_SUCCESS;
 
-    const StcClientBase* const pBase = &pClient->base;
-    if (FAILED(IDXGIKeyedMutex_ReleaseSync(pClient->pKeyedMutexes[pBase->copyIndex], STC_KEY_CLIENT))) {
-        StcClientD3D11Disconnect(pClient, STC_CLIENT_STOP_REASON_FAIL_D3D11_RELEASE_SYNC);
-        status = STC_CLIENT_STATUS_FAIL_SIGNAL_READ;
+    StcClientBase* const pBase = &pClient->base;
+    const size_t copyIndex = pBase->streams[0].copyIndex;
+    ReleaseFrameRecord(pBase, 0);
+    if (!pBase->streams[0].leased[copyIndex]) {
+        pClient->keyHeld[copyIndex] = false;
+        if (FAILED(IDXGIKeyedMutex_ReleaseSync(pClient->pKeyedMutexes[copyIndex], STC_KEY_CLIENT))) {
+            StcClientD3D11Disconnect(pClient, STC_CLIENT_STOP_REASON_FAIL_D3D11_RELEASE_SYNC);
+            status = STC_CLIENT_STATUS_FAIL_SIGNAL_READ;
+        }
     }
 
     return status;
@@ -788,12 +1829,13 @@ StcClientStatus StcClientD3D11SignalRead(StcClientD3D11* const pClient) {
 StcClientStatus StcClientD3D12SignalRead(StcClientD3D12* const pClient, ID3D12CommandQueue* const pQueue) {
     StcClientStatus status = STC_CLIENT_STATUS_SUCCESS;
 
-    const StcClientBase* const pBase = &pClient->base;
+    StcClientBase* const pBase = &pClient->base;
     StcInfo* const pInfo = pBase->pInfo;
-    const size_t copyIndex = pBase->copyIndex;
-    UINT64 nextFenceValue = pInfo->readFenceValues12[copyIndex] + 1;
+    const size_t copyIndex = pBase->streams[0].copyIndex;
+    ReleaseFrameRecord(pBase, 0);
+    UINT64 nextFenceValue = pInfo->streams[0].readFenceValues12[copyIndex] + 1;
     if (SUCCEEDED(ID3D12CommandQueue_Signal(pQueue, pClient->pReadFences[copyIndex], nextFenceValue))) {
-        pInfo->readFenceValues12[copyIndex] = nextFenceValue;
+        pInfo->streams[0].readFenceValues12[copyIndex] = nextFenceValue;
     } else {
         StcClientD3D12Disconnect(pClient, STC_CLIENT_STOP_REASON_FAIL_D3D12_QUEUE_SIGNAL);
         status = STC_CLIENT_STATUS_FAIL_SIGNAL_READ;
@@ -801,3 +1843,423 @@ StcClientStatus StcClientD3D12SignalRead(StcClientD3D12* const pClient, ID3D12Co
 
     return status;
 }
+
+StcClientStatus StcClientD3D11RetainFrame(StcClientD3D11* const pClient, StcClientFrameLease* const pLease) {
+    StcClientBase* const pBase = &pClient->base;
+    const size_t copyIndex = pBase->streams[0].copyIndex;
+    StcClientStatus status = RetainFrame(pBase, 0, pLease);
+    if ((status == STC_CLIENT_STATUS_SUCCESS) && !pClient->keyHeld[copyIndex]) {
+        const HRESULT hr = IDXGIKeyedMutex_AcquireSync(pClient->pKeyedMutexes[copyIndex], STC_KEY_CLIENT, 0);
+        if (FAILED(hr) || (hr == WAIT_ABANDONED) || (hr == WAIT_TIMEOUT)) {
+            StcClientD3D11Disconnect(pClient, STC_CLIENT_STOP_REASON_FAIL_D3D11_ACQUIRE_SYNC);
+            status = STC_CLIENT_STATUS_FAIL_WAIT_SERVER_WRITE;
+        } else {
+            pClient->keyHeld[copyIndex] = true;
+        }
+    }
+
+    return status;
+}
+
+StcClientStatus StcClientD3D12RetainFrame(StcClientD3D12* const pClient, StcClientFrameLease* const pLease) {
+    return RetainFrame(&pClient->base, 0, pLease);
+}
+
+// The key of the current frame is left to SignalRead or the next Tick, since the caller may still be reading it
+StcClientStatus StcClientD3D11ReleaseFrame(StcClientD3D11* const pClient, const StcClientFrameLease* const pLease) {
+    StcClientBase* const pBase = &pClient->base;
+    bool returnSlot;
+    StcClientStatus status = EndLease(pBase, pLease, &returnSlot);
+    if (returnSlot) {
+        if (pClient->keyHeld[pLease->index]) {
+            pClient->keyHeld[pLease->index] = false;
+            if (FAILED(IDXGIKeyedMutex_ReleaseSync(pClient->pKeyedMutexes[pLease->index], STC_KEY_CLIENT))) {
+                StcClientD3D11Disconnect(pClient, STC_CLIENT_STOP_REASON_FAIL_D3D11_RELEASE_SYNC);
+                status = STC_CLIENT_STATUS_FAIL_SIGNAL_READ;
+            }
+        }
+
+        if (status == STC_CLIENT_STATUS_SUCCESS) {
+            ReturnSlot(pBase, 0, pLease->index);
+        }
+    }
+
+    return status;
+}
+
+// Signalled even for the current frame, work submitted after its SignalRead would otherwise not be waited on
+StcClientStatus StcClientD3D12ReleaseFrame(StcClientD3D12* const pClient, ID3D12CommandQueue* const pQueue,
+                                           const StcClientFrameLease* const pLease) {
+    StcClientBase* const pBase = &pClient->base;
+    bool returnSlot;
+    StcClientStatus status = EndLease(pBase, pLease, &returnSlot);
+    if (status == STC_CLIENT_STATUS_SUCCESS) {
+        StcInfo* const pInfo = pBase->pInfo;
+        const UINT64 nextFenceValue = pInfo->streams[0].readFenceValues12[pLease->index] + 1;
+        if (SUCCEEDED(ID3D12CommandQueue_Signal(pQueue, pClient->pReadFences[pLease->index], nextFenceValue))) {
+            pInfo->streams[0].readFenceValues12[pLease->index] = nextFenceValue;
+            if (returnSlot) {
+                ReturnSlot(pBase, 0, pLease->index);
+            }
+        } else {
+            StcClientD3D12Disconnect(pClient, STC_CLIENT_STOP_REASON_FAIL_D3D12_QUEUE_SIGNAL);
+            status = STC_CLIENT_STATUS_FAIL_SIGNAL_READ;
+        }
+    }
+
+    return status;
+}
+
+StcClientStatus StcClientD3D11Wait(StcClientD3D11* const pClient, const uint32_t timeoutMs) {
+    return StcClientWait(&pClient->base, timeoutMs);
+}
+
+StcClientStatus StcClientD3D12Wait(StcClientD3D12* const pClient, const uint32_t timeoutMs) {
+    return StcClientWait(&pClient->base, timeoutMs);
+}
+
+HANDLE StcClientD3D11GetWaitHandle(StcClientD3D11* const pClient) { return pClient->base.clientWake.hEvent; }
+
+HANDLE StcClientD3D12GetWaitHandle(StcClientD3D12* const pClient) { return pClient->base.clientWake.hEvent; }
+
+void StcClientD3D11SetFrameInterval(StcClientD3D11* const pClient, const uint32_t intervalMicroseconds) {
+    SetFrameInterval(&pClient->base, intervalMicroseconds);
+}
+
+void StcClientD3D12SetFrameInterval(StcClientD3D12* const pClient, const uint32_t intervalMicroseconds) {
+    SetFrameInterval(&pClient->base, intervalMicroseconds);
+}
+
+StcClientStatus StcClientD3D11ReadFrameMetadata(const StcClientD3D11* const pClient, void* const pData, const size_t capacity,
+                                                size_t* const pSize) {
+    return ReadFrameMetadata(&pClient->base, 0, pData, capacity, pSize);
+}
+
+StcClientStatus StcClientD3D12ReadFrameMetadata(const StcClientD3D12* const pClient, void* const pData, const size_t capacity,
+                                                size_t* const pSize) {
+    return ReadFrameMetadata(&pClient->base, 0, pData, capacity, pSize);
+}
+
+StcClientStatus StcClientD3D11UpdateParameters(StcClientD3D11* const pClient, const StcBindFlags bindFlags,
+                                               const StcSrgbChannelType srgbChannelType) {
+    return UpdateParameters(&pClient->base, bindFlags, srgbChannelType);
+}
+
+StcClientStatus StcClientD3D12UpdateParameters(StcClientD3D12* const pClient, const StcBindFlags bindFlags,
+                                               const StcSrgbChannelType srgbChannelType) {
+    return UpdateParameters(&pClient->base, bindFlags, srgbChannelType);
+}
+
+StcClientStatus StcClientD3D11SendControl(StcClientD3D11* const pClient, const uint32_t type, const void* const pData,
+                                          const size_t size) {
+    return SendControl(&pClient->base, type, pData, size);
+}
+
+StcClientStatus StcClientD3D12SendControl(StcClientD3D12* const pClient, const uint32_t type, const void* const pData,
+                                          const size_t size) {
+    return SendControl(&pClient->base, type, pData, size);
+}
+
+StcClientStatus StcClientD3D11SetStandby(StcClientD3D11* const pClient, const bool standby) {
+    StcClientStatus status = STC_CLIENT_STATUS_SUCCESS;
+
+    // The server takes the key back with the slot, so the current frame's key goes first
+    StcClientBase* const pBase = &pClient->base;
+    const size_t copyIndex = pBase->streams[0].copyIndex;
+    if (standby && (pBase->pInfo != NULL) && ((pBase->capabilities & STC_CAPABILITY_FLAG_CONTROL) != 0) &&
+        pClient->keyHeld[copyIndex] && !pBase->streams[0].leased[copyIndex]) {
+        pClient->keyHeld[copyIndex] = false;
+        if (FAILED(IDXGIKeyedMutex_ReleaseSync(pClient->pKeyedMutexes[copyIndex], STC_KEY_CLIENT))) {
+            StcClientD3D11Disconnect(pClient, STC_CLIENT_STOP_REASON_FAIL_D3D11_RELEASE_SYNC);
+            status = STC_CLIENT_STATUS_FAIL_SIGNAL_READ;
+        }
+    }
+
+    if (status == STC_CLIENT_STATUS_SUCCESS) {
+        status = SetStandby(pBase, standby);
+    }
+
+    return status;
+}
+
+StcClientStatus StcClientD3D12SetStandby(StcClientD3D12* const pClient, const bool standby) {
+    return SetStandby(&pClient->base, standby);
+}
+
+StcClientStatus StcClientD3D11ReadAuxRecord(StcClientD3D11* const pClient, StcAuxRecord* const pRecord, void* const pData,
+                                            const size_t capacity) {
+    return ReadAuxRecord(&pClient->base, pRecord, pData, capacity);
+}
+
+StcClientStatus StcClientD3D12ReadAuxRecord(StcClientD3D12* const pClient, StcAuxRecord* const pRecord, void* const pData,
+                                            const size_t capacity) {
+    return ReadAuxRecord(&pClient->base, pRecord, pData, capacity);
+}
+
+void StcClientD3D11GetFrameStats(const StcClientD3D11* const pClient, StcClientFrameStats* const pStats) {
+    *pStats = pClient->base.streams[0].frameStats;
+}
+
+void StcClientD3D12GetFrameStats(const StcClientD3D12* const pClient, StcClientFrameStats* const pStats) {
+    *pStats = pClient->base.streams[0].frameStats;
+}
+
+void StcClientD3D11ResetFrameStats(StcClientD3D11* const pClient) { ResetFrameStats(&pClient->base); }
+
+void StcClientD3D12ResetFrameStats(StcClientD3D12* const pClient) { ResetFrameStats(&pClient->base); }
+#endif
+
+static StcClientStatus StcClientCpuConnectionTick(StcClientCpu* const pClient) {
+    StcClientBase* const pBase = &pClient->base;
+    StcClientStopReason reason = STC_CLIENT_STOP_REASON_NONE;
+    StcClientStatus status = TickClient(pBase, &reason);
+    if (reason != STC_CLIENT_STOP_REASON_NONE) {
+        StcClientCpuDisconnect(pClient, reason);
+        status = STC_CLIENT_STATUS_FAIL_DISCONNECTED;
+    }
+
+    return status;
+}
+
+StcClientStatus StcClientCpuTickStream(StcClientCpu* const pClient, const size_t stream, StcClientCpuNextInfo* const pNextInfo) {
+    StcClientStatus status = StcClientCpuConnectionTick(pClient);
+    if ((status == STC_CLIENT_STATUS_SUCCESS) && (stream >= pClient->base.streamCount)) {
+        status = STC_CLIENT_STATUS_FAIL_INVALID_STREAM;
+    }
+
+    if (status == STC_CLIENT_STATUS_SUCCESS) {
+        StcClientBase* const pBase = &pClient->base;
+        const StcMessageCallbacks* const pMessenger = &pBase->messenger;
+        StcInfo* const pInfo = pBase->pInfo;
+        StcClientStream* const pStream = &pBase->streams[stream];
+        StcStreamInfo* const pStreamInfo = &pInfo->streams[pStream->serverStream];
+        StcClientCpuStream* const pCpuStream = &pClient->streams[stream];
+
+        pNextInfo->pData = NULL;
+        pNextInfo->index = STC_MAX_TEXTURE_COUNT;
+        pNextInfo->resized = false;
+        pNextInfo->sequence = 0;
+        pNextInfo->framesBehind = 0;
+        pNextInfo->ageMicroseconds = 0;
+        pNextInfo->sliceCount = 1;
+        pNextInfo->sliceHeight = 0;
+
+        if (StcAtomicBoolLoad(&pInfo->serverInitialized)) {
+            size_t copyIndex = pStream->copyIndex;
+            uint32_t framesBehind;
+            if (ClaimReadySlot(pBase, stream, &copyIndex, &framesBehind)) {
+                if (!pBase->standby) {
+                    AcquireFrameRecord(pBase, stream, copyIndex, framesBehind);
+                }
+
+                if (pStream->slotHeld && !pStream->leased[pStream->copyIndex]) {
+                    ReturnSlot(pBase, stream, pStream->copyIndex);
+                }
+                pStream->hasValidImage = true;
+                pStream->slotHeld = true;
+
+                pStream->copyIndex = copyIndex;
+            }
+
+            if (pStream->hasValidImage) {
+                StcClientStopReason reason = STC_CLIENT_STOP_REASON_NONE;
+
+                if (pStreamInfo->invalidated[copyIndex]) {
+                    StcLogMessage(pMessenger, STC_MESSAGE_ID_CLIENT_CPU_OPEN_FRAME_ATTEMPT, (int)copyIndex);
+
+                    ResourceFrameCpu frame;
+                    reason = OpenCpuResourceFrame(pClient, stream, &frame, copyIndex);
+
+                    if (reason == STC_CLIENT_STOP_REASON_NONE) {
+                        if (pCpuStream->pFrameHeaders[copyIndex]) {
+                            pClient->allocator.pfnDestroy(pClient->allocator.pUserData, stream * STC_MAX_TEXTURE_COUNT + copyIndex);
+
+                            StcMappingClose(&pCpuStream->frameMappings[copyIndex]);
+                        }
+
+                        pCpuStream->frameMappings[copyIndex] = frame.mapping;
+                        pCpuStream->pFrameHeaders[copyIndex] = frame.pHeader;
+                        pStreamInfo->invalidated[copyIndex] = false;
+                        pNextInfo->resized = true;
+
+                        if (pClient->allocator.pfnCreate(pClient->allocator.pUserData, stream * STC_MAX_TEXTURE_COUNT + copyIndex,
+                                                         (char*)frame.pHeader + STC_CPU_DATA_OFFSET, frame.pHeader->rowPitch)) {
+                            StcLogMessage(pMessenger, STC_MESSAGE_ID_CLIENT_CPU_OPEN_FRAME_SUCCESS, (int)copyIndex);
+                        } else {
+                            StcLogMessage(pMessenger, STC_MESSAGE_ID_CLIENT_FAIL_CPU_USER_OPEN_FRAME_CALLBACK, (int)copyIndex);
+                            reason = STC_CLIENT_STOP_REASON_FAIL_CPU_USER_OPEN_FRAME_CALLBACK;
+                        }
+                    }
+                }
+
+                if ((reason == STC_CLIENT_STOP_REASON_NONE) && pBase->standby) {
+                    ReturnStandbyFrame(pBase, stream);
+                } else if (reason == STC_CLIENT_STOP_REASON_NONE) {
+                    const StcCpuFrameHeader* const pHeader = pCpuStream->pFrameHeaders[copyIndex];
+                    pNextInfo->pData = (const char*)pHeader + STC_CPU_DATA_OFFSET;
+                    pNextInfo->rowPitch = pHeader->rowPitch;
+                    pNextInfo->width = pHeader->width;
+                    pNextInfo->height = pHeader->height;
+                    pNextInfo->format = pHeader->format;
+                    pNextInfo->index = copyIndex;
+                    pNextInfo->resized = TakeResize(pBase, stream, copyIndex, pNextInfo->resized);
+                    pNextInfo->sequence = pStream->frameSequence;
+                    pNextInfo->framesBehind = pStream->framesBehind;
+                    pNextInfo->ageMicroseconds = GetFrameAgeMicroseconds(pBase, stream, copyIndex);
+
+                    const uint32_t sliceCount = pStreamInfo->frameRecords[copyIndex].sliceCount;
+                    pNextInfo->sliceCount = (sliceCount > 0) ? sliceCount : 1;
+                    pNextInfo->sliceHeight = StcComputeSliceHeight(pHeader->height, pNextInfo->sliceCount);
+                } else {
+                    StcClientCpuDisconnect(pClient, reason);
+                    status = STC_CLIENT_STATUS_FAIL_TICK;
+                }
+            }
+        }
+
+        if ((status == STC_CLIENT_STATUS_SUCCESS) && pBase->standby) {
+            RequestStandbyFrame(pBase, stream);
+        }
+    }
+
+    return status;
+}
+
+StcClientStatus StcClientCpuTick(StcClientCpu* const pClient, StcClientCpuNextInfo* const pNextInfo) {
+    return StcClientCpuTickStream(pClient, 0, pNextInfo);
+}
+
+StcClientStatus StcClientCpuWaitForServerWriteStream(StcClientCpu* const pClient, const size_t stream) {
+    StcClientBase* const pBase = &pClient->base;
+    StcClientStatus status = CheckStream(pBase, stream);
+    if (status == STC_CLIENT_STATUS_SUCCESS) {
+        const size_t copyIndex = pBase->streams[stream].copyIndex;
+
+        // A sliced frame is handed out before the server finishes it. A timeout here falls through to the key check below.
+        const uint32_t sliceCount = pBase->pInfo->streams[pBase->streams[stream].serverStream].frameRecords[copyIndex].sliceCount;
+        if (sliceCount > 1) {
+            WaitForServerSlice(pBase, stream, sliceCount - 1, StcGetTimeoutTicks());
+        }
+
+        // Other clients may be reading the same frame, so the key is only checked rather than taken
+        uint32_t key;
+        if (!StcCpuKeyCheck(&pClient->streams[stream].pFrameHeaders[copyIndex]->key, STC_KEY_CLIENT, &key)) {
+            StcClientCpuDisconnect(pClient, STC_CLIENT_STOP_REASON_FAIL_CPU_ACQUIRE_SYNC);
+            status = STC_CLIENT_STATUS_FAIL_WAIT_SERVER_WRITE;
+        }
+    }
+
+    return status;
+}
+
+StcClientStatus StcClientCpuWaitForServerWrite(StcClientCpu* const pClient) {
+    return StcClientCpuWaitForServerWriteStream(pClient, 0);
+}
+
+StcClientStatus StcClientCpuWaitForServerSliceStream(StcClientCpu* const pClient, const size_t stream, const uint32_t slice,
+                                                     const uint32_t timeoutMs) {
+    StcClientBase* const pBase = &pClient->base;
+    return WaitForServerSlice(pBase, stream, slice, ((int64_t)timeoutMs * pBase->tickFrequency) / 1000);
+}
+
+StcClientStatus StcClientCpuWaitForServerSlice(StcClientCpu* const pClient, const uint32_t slice, const uint32_t timeoutMs) {
+    return StcClientCpuWaitForServerSliceStream(pClient, 0, slice, timeoutMs);
+}
+
+StcClientStatus StcClientCpuSignalReadStream(StcClientCpu* const pClient, const size_t stream) {
+    StcClientBase* const pBase = &pClient->base;
+    StcClientStatus status = CheckStream(pBase, stream);
+    if (status == STC_CLIENT_STATUS_SUCCESS) {
+        const StcClientStream* const pStream = &pBase->streams[stream];
+        const size_t copyIndex = pStream->copyIndex;
+
+        ReleaseFrameRecord(pBase, stream);
+        ++pBase->pInfo->streams[pStream->serverStream].readFenceValues12[copyIndex];
+
+        uint32_t key;
+        if (!StcCpuKeyCheck(&pClient->streams[stream].pFrameHeaders[copyIndex]->key, STC_KEY_CLIENT, &key)) {
+            StcClientCpuDisconnect(pClient, STC_CLIENT_STOP_REASON_FAIL_CPU_RELEASE_SYNC);
+            status = STC_CLIENT_STATUS_FAIL_SIGNAL_READ;
+        }
+    }
+
+    return status;
+}
+
+StcClientStatus StcClientCpuSignalRead(StcClientCpu* const pClient) { return StcClientCpuSignalReadStream(pClient, 0); }
+
+StcClientStatus StcClientCpuRetainFrameStream(StcClientCpu* const pClient, const size_t stream, StcClientFrameLease* const pLease) {
+    return RetainFrame(&pClient->base, stream, pLease);
+}
+
+StcClientStatus StcClientCpuRetainFrame(StcClientCpu* const pClient, StcClientFrameLease* const pLease) {
+    return RetainFrame(&pClient->base, 0, pLease);
+}
+
+StcClientStatus StcClientCpuReleaseFrame(StcClientCpu* const pClient, const StcClientFrameLease* const pLease) {
+    StcClientBase* const pBase = &pClient->base;
+    bool returnSlot;
+    const StcClientStatus status = EndLease(pBase, pLease, &returnSlot);
+    if (returnSlot) {
+        ReturnSlot(pBase, pLease->stream, pLease->index);
+    }
+
+    return status;
+}
+
+StcClientStatus StcClientCpuWait(StcClientCpu* const pClient, const uint32_t timeoutMs) {
+    return StcClientWait(&pClient->base, timeoutMs);
+}
+
+#ifdef _WIN32
+HANDLE StcClientCpuGetWaitHandle(StcClientCpu* const pClient) { return pClient->base.clientWake.hEvent; }
+#endif
+
+#ifdef STC_TRANSPORT_PASSES_DESCRIPTORS
+int StcClientCpuGetWaitFd(StcClientCpu* const pClient) {
+    return (pClient->base.pInfo != NULL) ? StcEventGetDescriptor(&pClient->base.clientWake) : -1;
+}
+#endif
+
+void StcClientCpuSetFrameInterval(StcClientCpu* const pClient, const uint32_t intervalMicroseconds) {
+    SetFrameInterval(&pClient->base, intervalMicroseconds);
+}
+
+StcClientStatus StcClientCpuSendControl(StcClientCpu* const pClient, const uint32_t type, const void* const pData,
+                                        const size_t size) {
+    return SendControl(&pClient->base, type, pData, size);
+}
+
+StcClientStatus StcClientCpuSetStandby(StcClientCpu* const pClient, const bool standby) {
+    return SetStandby(&pClient->base, standby);
+}
+
+StcClientStatus StcClientCpuReadFrameMetadata(const StcClientCpu* const pClient, void* const pData, const size_t capacity,
+                                              size_t* const pSize) {
+    return ReadFrameMetadata(&pClient->base, 0, pData, capacity, pSize);
+}
+
+StcClientStatus StcClientCpuReadFrameMetadataStream(const StcClientCpu* const pClient, const size_t stream, void* const pData,
+                                                    const size_t capacity, size_t* const pSize) {
+    return ReadFrameMetadata(&pClient->base, stream, pData, capacity, pSize);
+}
+
+StcClientStatus StcClientCpuReadAuxRecord(StcClientCpu* const pClient, StcAuxRecord* const pRecord, void* const pData,
+                                          const size_t capacity) {
+    return ReadAuxRecord(&pClient->base, pRecord, pData, capacity);
+}
+
+void StcClientCpuGetFrameStats(const StcClientCpu* const pClient, StcClientFrameStats* const pStats) {
+    StcClientCpuGetStreamFrameStats(pClient, 0, pStats);
+}
+
+// Stats outlive the connection, so only streams the client never had read back as zero
+void StcClientCpuGetStreamFrameStats(const StcClientCpu* const pClient, const size_t stream, StcClientFrameStats* const pStats) {
+    if (stream < STC_MAX_STREAM_COUNT) {
+        *pStats = pClient->base.streams[stream].frameStats;
+    } else {
+        memset(pStats, 0, sizeof(*pStats));
+    }
+}
+
+void StcClientCpuResetFrameStats(StcClientCpu* const pClient) { ResetFrameStats(&pClient->base); }
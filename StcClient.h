@@ -26,6 +26,7 @@
 #pragma once
 
 #include "StcCommon.h"
+#include "StcTransport.h"
 
 #ifdef __cplusplus
 extern "C" {
@@ -34,31 +35,139 @@ extern "C" {
 #pragma warning(push)
 #pragma warning(disable : 4820)
 
+// Histogram bucket i counts frames acquired with i newer frames already queued behind them, the last bucket catches the rest
+#define STC_FRAME_AGE_BUCKETS 8
+
+typedef struct StcClientFrameStats {
+    uint64_t framesAcquired;
+    uint64_t framesDropped;
+    uint64_t dropEvents;
+    uint64_t largestGap;
+    uint64_t ageHistogram[STC_FRAME_AGE_BUCKETS];
+    int64_t totalAgeMicroseconds;
+    int64_t maxAgeMicroseconds;
+    int64_t totalHoldMicroseconds;
+} StcClientFrameStats;
+
+typedef struct StcClientCpuNextInfo {
+    const void* pData;
+    size_t rowPitch;
+    UINT width;
+    UINT height;
+    StcFormat format;
+    size_t index;
+    bool resized;
+    uint64_t sequence;
+    uint32_t framesBehind;
+    int64_t ageMicroseconds;
+    uint32_t sliceCount;
+    UINT sliceHeight;
+} StcClientCpuNextInfo;
+
+// A retained frame keeps its slot after Tick moves on, until it is handed back with ReleaseFrame
+typedef struct StcClientFrameLease {
+    size_t stream;
+    size_t index;
+    uint64_t sequence;
+} StcClientFrameLease;
+
+#ifdef _WIN32
 typedef struct StcClientD3D11NextInfo {
     ID3D11Texture2D* pTexture;
     size_t index;
     bool resized;
+    uint64_t sequence;
+    uint32_t framesBehind;
+    int64_t ageMicroseconds;
 } StcClientD3D11NextInfo;
 
 typedef struct StcClientD3D12NextInfo {
     ID3D12Resource* pTexture;
     size_t index;
     bool resized;
+    uint64_t sequence;
+    uint32_t framesBehind;
+    int64_t ageMicroseconds;
+    uint32_t sliceCount;
+    UINT sliceHeight;
 } StcClientD3D12NextInfo;
+#endif
+
+// One subscribed server stream. Streams are numbered in the order the client named them, which need not match the server.
+typedef struct StcClientStream {
+    // Create initialized
+    StcClientFrameStats frameStats;
+
+    // Connect initialized
+    size_t serverStream;
+    size_t copyIndex;
+    bool hasValidImage;
+    bool slotHeld;
+    uint64_t frameSequence;
+    uint32_t framesBehind;
+    bool leased[STC_MAX_TEXTURE_COUNT];
+    size_t leaseCount;
+    uint32_t resizeGeneration;
+} StcClientStream;
 
 typedef struct StcClientBase {
     // Create initialized
     StcMessageCallbacks messenger;
     enum StcApi serverApi;
     struct StcInfo* pInfo;
+    int64_t tickFrequency;
+    uint32_t frameIntervalMicroseconds;
     bool initialized;
 
     // Connect initialized
-    size_t copyIndex;
-    bool hasValidImage;
+    TCHAR pGlobalNameBuffer[256];
+    StcMapping globalMapping;
+    TCHAR pConnectionNameBuffer[256];
+    StcMapping mapping;
+#ifdef STC_TRANSPORT_PASSES_DESCRIPTORS
+    StcChannel channel;
+#endif
+    StcEvent serverWake;
+    StcEvent clientWake;
+    size_t textureCount;
+    StcSwapMode swapMode;
+#ifdef _WIN32
     HANDLE hProcess;
+#endif
+    size_t streamCount;
+    StcClientStream streams[STC_MAX_STREAM_COUNT];
+    size_t metadataCapacity;
+    StcCapabilityFlags capabilities;
+    char* pAuxRing;
+    bool standby;
+    // When the last frame asked for on standby was requested, 0 once it arrived
+    int64_t standbyRequestTicks;
+
+    // Tick initialized
+    uint32_t wakeToken;
 } StcClientBase;
 
+typedef struct StcClientCpuStream {
+    // Connect initialized
+    StcMapping frameMappings[STC_MAX_TEXTURE_COUNT];
+    StcCpuFrameHeader* pFrameHeaders[STC_MAX_TEXTURE_COUNT];
+#ifdef STC_TRANSPORT_PASSES_DESCRIPTORS
+    StcMapping receivedMappings[STC_MAX_TEXTURE_COUNT];
+    uint32_t receivedGenerations[STC_MAX_TEXTURE_COUNT];
+#endif
+} StcClientCpuStream;
+
+typedef struct StcClientCpu {
+    struct StcClientBase base;
+
+    // Create initialized
+    StcCpuAllocationCallbacks allocator;
+
+    // Connect initialized
+    StcClientCpuStream streams[STC_MAX_STREAM_COUNT];
+} StcClientCpu;
+
+#ifdef _WIN32
 typedef struct StcClientD3D11 {
     struct StcClientBase base;
 
@@ -69,8 +178,9 @@ typedef struct StcClientD3D11 {
     ID3D11Device1* pDevice1;
 
     // Connect initialized
-    ID3D11Texture2D* pTextures[STC_TEXTURE_COUNT];
-    IDXGIKeyedMutex* pKeyedMutexes[STC_TEXTURE_COUNT];
+    ID3D11Texture2D* pTextures[STC_MAX_TEXTURE_COUNT];
+    IDXGIKeyedMutex* pKeyedMutexes[STC_MAX_TEXTURE_COUNT];
+    bool keyHeld[STC_MAX_TEXTURE_COUNT];
 } StcClientD3D11;
 
 typedef struct StcClientD3D12 {
@@ -82,14 +192,70 @@ typedef struct StcClientD3D12 {
     StcD3D12AllocationCallbacks allocator;
 
     // Connect initialized
-    ID3D12Resource* pTextures[STC_TEXTURE_COUNT];
-    ID3D12Fence* pWriteFences[STC_TEXTURE_COUNT];
-    ID3D12Fence* pReadFences[STC_TEXTURE_COUNT];
-    UINT64 writeFenceCleared[STC_TEXTURE_COUNT];
+    ID3D12Resource* pTextures[STC_MAX_TEXTURE_COUNT];
+    ID3D12Fence* pWriteFences[STC_MAX_TEXTURE_COUNT];
+    ID3D12Fence* pReadFences[STC_MAX_TEXTURE_COUNT];
+    UINT64 writeFenceCleared[STC_MAX_TEXTURE_COUNT];
 } StcClientD3D12;
+#endif
 
 #pragma warning(pop)
 
+enum StcClientStatus StcClientCpuCreate(struct StcClientCpu* pClient, const StcCpuAllocationCallbacks* pAllocator,
+                                        const StcMessageCallbacks* pMessenger);
+void StcClientCpuDestroy(struct StcClientCpu* pClient);
+enum StcClientStatus StcClientCpuConnect(struct StcClientCpu* pClient, const TCHAR* pPrefix, DWORD processId, uint32_t textureCount,
+                                         StcSwapMode swapMode);
+// CPU only, like the server side of streams. Stream indices below are positions in ppStreamNames, and any past
+// streamCount fail with STC_CLIENT_STATUS_FAIL_INVALID_STREAM.
+enum StcClientStatus StcClientCpuConnectStreams(struct StcClientCpu* pClient, const TCHAR* pPrefix, DWORD processId,
+                                                uint32_t textureCount, StcSwapMode swapMode, const char* const* ppStreamNames,
+                                                size_t streamCount);
+enum StcClientStatus StcClientCpuTick(struct StcClientCpu* pClient, struct StcClientCpuNextInfo* pNextInfo);
+enum StcClientStatus StcClientCpuTickStream(struct StcClientCpu* pClient, size_t stream, struct StcClientCpuNextInfo* pNextInfo);
+enum StcClientStatus StcClientCpuWaitForServerWrite(struct StcClientCpu* pClient);
+enum StcClientStatus StcClientCpuWaitForServerWriteStream(struct StcClientCpu* pClient, size_t stream);
+// Rows [slice * sliceHeight, (slice + 1) * sliceHeight) may be read once this succeeds. WaitForServerWrite waits for the
+// whole frame and must still be called before SignalRead.
+enum StcClientStatus StcClientCpuWaitForServerSlice(struct StcClientCpu* pClient, uint32_t slice, uint32_t timeoutMs);
+enum StcClientStatus StcClientCpuWaitForServerSliceStream(struct StcClientCpu* pClient, size_t stream, uint32_t slice,
+                                                          uint32_t timeoutMs);
+enum StcClientStatus StcClientCpuSignalRead(struct StcClientCpu* pClient);
+enum StcClientStatus StcClientCpuSignalReadStream(struct StcClientCpu* pClient, size_t stream);
+// The frame Tick last returned stays readable until released, its pData included. Every lease holds a slot out of the ring,
+// so the server limits how many each client may hold depending on the ring depth and the number of readers.
+enum StcClientStatus StcClientCpuRetainFrame(struct StcClientCpu* pClient, struct StcClientFrameLease* pLease);
+enum StcClientStatus StcClientCpuRetainFrameStream(struct StcClientCpu* pClient, size_t stream, struct StcClientFrameLease* pLease);
+enum StcClientStatus StcClientCpuReleaseFrame(struct StcClientCpu* pClient, const struct StcClientFrameLease* pLease);
+enum StcClientStatus StcClientCpuWait(struct StcClientCpu* pClient, uint32_t timeoutMs);
+#ifdef _WIN32
+HANDLE StcClientCpuGetWaitHandle(struct StcClientCpu* pClient);
+#endif
+#ifdef STC_TRANSPORT_PASSES_DESCRIPTORS
+// Turns readable for epoll or poll when Wait would return, and stays so until the next Tick. Each Connect makes a new one,
+// and it is -1 while disconnected or when the server predates STC_CAPABILITY_FLAG_WAKE_DESCRIPTORS.
+int StcClientCpuGetWaitFd(struct StcClientCpu* pClient);
+#endif
+void StcClientCpuSetFrameInterval(struct StcClientCpu* pClient, uint32_t intervalMicroseconds);
+// Queues an StcControlMessageType, or a type from STC_CONTROL_MESSAGE_TYPE_USER up, for the server's next Tick. Nothing
+// blocks, a full ring fails with STC_CLIENT_STATUS_FAIL_CONTROL_RING_FULL until the server catches up.
+enum StcClientStatus StcClientCpuSendControl(struct StcClientCpu* pClient, uint32_t type, const void* pData, size_t size);
+// A standby connection stays open but paused, taking no frames, while Tick keeps it alive and opens every slot the server
+// creates for it. Leaving standby then shows the next frame the server writes, without the handshake or resource opens of
+// a new connection. Entering standby hands the current frame back, leases stay as they are.
+enum StcClientStatus StcClientCpuSetStandby(struct StcClientCpu* pClient, bool standby);
+enum StcClientStatus StcClientCpuReadFrameMetadata(const struct StcClientCpu* pClient, void* pData, size_t capacity,
+                                                   size_t* pSize);
+enum StcClientStatus StcClientCpuReadFrameMetadataStream(const struct StcClientCpu* pClient, size_t stream, void* pData,
+                                                         size_t capacity, size_t* pSize);
+// Takes the oldest auxiliary record from the server, for any subscribed stream. One that does not fit pData stays queued
+// with STC_CLIENT_STATUS_FAIL_AUX_BUFFER_TOO_SMALL, and pRecord tells how large it is.
+enum StcClientStatus StcClientCpuReadAuxRecord(struct StcClientCpu* pClient, StcAuxRecord* pRecord, void* pData, size_t capacity);
+void StcClientCpuGetFrameStats(const struct StcClientCpu* pClient, struct StcClientFrameStats* pStats);
+void StcClientCpuGetStreamFrameStats(const struct StcClientCpu* pClient, size_t stream, struct StcClientFrameStats* pStats);
+void StcClientCpuResetFrameStats(struct StcClientCpu* pClient);
+
+#ifdef _WIN32
 enum StcClientStatus StcClientD3D11Create(struct StcClientD3D11* pClient, ID3D11Device* pDevice,
                                           const StcD3D11AllocationCallbacks* pAllocator, const StcMessageCallbacks* pMessenger);
 enum StcClientStatus StcClientD3D12Create(struct StcClientD3D12* pClient, ID3D12Device* pDevice,
@@ -97,16 +263,133 @@ enum StcClientStatus StcClientD3D12Create(struct StcClientD3D12* pClient, ID3D12
 void StcClientD3D11Destroy(struct StcClientD3D11* pClient);
 void StcClientD3D12Destroy(struct StcClientD3D12* pClient);
 enum StcClientStatus StcClientD3D11Connect(struct StcClientD3D11* pClient, const TCHAR* pPrefix, DWORD processId,
-                                           StcBindFlags bindFlags, StcSrgbChannelType srgbChannelType);
+                                           StcBindFlags bindFlags, StcSrgbChannelType srgbChannelType, uint32_t textureCount,
+                                           StcSwapMode swapMode);
 enum StcClientStatus StcClientD3D12Connect(struct StcClientD3D12* pClient, const TCHAR* pPrefix, DWORD processId,
-                                           StcBindFlags bindFlags, StcSrgbChannelType srgbChannelType);
+                                           StcBindFlags bindFlags, StcSrgbChannelType srgbChannelType, uint32_t textureCount,
+                                           StcSwapMode swapMode);
 enum StcClientStatus StcClientD3D11Tick(struct StcClientD3D11* pClient, struct StcClientD3D11NextInfo* pNextInfo);
 enum StcClientStatus StcClientD3D12Tick(struct StcClientD3D12* pClient, struct StcClientD3D12NextInfo* pNextInfo);
 enum StcClientStatus StcClientD3D11WaitForServerWrite(struct StcClientD3D11* pClient);
 enum StcClientStatus StcClientD3D12WaitForServerWrite(struct StcClientD3D12* pClient, ID3D12CommandQueue* pQueue);
+// Once this succeeds, work submitted to pQueue afterwards may read rows [slice * sliceHeight, (slice + 1) * sliceHeight).
+// WaitForServerWrite must still be called before SignalRead. D3D11 clients take whole frames through the keyed mutex.
+enum StcClientStatus StcClientD3D12WaitForServerSlice(struct StcClientD3D12* pClient, ID3D12CommandQueue* pQueue, uint32_t slice,
+                                                      uint32_t timeoutMs);
 enum StcClientStatus StcClientD3D11SignalRead(struct StcClientD3D11* pClient);
 enum StcClientStatus StcClientD3D12SignalRead(struct StcClientD3D12* pClient, ID3D12CommandQueue* pQueue);
+// A D3D11 lease holds the texture's keyed mutex until it is released, so the frame can be used at any point in between.
+// A D3D12 release signals the read fence on pQueue after the work already submitted to it.
+enum StcClientStatus StcClientD3D11RetainFrame(struct StcClientD3D11* pClient, struct StcClientFrameLease* pLease);
+enum StcClientStatus StcClientD3D12RetainFrame(struct StcClientD3D12* pClient, struct StcClientFrameLease* pLease);
+enum StcClientStatus StcClientD3D11ReleaseFrame(struct StcClientD3D11* pClient, const struct StcClientFrameLease* pLease);
+enum StcClientStatus StcClientD3D12ReleaseFrame(struct StcClientD3D12* pClient, ID3D12CommandQueue* pQueue,
+                                                const struct StcClientFrameLease* pLease);
+enum StcClientStatus StcClientD3D11Wait(struct StcClientD3D11* pClient, uint32_t timeoutMs);
+enum StcClientStatus StcClientD3D12Wait(struct StcClientD3D12* pClient, uint32_t timeoutMs);
+HANDLE StcClientD3D11GetWaitHandle(struct StcClientD3D11* pClient);
+HANDLE StcClientD3D12GetWaitHandle(struct StcClientD3D12* pClient);
+void StcClientD3D11SetFrameInterval(struct StcClientD3D11* pClient, uint32_t intervalMicroseconds);
+void StcClientD3D12SetFrameInterval(struct StcClientD3D12* pClient, uint32_t intervalMicroseconds);
+enum StcClientStatus StcClientD3D11ReadFrameMetadata(const struct StcClientD3D11* pClient, void* pData, size_t capacity,
+                                                     size_t* pSize);
+enum StcClientStatus StcClientD3D12ReadFrameMetadata(const struct StcClientD3D12* pClient, void* pData, size_t capacity,
+                                                     size_t* pSize);
+enum StcClientStatus StcClientD3D11UpdateParameters(struct StcClientD3D11* pClient, StcBindFlags bindFlags,
+                                                    StcSrgbChannelType srgbChannelType);
+enum StcClientStatus StcClientD3D12UpdateParameters(struct StcClientD3D12* pClient, StcBindFlags bindFlags,
+                                                    StcSrgbChannelType srgbChannelType);
+enum StcClientStatus StcClientD3D11SendControl(struct StcClientD3D11* pClient, uint32_t type, const void* pData, size_t size);
+enum StcClientStatus StcClientD3D12SendControl(struct StcClientD3D12* pClient, uint32_t type, const void* pData, size_t size);
+enum StcClientStatus StcClientD3D11SetStandby(struct StcClientD3D11* pClient, bool standby);
+enum StcClientStatus StcClientD3D12SetStandby(struct StcClientD3D12* pClient, bool standby);
+enum StcClientStatus StcClientD3D11ReadAuxRecord(struct StcClientD3D11* pClient, StcAuxRecord* pRecord, void* pData,
+                                                  size_t capacity);
+enum StcClientStatus StcClientD3D12ReadAuxRecord(struct StcClientD3D12* pClient, StcAuxRecord* pRecord, void* pData,
+                                                  size_t capacity);
+void StcClientD3D11GetFrameStats(const struct StcClientD3D11* pClient, struct StcClientFrameStats* pStats);
+void StcClientD3D12GetFrameStats(const struct StcClientD3D12* pClient, struct StcClientFrameStats* pStats);
+void StcClientD3D11ResetFrameStats(struct StcClientD3D11* pClient);
+void StcClientD3D12ResetFrameStats(struct StcClientD3D12* pClient);
+#endif
 
 #ifdef __cplusplus
 }
 #endif
+
+#ifdef __cplusplus
+template <typename Client>
+struct StcFrameLeaseTraits;
+
+template <>
+struct StcFrameLeaseTraits<StcClientCpu> {
+    typedef void* Queue;
+    static StcClientStatus Release(StcClientCpu* pClient, Queue, const StcClientFrameLease* pLease) {
+        return StcClientCpuReleaseFrame(pClient, pLease);
+    }
+};
+
+#ifdef _WIN32
+template <>
+struct StcFrameLeaseTraits<StcClientD3D11> {
+    typedef void* Queue;
+    static StcClientStatus Release(StcClientD3D11* pClient, Queue, const StcClientFrameLease* pLease) {
+        return StcClientD3D11ReleaseFrame(pClient, pLease);
+    }
+};
+
+template <>
+struct StcFrameLeaseTraits<StcClientD3D12> {
+    typedef ID3D12CommandQueue* Queue;
+    static StcClientStatus Release(StcClientD3D12* pClient, Queue pQueue, const StcClientFrameLease* pLease) {
+        return StcClientD3D12ReleaseFrame(pClient, pQueue, pLease);
+    }
+};
+#endif
+
+// Owns a lease taken with RetainFrame and releases it when destroyed. D3D12 leases also need the queue to signal on.
+template <typename Client>
+class StcFrameLease {
+  public:
+    typedef typename StcFrameLeaseTraits<Client>::Queue Queue;
+
+    StcFrameLease() : pClient_(nullptr), queue_(), lease_() {}
+    StcFrameLease(Client* pClient, const StcClientFrameLease& lease, Queue queue = Queue())
+        : pClient_(pClient), queue_(queue), lease_(lease) {}
+    StcFrameLease(StcFrameLease&& other) : pClient_(other.pClient_), queue_(other.queue_), lease_(other.lease_) {
+        other.pClient_ = nullptr;
+    }
+    StcFrameLease& operator=(StcFrameLease&& other) {
+        if (this != &other) {
+            Release();
+            pClient_ = other.pClient_;
+            queue_ = other.queue_;
+            lease_ = other.lease_;
+            other.pClient_ = nullptr;
+        }
+
+        return *this;
+    }
+    StcFrameLease(const StcFrameLease&) = delete;
+    StcFrameLease& operator=(const StcFrameLease&) = delete;
+    ~StcFrameLease() { Release(); }
+
+    StcClientStatus Release() {
+        StcClientStatus status = STC_CLIENT_STATUS_SUCCESS;
+        if (pClient_ != nullptr) {
+            status = StcFrameLeaseTraits<Client>::Release(pClient_, queue_, &lease_);
+            pClient_ = nullptr;
+        }
+
+        return status;
+    }
+
+    const StcClientFrameLease& Get() const { return lease_; }
+    explicit operator bool() const { return pClient_ != nullptr; }
+
+  private:
+    Client* pClient_;
+    Queue queue_;
+    StcClientFrameLease lease_;
+};
+#endif
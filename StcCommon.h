@@ -26,11 +26,13 @@
 #pragma once
 
 #include <assert.h>
-#include <intrin.h>
 #include <inttypes.h>
 #include <stdbool.h>
 #include <stdint.h>
 
+#ifdef _WIN32
+#include <intrin.h>
+
 #ifndef COBJMACROS
 #define COBJMACROS 1
 #endif
@@ -50,6 +52,17 @@
 #include <d3d11on12.h>
 #include <VersionHelpers.h>
 #pragma warning(pop)
+#else
+#include <stddef.h>
+#include <stdio.h>
+
+typedef char TCHAR;
+typedef uint32_t DWORD;
+typedef unsigned int UINT;
+
+#define TEXT(quote) quote
+#define _countof(array) (sizeof(array) / sizeof((array)[0]))
+#endif
 
 #ifdef __cplusplus
 extern "C" {
@@ -69,6 +82,14 @@ typedef enum StcServerStatus {
     STC_SERVER_STATUS_FAIL_TICK,
     STC_SERVER_STATUS_FAIL_WAIT_CLIENT_READ,
     STC_SERVER_STATUS_FAIL_SIGNAL_WRITE,
+    STC_SERVER_STATUS_FAIL_WAIT_TIMEOUT,
+    STC_SERVER_STATUS_FAIL_CREATE_CHANNEL,
+    STC_SERVER_STATUS_FAIL_TOO_MANY_STREAMS,
+    STC_SERVER_STATUS_FAIL_FRAME_NOT_WANTED,
+    STC_SERVER_STATUS_FAIL_METADATA_TOO_LARGE,
+    STC_SERVER_STATUS_FAIL_AUX_RECORD_TOO_LARGE,
+    STC_SERVER_STATUS_FAIL_INVALID_STREAM,
+    STC_SERVER_STATUS_FAIL_NOT_WRITING,
     STC_SERVER_STATUS_MAX_ENUM = 0x7FFFFFFF,
 } StcServerStatus;
 
@@ -92,6 +113,25 @@ typedef enum StcClientStatus {
     STC_CLIENT_STATUS_FAIL_TICK,
     STC_CLIENT_STATUS_FAIL_WAIT_SERVER_WRITE,
     STC_CLIENT_STATUS_FAIL_SIGNAL_READ,
+    STC_CLIENT_STATUS_FAIL_API_MISMATCH,
+    STC_CLIENT_STATUS_FAIL_WAIT_TIMEOUT,
+    STC_CLIENT_STATUS_FAIL_OPEN_EVENT,
+    STC_CLIENT_STATUS_FAIL_CONNECT_CHANNEL,
+    STC_CLIENT_STATUS_FAIL_INVALID_TEXTURE_COUNT,
+    STC_CLIENT_STATUS_FAIL_INVALID_SWAP_MODE,
+    STC_CLIENT_STATUS_FAIL_UNKNOWN_STREAM,
+    STC_CLIENT_STATUS_FAIL_METADATA_BUFFER_TOO_SMALL,
+    STC_CLIENT_STATUS_FAIL_READ_METADATA,
+    STC_CLIENT_STATUS_FAIL_CAPABILITY_UNSUPPORTED,
+    STC_CLIENT_STATUS_FAIL_NO_FRAME,
+    STC_CLIENT_STATUS_FAIL_LEASE_LIMIT,
+    STC_CLIENT_STATUS_FAIL_INVALID_LEASE,
+    STC_CLIENT_STATUS_FAIL_HUB_FULL,
+    STC_CLIENT_STATUS_FAIL_CONTROL_TOO_LARGE,
+    STC_CLIENT_STATUS_FAIL_CONTROL_RING_FULL,
+    STC_CLIENT_STATUS_FAIL_NO_AUX_RECORD,
+    STC_CLIENT_STATUS_FAIL_AUX_BUFFER_TOO_SMALL,
+    STC_CLIENT_STATUS_FAIL_INVALID_STREAM,
     STC_CLIENT_STATUS_MAX_ENUM = 0x7FFFFFFF,
 } StcClientStatus;
 
@@ -131,6 +171,19 @@ typedef enum StcServerStopReason {
     STC_SERVER_STOP_REASON_FAIL_D3D12_RELEASE_KEYED_MUTEX_TO_WRITE,
     STC_SERVER_STOP_REASON_FAIL_D3D11_USER_CREATE_FRAME_CALLBACK,
     STC_SERVER_STOP_REASON_FAIL_D3D12_USER_CREATE_FRAME_CALLBACK,
+    STC_SERVER_STOP_REASON_UNSUPPORTED_CLIENT_API,
+    STC_SERVER_STOP_REASON_FAIL_CREATE_CPU_BUFFER,
+    STC_SERVER_STOP_REASON_FAIL_CPU_ACQUIRE_KEYED_MUTEX_TO_OWN,
+    STC_SERVER_STOP_REASON_FAIL_CPU_RELEASE_KEYED_MUTEX_TO_OWN,
+    STC_SERVER_STOP_REASON_FAIL_CPU_ACQUIRE_KEYED_MUTEX_TO_WRITE,
+    STC_SERVER_STOP_REASON_FAIL_CPU_RELEASE_KEYED_MUTEX_TO_WRITE,
+    STC_SERVER_STOP_REASON_FAIL_CPU_USER_CREATE_FRAME_CALLBACK,
+    STC_SERVER_STOP_REASON_FAIL_ACCEPT_CHANNEL,
+    STC_SERVER_STOP_REASON_FAIL_SEND_CPU_BUFFERS,
+    STC_SERVER_STOP_REASON_UNSUPPORTED_TEXTURE_COUNT,
+    STC_SERVER_STOP_REASON_UNSUPPORTED_STREAMS,
+    STC_SERVER_STOP_REASON_FAIL_EXCHANGE_WAKE_DESCRIPTORS,
+    STC_SERVER_STOP_REASON_UNSHARED_CLIENT_API,
     STC_SERVER_STOP_REASON_MAX_ENUM = 0x7FFFFFFF,
 } StcServerStopReason;
 
@@ -153,6 +206,13 @@ typedef enum StcClientStopReason {
     STC_CLIENT_STOP_REASON_FAIL_D3D12_QUEUE_SIGNAL,
     STC_CLIENT_STOP_REASON_FAIL_D3D11_USER_OPEN_FRAME_CALLBACK,
     STC_CLIENT_STOP_REASON_FAIL_D3D12_USER_OPEN_FRAME_CALLBACK,
+    STC_CLIENT_STOP_REASON_FAIL_OPEN_CPU_BUFFER,
+    STC_CLIENT_STOP_REASON_FAIL_CPU_ACQUIRE_SYNC,
+    STC_CLIENT_STOP_REASON_FAIL_CPU_RELEASE_SYNC,
+    STC_CLIENT_STOP_REASON_FAIL_CPU_USER_OPEN_FRAME_CALLBACK,
+    STC_CLIENT_STOP_REASON_FAIL_RECEIVE_CPU_BUFFERS,
+    STC_CLIENT_STOP_REASON_INVALID_TEXTURE_COUNT,
+    STC_CLIENT_STOP_REASON_FAIL_RECEIVE_WAKE_DESCRIPTOR,
     STC_CLIENT_STOP_REASON_MAX_ENUM = 0x7FFFFFFF,
 } StcClientStopReason;
 
@@ -163,12 +223,29 @@ typedef enum StcSrgbChannelType {
     STC_SRGB_CHANNEL_TYPE_MAX_ENUM = 0x7FFFFFFF,
 } StcSrgbChannelType;
 
+// FIFO hands over every frame in order. MAILBOX keeps only the newest one: the server overwrites a published frame the
+// client has not claimed instead of waiting for a free slot, and the client skips straight to the latest frame.
+typedef enum StcSwapMode {
+    STC_SWAP_MODE_FIFO,
+    STC_SWAP_MODE_MAILBOX,
+    STC_SWAP_MODE_MAX_ENUM = 0x7FFFFFFF,
+} StcSwapMode;
+
 typedef enum StcApi {
     STC_API_D3D11,
     STC_API_D3D12,
+    STC_API_CPU,
     STC_API_MAX_ENUM = 0x7FFFFFFF,
 } StcApi;
 
+typedef enum StcFormat {
+    STC_FORMAT_R16G16B16A16_FLOAT,
+    STC_FORMAT_R10G10B10A2_UNORM,
+    STC_FORMAT_R8G8B8A8_SRGB,
+    STC_FORMAT_B8G8R8A8_SRGB,
+    STC_FORMAT_R10G10B10_XR_BIAS_A2_UNORM,
+} StcFormat;
+
 typedef enum StcBindFlagBits {
     STC_BIND_FLAG_NONE = 0x00000000,
     STC_BIND_FLAG_SHADER_RESOURCE = 0x00000008,
@@ -178,6 +255,50 @@ typedef enum StcBindFlagBits {
 } StcBindFlagBits;
 typedef uint32_t StcBindFlags;
 
+// Optional protocol features, negotiated per connection. A feature either side lacks falls back to the baseline protocol.
+typedef enum StcCapabilityFlagBits {
+    STC_CAPABILITY_FLAG_NONE = 0x00000000,
+    STC_CAPABILITY_FLAG_MAILBOX = 0x00000001,
+    STC_CAPABILITY_FLAG_STREAMS = 0x00000002,
+    STC_CAPABILITY_FLAG_FRAME_INTERVAL = 0x00000004,
+    STC_CAPABILITY_FLAG_LIVE_PARAMETERS = 0x00000008,
+    STC_CAPABILITY_FLAG_FRAME_METADATA = 0x00000010,
+    STC_CAPABILITY_FLAG_SLICES = 0x00000020,
+    STC_CAPABILITY_FLAG_CONTROL = 0x00000040,
+    STC_CAPABILITY_FLAG_AUX_RECORDS = 0x00000080,
+    STC_CAPABILITY_FLAG_RESIZE_GENERATIONS = 0x00000100,
+    STC_CAPABILITY_FLAG_WAKE_DESCRIPTORS = 0x00000200,
+    STC_CAPABILITY_FLAG_MAX_ENUM = 0x7FFFFFFF,
+} StcCapabilityFlagBits;
+typedef uint32_t StcCapabilityFlags;
+
+// Requests a client sends over its control ring. The server acts on the first three itself, every message is also handed
+// to the server's control callback.
+typedef enum StcControlMessageType {
+    // Copy the next frame for this client even if its frame interval has not run out
+    STC_CONTROL_MESSAGE_TYPE_REQUEST_FRAME = 0,
+    // Stop and restart handing frames to this client, without giving up the connection
+    STC_CONTROL_MESSAGE_TYPE_PAUSE = 1,
+    STC_CONTROL_MESSAGE_TYPE_RESUME = 2,
+    // Payload is an StcControlResolutionHint
+    STC_CONTROL_MESSAGE_TYPE_RESOLUTION_HINT = 3,
+    // Payload is an StcControlRegion
+    STC_CONTROL_MESSAGE_TYPE_REGION_OF_INTEREST = 4,
+    // Values from here on are left to the application
+    STC_CONTROL_MESSAGE_TYPE_USER = 0x00010000,
+    STC_CONTROL_MESSAGE_TYPE_MAX_ENUM = 0x7FFFFFFF,
+} StcControlMessageType;
+
+// What an auxiliary record carries. The library only moves the bytes, the types are a convention between server and client.
+typedef enum StcAuxRecordType {
+    STC_AUX_RECORD_TYPE_INPUT = 0,
+    STC_AUX_RECORD_TYPE_AUDIO = 1,
+    STC_AUX_RECORD_TYPE_EVENT = 2,
+    // Values from here on are left to the application
+    STC_AUX_RECORD_TYPE_USER = 0x00010000,
+    STC_AUX_RECORD_TYPE_MAX_ENUM = 0x7FFFFFFF,
+} StcAuxRecordType;
+
 typedef enum StcMessageCategory {
     STC_MESSAGE_CATEGORY_SERVER_CREATE,
     STC_MESSAGE_CATEGORY_SERVER_DESTROY,
@@ -203,6 +324,9 @@ typedef enum StcMessageId {
     STC_MESSAGE_ID_SERVER_FAIL_GLOBAL_STRING_FORMAT,
     STC_MESSAGE_ID_SERVER_FAIL_CREATE_GLOBAL_FILE_MAPPING,
     STC_MESSAGE_ID_SERVER_FAIL_MAP_GLOBAL_INFO,
+    STC_MESSAGE_ID_SERVER_FAIL_CREATE_WAKE_EVENT,
+    STC_MESSAGE_ID_SERVER_FAIL_ADD_STREAM,
+    STC_MESSAGE_ID_SERVER_FAIL_METADATA_CAPACITY,
     STC_MESSAGE_ID_SERVER_FAIL_12_FOR_11_LOADLIBRARY_D3D12,
     STC_MESSAGE_ID_SERVER_FAIL_12_FOR_11_GETMODULEHANDLE_D3D11,
     STC_MESSAGE_ID_SERVER_FAIL_12_FOR_11_GETPROCADDRESS_D3D12CREATEDEVICE,
@@ -224,17 +348,29 @@ typedef enum StcMessageId {
     STC_MESSAGE_ID_SERVER_D3D11_CLIENT_ALLOWED,
     STC_MESSAGE_ID_SERVER_FAIL_CREATE_FENCE_EVENT,
     STC_MESSAGE_ID_SERVER_CREATE_D3D12_SUCCESS,
+    STC_MESSAGE_ID_SERVER_CREATE_CPU_SUCCESS,
     STC_MESSAGE_ID_SERVER_DESTROY_D3D11_SUCCESS,
     STC_MESSAGE_ID_SERVER_DESTROY_D3D12_SUCCESS,
+    STC_MESSAGE_ID_SERVER_DESTROY_CPU_SUCCESS,
     STC_MESSAGE_ID_SERVER_FAIL_CONNECTION_STRING_FORMAT,
     STC_MESSAGE_ID_SERVER_FAIL_CREATE_CONNECTION_FILE_MAPPING,
     STC_MESSAGE_ID_SERVER_FAIL_MAP_CONNECTION_INFO,
+    STC_MESSAGE_ID_SERVER_FAIL_CREATE_CHANNEL,
     STC_MESSAGE_ID_SERVER_CONNECTION_READY,
     STC_MESSAGE_ID_SERVER_D3D11_CONNECTION_RESET,
     STC_MESSAGE_ID_SERVER_D3D12_CONNECTION_RESET,
+    STC_MESSAGE_ID_SERVER_CPU_CONNECTION_RESET,
     STC_MESSAGE_ID_SERVER_RECOVER_FROM_OPEN_FAILURE,
     STC_MESSAGE_ID_SERVER_CONNECT_TOKEN_TAKEN,
     STC_MESSAGE_ID_SERVER_CONNECT_HANDSHAKE_COMPLETE,
+    STC_MESSAGE_ID_SERVER_CLIENT_PARAMETERS_UPDATED,
+    STC_MESSAGE_ID_SERVER_CLIENT_CONTROL_OVERRUN,
+    STC_MESSAGE_ID_SERVER_CLIENT_API_UNSUPPORTED,
+    STC_MESSAGE_ID_SERVER_FAIL_ACCEPT_CHANNEL,
+    STC_MESSAGE_ID_SERVER_FAIL_EXCHANGE_WAKE_DESCRIPTORS,
+    STC_MESSAGE_ID_SERVER_CLIENT_TEXTURE_COUNT_UNSUPPORTED,
+    STC_MESSAGE_ID_SERVER_CLIENT_STREAMS_UNSUPPORTED,
+    STC_MESSAGE_ID_SERVER_CLIENT_API_UNSHARED,
     STC_MESSAGE_ID_SERVER_CLIENT_REQUEST_STOP,
     STC_MESSAGE_ID_SERVER_CLIENT_TIMEOUT,
     STC_MESSAGE_ID_SERVER_CLIENT_TIMEOUT_HANDSHAKE,
@@ -246,42 +382,98 @@ typedef enum StcMessageId {
     STC_MESSAGE_ID_SERVER_FAIL_D3D11_RELEASE_KEYED_MUTEX_TO_OWN,
     STC_MESSAGE_ID_SERVER_FAIL_D3D12_ACQUIRE_KEYED_MUTEX_TO_OWN,
     STC_MESSAGE_ID_SERVER_FAIL_D3D12_RELEASE_KEYED_MUTEX_TO_OWN,
+    STC_MESSAGE_ID_SERVER_FAIL_CPU_ACQUIRE_KEYED_MUTEX_TO_OWN,
+    STC_MESSAGE_ID_SERVER_FAIL_CPU_RELEASE_KEYED_MUTEX_TO_OWN,
     STC_MESSAGE_ID_SERVER_D3D11_CREATE_FRAME_ATTEMPT,
     STC_MESSAGE_ID_SERVER_FAIL_D3D11_USER_CREATE_FRAME_CALLBACK,
     STC_MESSAGE_ID_SERVER_D3D11_CREATE_FRAME_SUCCESS,
     STC_MESSAGE_ID_SERVER_D3D12_CREATE_FRAME_ATTEMPT,
     STC_MESSAGE_ID_SERVER_FAIL_D3D12_USER_CREATE_FRAME_CALLBACK,
     STC_MESSAGE_ID_SERVER_D3D12_CREATE_FRAME_SUCCESS,
+    STC_MESSAGE_ID_SERVER_CPU_CREATE_FRAME_ATTEMPT,
+    STC_MESSAGE_ID_SERVER_FAIL_CPU_CREATE_BUFFER,
+    STC_MESSAGE_ID_SERVER_FAIL_CPU_SEND_BUFFERS,
+    STC_MESSAGE_ID_SERVER_FAIL_CPU_USER_CREATE_FRAME_CALLBACK,
+    STC_MESSAGE_ID_SERVER_CPU_CREATE_FRAME_SUCCESS,
     STC_MESSAGE_ID_SERVER_FAIL_D3D11_ACQUIRE_KEYED_MUTEX_TO_WRITE,
     STC_MESSAGE_ID_SERVER_FAIL_D3D11_QUEUE_WAIT,
     STC_MESSAGE_ID_SERVER_FAIL_D3D12_ACQUIRE_KEYED_MUTEX_TO_WRITE,
     STC_MESSAGE_ID_SERVER_FAIL_D3D12_QUEUE_WAIT,
+    STC_MESSAGE_ID_SERVER_FAIL_CPU_ACQUIRE_KEYED_MUTEX_TO_WRITE,
     STC_MESSAGE_ID_SERVER_FAIL_D3D11_RELEASE_KEYED_MUTEX_TO_WRITE,
     STC_MESSAGE_ID_SERVER_FAIL_D3D11_QUEUE_SIGNAL,
     STC_MESSAGE_ID_SERVER_FAIL_D3D12_RELEASE_KEYED_MUTEX_TO_WRITE,
     STC_MESSAGE_ID_SERVER_FAIL_D3D12_QUEUE_SIGNAL,
+    STC_MESSAGE_ID_SERVER_FAIL_CPU_RELEASE_KEYED_MUTEX_TO_WRITE,
     STC_MESSAGE_ID_CLIENT_VERSION,
     STC_MESSAGE_ID_CLIENT_CREATE_D3D11_SUCCESS,
     STC_MESSAGE_ID_CLIENT_CREATE_D3D12_SUCCESS,
+    STC_MESSAGE_ID_CLIENT_CREATE_CPU_SUCCESS,
     STC_MESSAGE_ID_CLIENT_DESTROY_D3D11_SUCCESS,
     STC_MESSAGE_ID_CLIENT_DESTROY_D3D12_SUCCESS,
+    STC_MESSAGE_ID_CLIENT_DESTROY_CPU_SUCCESS,
     STC_MESSAGE_ID_CLIENT_D3D11_OPEN_FRAME_ATTEMPT,
     STC_MESSAGE_ID_CLIENT_FAIL_D3D11_USER_OPEN_FRAME_CALLBACK,
     STC_MESSAGE_ID_CLIENT_D3D11_OPEN_FRAME_SUCCESS,
     STC_MESSAGE_ID_CLIENT_D3D12_OPEN_FRAME_ATTEMPT,
     STC_MESSAGE_ID_CLIENT_FAIL_D3D12_USER_OPEN_FRAME_CALLBACK,
     STC_MESSAGE_ID_CLIENT_D3D12_OPEN_FRAME_SUCCESS,
+    STC_MESSAGE_ID_CLIENT_CPU_OPEN_FRAME_ATTEMPT,
+    STC_MESSAGE_ID_CLIENT_FAIL_CPU_USER_OPEN_FRAME_CALLBACK,
+    STC_MESSAGE_ID_CLIENT_CPU_OPEN_FRAME_SUCCESS,
 } StcMessageId;
 
+#ifdef _WIN32
 typedef bool (*PFN_StcCreateFunctionD3D11)(void* pUserData, size_t index, ID3D11Texture2D* pTexture);
 typedef void (*PFN_StcDestroyFunctionD3D11)(void* pUserData, size_t index);
 
 typedef bool (*PFN_StcCreateFunctionD3D12)(void* pUserData, size_t index, ID3D12Resource* pTexture);
 typedef void (*PFN_StcDestroyFunctionD3D12)(void* pUserData, size_t index);
+#endif
+
+// Frames of streams after the first are numbered on from the first stream's slots, stream * STC_MAX_TEXTURE_COUNT + slot
+typedef bool (*PFN_StcCreateFunctionCpu)(void* pUserData, size_t index, void* pData, size_t rowPitch);
+typedef void (*PFN_StcDestroyFunctionCpu)(void* pUserData, size_t index);
 
 typedef void (*PFN_StcMessageFunction)(StcMessageCategory category, StcMessageSeverity severity, StcMessageId id,
                                        const char* descripiton, void* pUserData);
 
+#define STC_CONTROL_PAYLOAD_SIZE 56
+
+typedef struct StcControlMessage {
+    uint32_t type;
+    uint32_t size;
+    uint8_t payload[STC_CONTROL_PAYLOAD_SIZE];
+} StcControlMessage;
+
+typedef struct StcControlResolutionHint {
+    UINT width;
+    UINT height;
+} StcControlResolutionHint;
+
+typedef struct StcControlRegion {
+    UINT x;
+    UINT y;
+    UINT width;
+    UINT height;
+} StcControlRegion;
+
+// ticks is on the StcGetCurrentTicks clock. frameSequence is the newest frame published on the stream when the record was
+// written, so records with a given sequence belong between that frame and the next one. droppedBefore counts the records
+// the server had to drop for this client since the previous one, because its ring was full.
+typedef struct StcAuxRecord {
+    uint32_t type;
+    uint32_t size;
+    size_t stream;
+    int64_t ticks;
+    uint64_t frameSequence;
+    uint32_t droppedBefore;
+} StcAuxRecord;
+
+// The connection is the index of the client among the server's connections, stable for as long as it stays connected
+typedef void (*PFN_StcControlFunction)(void* pUserData, size_t connection, const StcControlMessage* pMessage);
+
+#ifdef _WIN32
 typedef struct StcD3D11AllocationCallbacks {
     void* pUserData;
     PFN_StcCreateFunctionD3D11 pfnCreate;
@@ -293,22 +485,67 @@ typedef struct StcD3D12AllocationCallbacks {
     PFN_StcCreateFunctionD3D12 pfnCreate;
     PFN_StcDestroyFunctionD3D12 pfnDestroy;
 } StcD3D12AllocationCallbacks;
+#endif
+
+typedef struct StcCpuAllocationCallbacks {
+    void* pUserData;
+    PFN_StcCreateFunctionCpu pfnCreate;
+    PFN_StcDestroyFunctionCpu pfnDestroy;
+} StcCpuAllocationCallbacks;
 
 typedef struct StcMessageCallbacks {
     void* pUserData;
     PFN_StcMessageFunction pfnMessage;
 } StcMessageCallbacks;
 
+typedef struct StcControlCallbacks {
+    void* pUserData;
+    PFN_StcControlFunction pfnControl;
+} StcControlCallbacks;
+
+// Plain Load is acquire, plain Store/Increment/Decrement/CompareExchange are sequentially consistent. Prefer the Relaxed and
+// Release forms wherever the value does not need to order other shared-memory accesses. x86/x64 MSVC only needs a compiler
+// barrier for acquire/release; other MSVC targets fall back to a full barrier or the interlocked forms. Elsewhere the __atomic
+// builtins keep the MSVC layout and stay usable from C++.
+
+#if defined(_MSC_VER)
+
+#if defined(_M_IX86) || defined(_M_X64)
+#define STC_ATOMIC_STRONG_HARDWARE_ORDER 1
+#else
+#define STC_ATOMIC_STRONG_HARDWARE_ORDER 0
+#endif
+
+// Volatile reads only acquire under /volatile:ms, which is not the default off x86/x64
+static inline void StcAtomicLoadBarrier(void) {
+#if STC_ATOMIC_STRONG_HARDWARE_ORDER
+    _ReadWriteBarrier();
+#else
+    MemoryBarrier();
+#endif
+}
+
 typedef struct StcAtomicBool {
     volatile CHAR storage;
 } StcAtomicBool;
 
+static inline bool StcAtomicBoolLoadRelaxed(const StcAtomicBool* const pA) { return (bool)pA->storage; }
+
 static inline bool StcAtomicBoolLoad(const StcAtomicBool* const pA) {
     const CHAR bytes = pA->storage;
-    _ReadWriteBarrier();
+    StcAtomicLoadBarrier();
     return (bool)bytes;
 }
 
+static inline void StcAtomicBoolStoreRelease(StcAtomicBool* const pA, const bool value) {
+#if STC_ATOMIC_STRONG_HARDWARE_ORDER
+    _ReadWriteBarrier();
+    pA->storage = (CHAR)value;
+#else
+    _InterlockedExchange8(&pA->storage, (CHAR)value);
+#endif
+}
+
 static inline void StcAtomicBoolStore(StcAtomicBool* const pA, const bool value) {
     _InterlockedExchange8(&pA->storage, (CHAR)value);
 }
@@ -317,37 +554,74 @@ typedef struct StcAtomicUint32 {
     volatile LONG storage;
 } StcAtomicUint32;
 
+static inline uint32_t StcAtomicUint32LoadRelaxed(const StcAtomicUint32* const pA) { return (uint32_t)pA->storage; }
+
 static inline uint32_t StcAtomicUint32Load(const StcAtomicUint32* const pA) {
     const LONG bytes = pA->storage;
-    _ReadWriteBarrier();
+    StcAtomicLoadBarrier();
     return (uint32_t)bytes;
 }
 
 static inline void StcAtomicUint32StoreRelaxed(StcAtomicUint32* const pA, const uint32_t value) { pA->storage = (LONG)value; }
 
+static inline void StcAtomicUint32StoreRelease(StcAtomicUint32* const pA, const uint32_t value) {
+#if STC_ATOMIC_STRONG_HARDWARE_ORDER
+    _ReadWriteBarrier();
+    pA->storage = (LONG)value;
+#else
+    _InterlockedExchange(&pA->storage, (LONG)value);
+#endif
+}
+
 static inline void StcAtomicUint32Store(StcAtomicUint32* const pA, const uint32_t value) {
     _InterlockedExchange(&pA->storage, (LONG)value);
 }
 
 static inline uint32_t StcAtomicUint32Increment(StcAtomicUint32* const pA) { return (uint32_t)_InterlockedIncrement(&pA->storage); }
 
+static inline uint32_t StcAtomicUint32IncrementRelease(StcAtomicUint32* const pA) {
+    return (uint32_t)_InterlockedIncrement(&pA->storage);
+}
+
+static inline uint32_t StcAtomicUint32AddRelease(StcAtomicUint32* const pA, const uint32_t value) {
+    return (uint32_t)(_InterlockedExchangeAdd(&pA->storage, (LONG)value) + (LONG)value);
+}
+
 static inline uint32_t StcAtomicUint32Decrement(StcAtomicUint32* const pA) { return (uint32_t)_InterlockedDecrement(&pA->storage); }
 
+static inline uint32_t StcAtomicUint32DecrementRelaxed(StcAtomicUint32* const pA) {
+    return (uint32_t)_InterlockedDecrement(&pA->storage);
+}
+
+static inline uint32_t StcAtomicUint32CompareExchange(StcAtomicUint32* const pA, const uint32_t exchange, const uint32_t comparand) {
+    return (uint32_t)_InterlockedCompareExchange(&pA->storage, (LONG)exchange, (LONG)comparand);
+}
+
 typedef struct StcAtomicInt64 {
     __declspec(align(8)) volatile LONG64 storage;
 } StcAtomicInt64;
 
-static inline int64_t StcAtomicInt64Load(const StcAtomicInt64* const pA) {
+static inline int64_t StcAtomicInt64LoadRelaxed(const StcAtomicInt64* const pA) {
 #ifdef _M_IX86
-    const long long bytes = __iso_volatile_load64(&pA->storage);
+    return __iso_volatile_load64(&pA->storage);
 #else
-    const LONG64 bytes = pA->storage;
+    return pA->storage;
 #endif
-    _ReadWriteBarrier();
+}
+
+static inline int64_t StcAtomicInt64Load(const StcAtomicInt64* const pA) {
+    const int64_t bytes = StcAtomicInt64LoadRelaxed(pA);
+    StcAtomicLoadBarrier();
     return bytes;
 }
 
-static inline void StcAtomicInt64StoreRelaxed(StcAtomicInt64* const pA, const int64_t value) { pA->storage = value; }
+static inline void StcAtomicInt64StoreRelaxed(StcAtomicInt64* const pA, const int64_t value) {
+#ifdef _M_IX86
+    __iso_volatile_store64(&pA->storage, value);
+#else
+    pA->storage = value;
+#endif
+}
 
 static inline void StcAtomicInt64Store(StcAtomicInt64* const pA, const int64_t value) {
 #ifdef _M_IX86
@@ -362,66 +636,453 @@ static inline void StcAtomicInt64Store(StcAtomicInt64* const pA, const int64_t v
 #endif
 }
 
+static inline void StcAtomicInt64StoreRelease(StcAtomicInt64* const pA, const int64_t value) {
+#if STC_ATOMIC_STRONG_HARDWARE_ORDER
+    _ReadWriteBarrier();
+    StcAtomicInt64StoreRelaxed(pA, value);
+#else
+    StcAtomicInt64Store(pA, value);
+#endif
+}
+
 static inline int64_t StcAtomicInt64CompareExchange(StcAtomicInt64* const pA, const int64_t exchange, const int64_t comparand) {
     return _InterlockedCompareExchange64(&pA->storage, exchange, comparand);
 }
 
-#define STC_MAJOR_VERSION 0
+// Orders plain accesses around a relaxed atomic, for the seqlock over frame metadata
+static inline void StcAtomicFenceAcquire(void) {
+#if STC_ATOMIC_STRONG_HARDWARE_ORDER
+    _ReadWriteBarrier();
+#else
+    MemoryBarrier();
+#endif
+}
+
+static inline void StcAtomicFenceRelease(void) {
+#if STC_ATOMIC_STRONG_HARDWARE_ORDER
+    _ReadWriteBarrier();
+#else
+    MemoryBarrier();
+#endif
+}
+
+#else
+
+typedef struct StcAtomicBool {
+    volatile char storage;
+} StcAtomicBool;
+
+static inline bool StcAtomicBoolLoadRelaxed(const StcAtomicBool* const pA) {
+    return (bool)__atomic_load_n(&pA->storage, __ATOMIC_RELAXED);
+}
+
+static inline bool StcAtomicBoolLoad(const StcAtomicBool* const pA) { return (bool)__atomic_load_n(&pA->storage, __ATOMIC_ACQUIRE); }
+
+static inline void StcAtomicBoolStoreRelease(StcAtomicBool* const pA, const bool value) {
+    __atomic_store_n(&pA->storage, (char)value, __ATOMIC_RELEASE);
+}
+
+static inline void StcAtomicBoolStore(StcAtomicBool* const pA, const bool value) {
+    __atomic_store_n(&pA->storage, (char)value, __ATOMIC_SEQ_CST);
+}
+
+typedef struct StcAtomicUint32 {
+    volatile int32_t storage;
+} StcAtomicUint32;
+
+static inline uint32_t StcAtomicUint32LoadRelaxed(const StcAtomicUint32* const pA) {
+    return (uint32_t)__atomic_load_n(&pA->storage, __ATOMIC_RELAXED);
+}
+
+static inline uint32_t StcAtomicUint32Load(const StcAtomicUint32* const pA) {
+    return (uint32_t)__atomic_load_n(&pA->storage, __ATOMIC_ACQUIRE);
+}
+
+static inline void StcAtomicUint32StoreRelaxed(StcAtomicUint32* const pA, const uint32_t value) {
+    __atomic_store_n(&pA->storage, (int32_t)value, __ATOMIC_RELAXED);
+}
+
+static inline void StcAtomicUint32StoreRelease(StcAtomicUint32* const pA, const uint32_t value) {
+    __atomic_store_n(&pA->storage, (int32_t)value, __ATOMIC_RELEASE);
+}
+
+static inline void StcAtomicUint32Store(StcAtomicUint32* const pA, const uint32_t value) {
+    __atomic_store_n(&pA->storage, (int32_t)value, __ATOMIC_SEQ_CST);
+}
+
+static inline uint32_t StcAtomicUint32Increment(StcAtomicUint32* const pA) {
+    return (uint32_t)__atomic_add_fetch(&pA->storage, 1, __ATOMIC_SEQ_CST);
+}
+
+static inline uint32_t StcAtomicUint32IncrementRelease(StcAtomicUint32* const pA) {
+    return (uint32_t)__atomic_add_fetch(&pA->storage, 1, __ATOMIC_RELEASE);
+}
+
+static inline uint32_t StcAtomicUint32AddRelease(StcAtomicUint32* const pA, const uint32_t value) {
+    return (uint32_t)__atomic_add_fetch(&pA->storage, (int32_t)value, __ATOMIC_RELEASE);
+}
+
+static inline uint32_t StcAtomicUint32Decrement(StcAtomicUint32* const pA) {
+    return (uint32_t)__atomic_sub_fetch(&pA->storage, 1, __ATOMIC_SEQ_CST);
+}
+
+static inline uint32_t StcAtomicUint32DecrementRelaxed(StcAtomicUint32* const pA) {
+    return (uint32_t)__atomic_sub_fetch(&pA->storage, 1, __ATOMIC_RELAXED);
+}
+
+static inline uint32_t StcAtomicUint32CompareExchange(StcAtomicUint32* const pA, const uint32_t exchange, const uint32_t comparand) {
+    int32_t expected = (int32_t)comparand;
+    __atomic_compare_exchange_n(&pA->storage, &expected, (int32_t)exchange, false, __ATOMIC_SEQ_CST, __ATOMIC_SEQ_CST);
+    return (uint32_t)expected;
+}
+
+typedef struct StcAtomicInt64 {
+    volatile int64_t storage __attribute__((aligned(8)));
+} StcAtomicInt64;
+
+static inline int64_t StcAtomicInt64LoadRelaxed(const StcAtomicInt64* const pA) {
+    return __atomic_load_n(&pA->storage, __ATOMIC_RELAXED);
+}
+
+static inline int64_t StcAtomicInt64Load(const StcAtomicInt64* const pA) { return __atomic_load_n(&pA->storage, __ATOMIC_ACQUIRE); }
+
+static inline void StcAtomicInt64StoreRelaxed(StcAtomicInt64* const pA, const int64_t value) {
+    __atomic_store_n(&pA->storage, value, __ATOMIC_RELAXED);
+}
+
+static inline void StcAtomicInt64StoreRelease(StcAtomicInt64* const pA, const int64_t value) {
+    __atomic_store_n(&pA->storage, value, __ATOMIC_RELEASE);
+}
+
+static inline void StcAtomicInt64Store(StcAtomicInt64* const pA, const int64_t value) {
+    __atomic_store_n(&pA->storage, value, __ATOMIC_SEQ_CST);
+}
+
+static inline int64_t StcAtomicInt64CompareExchange(StcAtomicInt64* const pA, const int64_t exchange, int64_t comparand) {
+    __atomic_compare_exchange_n(&pA->storage, &comparand, exchange, false, __ATOMIC_SEQ_CST, __ATOMIC_SEQ_CST);
+    return comparand;
+}
+
+static inline void StcAtomicFenceAcquire(void) { __atomic_thread_fence(__ATOMIC_ACQUIRE); }
+
+static inline void StcAtomicFenceRelease(void) { __atomic_thread_fence(__ATOMIC_RELEASE); }
+
+#endif
+
+// Only a change the baseline protocol cannot fall back from bumps the major version. Optional features bump the minor
+// version and get a capability bit, so mixed builds keep talking.
+#define STC_MAJOR_VERSION 1
 #define STC_MINOR_VERSION 1
 #define STC_PATCH_VERSION 0
 
-// One 4K page is probably reasonable
-#define STC_MAP_SIZE 4096
+#define STC_SUPPORTED_CAPABILITIES                                                                            \
+    (STC_CAPABILITY_FLAG_MAILBOX | STC_CAPABILITY_FLAG_STREAMS | STC_CAPABILITY_FLAG_FRAME_INTERVAL |         \
+     STC_CAPABILITY_FLAG_LIVE_PARAMETERS | STC_CAPABILITY_FLAG_FRAME_METADATA | STC_CAPABILITY_FLAG_SLICES |  \
+     STC_CAPABILITY_FLAG_CONTROL | STC_CAPABILITY_FLAG_AUX_RECORDS | STC_CAPABILITY_FLAG_RESIZE_GENERATIONS | \
+     STC_CAPABILITY_FLAG_WAKE_DESCRIPTORS)
+
+// Control messages a client can have in flight, a power of two so the free-running indices wrap cleanly
+#define STC_CONTROL_RING_SIZE 16
 
-// Four slots should prevent stuttering
-#define STC_TEXTURE_COUNT 4
+// Two 4K pages, enough for the slot arrays of every stream
+#define STC_MAP_SIZE 8192
+
+// The client picks the ring depth at connect time. Two slots give the lowest latency, more absorb bursty consumers.
+#define STC_MIN_TEXTURE_COUNT 2
+#define STC_MAX_TEXTURE_COUNT 16
+
+// Four slots should prevent stuttering, used when the client does not ask for a depth
+#define STC_DEFAULT_TEXTURE_COUNT 4
+
+static_assert(STC_MIN_TEXTURE_COUNT >= 2, "The ring needs a slot to read while another is written");
+
+// Clients connected to one server at a time. Each one can hold a slot, so a ring serves at most textureCount - 1 of them.
+#define STC_MAX_CLIENT_COUNT 4
+
+// Independent rings one server publishes over the same connection, each with its own size and format. Stream 0 is the
+// one the server is created with, and is what clients get when they do not name any streams.
+#define STC_MAX_STREAM_COUNT 4
+#define STC_STREAM_NAME_SIZE 32
+
+// Upper bound on the per-frame metadata the server is created with. Every slot of every stream reserves the full
+// capacity after StcInfo in each connection mapping.
+#define STC_MAX_METADATA_CAPACITY 65536
+
+// Bytes of auxiliary records in flight to each client, headers included. A power of two so the free-running offsets wrap
+// cleanly, and every connection mapping reserves it after the metadata.
+#define STC_AUX_RING_SIZE 262144
+#define STC_MAX_AUX_RECORD_SIZE (STC_AUX_RING_SIZE / 4)
 
 #define STC_DEFAULT_PREFIX TEXT("StcGC")
 
+// Shared fields are grouped by the side that writes them, and each group starts on its own line so a write by one process
+// does not evict what the other is about to touch. Twice the usual line, since x86 prefetches lines in adjacent pairs and
+// some ARM cores use 128 bytes.
+#define STC_CACHE_LINE_SIZE 128
+#if defined(_MSC_VER)
+#define STC_CACHE_ALIGNED __declspec(align(STC_CACHE_LINE_SIZE))
+#else
+#define STC_CACHE_ALIGNED __attribute__((aligned(STC_CACHE_LINE_SIZE)))
+#endif
+
+// Each side refreshes its keepalive this many times per timeout, rather than on every tick
+#define STC_KEEP_ALIVE_DIVISOR 16
+
+// A resize that keeps being superseded still applies after this many resize delays, so a long drag is not frozen at the
+// size it started from
+#define STC_RESIZE_MAX_DELAYS 4
+
+// Long enough to cover the gap between the steps of a window drag, short enough to go unnoticed after a single resize
+#define STC_DEFAULT_RESIZE_DELAY_MICROSECONDS 50000
+
+// CPU frames keep their header in the first 256 bytes, and rows are padded to match
+#define STC_CPU_DATA_OFFSET 256
+#define STC_CPU_ROW_ALIGNMENT 256
+
 #pragma warning(push)
+#pragma warning(disable : 4324)
 #pragma warning(disable : 4820)
 
+// Bumped by whoever changes state the other side is waiting on. Waiters count themselves in so the signaller can skip the wake.
+typedef struct StcWakeWord {
+    StcAtomicUint32 sequence;
+    StcAtomicUint32 waiters;
+} StcWakeWord;
+
+// Everything up to capabilities stays put across minor versions. Later fields are only meaningful if the capability that
+// introduced them was advertised.
 typedef struct StcGlobalInfo {
     int version;
     StcApi serverApi;
+    uint32_t minorVersion;
+    StcCapabilityFlags capabilities;
     StcAtomicInt64 connectToken;
+
+    // Signalled by every connection, so the server can wait on all of its clients at once
+    StcWakeWord serverWake;
+
+    // Server AddStream initialized, names are written before streamCount is released
+    char streamNames[STC_MAX_STREAM_COUNT][STC_STREAM_NAME_SIZE];
+    StcAtomicUint32 streamCount;
+
+    // Server Create initialized, clients need it to size the connection mapping
+    uint32_t metadataCapacity;
 } StcGlobalInfo;
 
 static_assert(sizeof(StcGlobalInfo) < STC_MAP_SIZE, "Shared memory size is out of control");
 
+// Frame telemetry for one slot, written by the server as it publishes. Ordered by the slot's state word like the frame
+// itself, so no atomics are needed.
+typedef struct StcFrameRecord {
+    uint64_t sequence;
+    int64_t publishTicks;
+    uint32_t sliceCount;
+    uint32_t resizeGeneration;
+} StcFrameRecord;
+
+// The client's half of the telemetry, kept apart so marking a frame read does not touch the server's lines
+typedef struct StcFrameReadTicks {
+    int64_t acquireTicks;
+    int64_t releaseTicks;
+} StcFrameReadTicks;
+
+// Each client has a state word per slot with its owner in the low bits and, once published, the frame sequence above them.
+// Only the server takes a slot out of FREE and only the client takes one out of READING. Both sides may take a READY slot
+// in mailbox mode or when several clients share the ring, so leaving READY is always a compare-exchange.
+#define STC_SLOT_STATE_FREE 0u
+#define STC_SLOT_STATE_WRITING 1u
+#define STC_SLOT_STATE_READY 2u
+#define STC_SLOT_STATE_READING 3u
+#define STC_SLOT_STATE_MASK 3u
+
+static inline uint32_t StcSlotMakeState(const uint32_t state, const uint64_t sequence) { return ((uint32_t)sequence << 2) | state; }
+
+// Wrap-safe comparison of the sequences in two published state words
+static inline bool StcSlotIsOlder(const uint32_t a, const uint32_t b) {
+    return (int32_t)((a & ~STC_SLOT_STATE_MASK) - (b & ~STC_SLOT_STATE_MASK)) < 0;
+}
+
+// One stream's ring as seen by one client
+typedef struct StcStreamInfo {
+    // Server Tick initialized, rewritten only when frames are recreated
+    uint32_t hTextures[STC_MAX_TEXTURE_COUNT];
+    uint32_t hWriteFences12[STC_MAX_TEXTURE_COUNT];
+    uint32_t hReadFences12[STC_MAX_TEXTURE_COUNT];
+    bool invalidated[STC_MAX_TEXTURE_COUNT];
+
+    // Server MakeConnection initialized, written by both sides on every frame by design
+    STC_CACHE_ALIGNED StcAtomicUint32 slotStates[STC_MAX_TEXTURE_COUNT];
+
+    // Server SignalWrite initialized, the start of the lines only the server writes on every frame
+    STC_CACHE_ALIGNED uint64_t writeFenceValues12[STC_MAX_TEXTURE_COUNT];
+    StcFrameRecord frameRecords[STC_MAX_TEXTURE_COUNT];
+
+    // Server SignalSlice/SignalWrite initialized, how many of the frame's slices are finished. A slice reader can see the
+    // frame at its first slice, everyone else only once all of them are done.
+    StcAtomicUint32 sliceProgress[STC_MAX_TEXTURE_COUNT];
+    // Server publish initialized along with frameRecords, the rows per slice or the whole height if the frame is not sliced
+    UINT sliceHeights[STC_MAX_TEXTURE_COUNT];
+
+    // Client SignalRead initialized, the start of the lines only the client writes on every frame
+    STC_CACHE_ALIGNED uint64_t readFenceValues12[STC_MAX_TEXTURE_COUNT];
+
+    // Client Tick/SignalRead initialized
+    StcFrameReadTicks frameReadTicks[STC_MAX_TEXTURE_COUNT];
+
+    // Client RetainFrame/ReleaseFrame initialized
+    StcAtomicUint32 leaseCount;
+} StcStreamInfo;
+
 typedef struct StcInfo {
-    // Client Connect intialized
+    // Client Connect intialized. Everything up to serverKeepAlive is written once or rarely.
     StcBindFlags clientBindFlags;
     StcSrgbChannelType srgbChannelType;
     StcApi clientApi;
+    // Replaced by the server before serverInitialized if other clients already fixed the ring depth
+    uint32_t textureCount;
+    StcSwapMode swapMode;
+    // Bit i subscribes to server stream i
+    uint32_t streamMask;
+    // The subset of the server's capabilities the client will use on this connection
+    uint32_t clientMinorVersion;
+    StcCapabilityFlags clientCapabilities;
     StcAtomicBool clientParametersSpecified;
 
-    // Server Tick initialized
-    uint32_t hTextures[STC_TEXTURE_COUNT];
-    uint32_t hWriteFences12[STC_TEXTURE_COUNT];
-    uint32_t hReadFences12[STC_TEXTURE_COUNT];
-    UINT64 writeFenceValues12[STC_TEXTURE_COUNT];
-    UINT64 readFenceValues12[STC_TEXTURE_COUNT];
-    bool invalidated[STC_TEXTURE_COUNT];
-
-    // Server MakeConnection initialized
-    StcAtomicUint32 pendingWrites;
-    StcAtomicUint32 pendingReads;
-    StcAtomicInt64 serverKeepAlive;
+    // Client Connect/SetFrameInterval initialized, 0 takes every frame the server renders
+    StcAtomicUint32 frameIntervalMicroseconds;
+
+    // Client UpdateParameters initialized, the server adopts the requested values whenever the generation changes
+    StcAtomicUint32 requestedBindFlags;
+    StcAtomicUint32 requestedSrgbChannelType;
+    StcAtomicUint32 parameterGeneration;
+
+    // Server MakeConnection initialized, the start of the lines only the server writes. Refreshed STC_KEEP_ALIVE_DIVISOR
+    // times per timeout.
+    STC_CACHE_ALIGNED StcAtomicInt64 serverKeepAlive;
 
     // Server Tick initialized
     StcAtomicBool serverInitialized;
     StcAtomicUint32 serverStopReason;
+    // Frames the client may retain per stream, its share of the slots no reader or writer needs
+    StcAtomicUint32 leaseLimit;
+
+    // Server Tick initialized, how far the server has read controlMessages
+    StcAtomicUint32 controlHead;
+
+    // Server WriteAuxRecord initialized. The auxiliary ring is single producer, single consumer like controlMessages but
+    // the other way round, with free-running byte offsets. The server releases auxTail past each record it writes and the
+    // client releases auxHead once it has read one.
+    StcAtomicUint32 auxTail;
 
-    // Client Connect/Tick initialized
-    StcAtomicInt64 clientKeepAlive;
+    // Client Connect/Tick initialized, the start of the lines only the client writes. Refreshed STC_KEEP_ALIVE_DIVISOR
+    // times per timeout.
+    STC_CACHE_ALIGNED StcAtomicInt64 clientKeepAlive;
 
     // Client Disconnect initialized
     StcAtomicUint32 clientStopReason;
+
+    // Client SendControl initialized, how far the client has written controlMessages
+    StcAtomicUint32 controlTail;
+
+    // Client ReadAuxRecord initialized
+    StcAtomicUint32 auxHead;
+
+    // Server MakeConnection initialized. The server bumps the sequence and the client counts itself in as a waiter.
+    STC_CACHE_ALIGNED StcWakeWord clientWake;
+
+    // Single producer, single consumer. The client writes a message and then releases controlTail past it, the server
+    // releases controlHead once it has copied messages out. Both indices run freely and are masked into the ring.
+    STC_CACHE_ALIGNED StcControlMessage controlMessages[STC_CONTROL_RING_SIZE];
+
+    // Indexed by server stream, entries the client did not subscribe to stay unused
+    StcStreamInfo streams[STC_MAX_STREAM_COUNT];
 } StcInfo;
 
 static_assert(sizeof(StcInfo) < STC_MAP_SIZE, "Shared memory size is out of control");
 
+// Header of one slot's metadata, followed by the data itself. The slot state already keeps the server out while a client
+// reads, and the seqlock lets the client prove the copy it took was not torn anyway. frameSequence tells a client whether
+// the metadata belongs to the frame it holds or was left behind by an earlier one.
+typedef struct StcFrameMetadata {
+    StcAtomicUint32 lock;
+    uint32_t size;
+    uint64_t frameSequence;
+} StcFrameMetadata;
+
+static inline size_t StcGetMetadataStride(const size_t capacity) {
+    return sizeof(StcFrameMetadata) + ((capacity + sizeof(StcFrameMetadata) - 1) & ~(sizeof(StcFrameMetadata) - 1));
+}
+
+static inline size_t StcGetAuxRingOffset(const size_t capacity) {
+    return (capacity > 0) ? (STC_MAP_SIZE + (STC_MAX_STREAM_COUNT * STC_MAX_TEXTURE_COUNT * StcGetMetadataStride(capacity)))
+                          : STC_MAP_SIZE;
+}
+
+// A client that did not negotiate auxiliary records maps only up to the ring
+static inline size_t StcGetConnectionMapSize(const size_t capacity, const bool auxRecords) {
+    return StcGetAuxRingOffset(capacity) + (auxRecords ? STC_AUX_RING_SIZE : 0);
+}
+
+static inline StcFrameMetadata* StcGetFrameMetadata(StcInfo* const pInfo, const size_t capacity, const size_t stream,
+                                                    const size_t slot) {
+    const size_t offset = STC_MAP_SIZE + (((stream * STC_MAX_TEXTURE_COUNT) + slot) * StcGetMetadataStride(capacity));
+    return (StcFrameMetadata*)((char*)pInfo + offset);
+}
+
+// Each record starts at a multiple of the header size, so there is always room for a header before the ring wraps. A
+// record that would run past the end is preceded by a STC_AUX_RECORD_TYPE_WRAP header filling the rest of the ring.
+typedef struct StcAuxRecordHeader {
+    uint32_t type;
+    uint32_t size;
+    uint32_t stream;
+    uint32_t droppedBefore;
+    int64_t ticks;
+    uint64_t frameSequence;
+} StcAuxRecordHeader;
+
+#define STC_AUX_RECORD_TYPE_WRAP 0xFFFFFFFFu
+
+static_assert((STC_AUX_RING_SIZE & (STC_AUX_RING_SIZE - 1)) == 0, "Auxiliary offsets wrap on a power of two");
+
+static inline uint32_t StcGetAuxRecordStride(const size_t size) {
+    return (uint32_t)(sizeof(StcAuxRecordHeader) +
+                      ((size + sizeof(StcAuxRecordHeader) - 1) & ~(sizeof(StcAuxRecordHeader) - 1)));
+}
+
+static inline char* StcGetAuxRing(StcInfo* const pInfo, const size_t metadataCapacity) {
+    return (char*)pInfo + StcGetAuxRingOffset(metadataCapacity);
+}
+
+static inline StcAuxRecordHeader* StcGetAuxRecordHeader(char* const pRing, const uint32_t offset) {
+    return (StcAuxRecordHeader*)(pRing + (offset & (STC_AUX_RING_SIZE - 1)));
+}
+
+typedef struct StcCpuFrameHeader {
+    // Software keyed mutex, see StcCpuKeyAcquire
+    StcAtomicUint32 key;
+
+    // Server Tick initialized
+    UINT width;
+    UINT height;
+    StcFormat format;
+    uint32_t rowPitch;
+} StcCpuFrameHeader;
+
+static_assert(sizeof(StcCpuFrameHeader) <= STC_CPU_DATA_OFFSET, "CPU frame header overlaps pixel data");
+
+// Channel message announcing CPU frames of one stream created together. Descriptors are attached in slot order for each
+// nonzero entry.
+typedef struct StcCpuFrameBatch {
+    uint32_t stream;
+    uint32_t generations[STC_MAX_TEXTURE_COUNT];
+} StcCpuFrameBatch;
+
+// First channel message each way once STC_CAPABILITY_FLAG_WAKE_DESCRIPTORS is negotiated. The attached eventfd backs the
+// sender's wake word, so the receiver writes it whenever it signals that word.
+typedef struct StcWakeDescriptorMessage {
+    uint32_t reserved;
+} StcWakeDescriptorMessage;
+
 #pragma warning(pop)
 
 #ifdef __cplusplus
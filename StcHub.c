@@ -0,0 +1,288 @@
+/*
+ * Copyright 2020 Lag Free Games, LLC
+ * All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sub license, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the
+ * next paragraph) shall be included in all copies or substantial portions
+ * of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT.
+ * IN NO EVENT SHALL VMWARE AND/OR ITS SUPPLIERS BE LIABLE FOR
+ * ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include "StcHub.h"
+
+#include <string.h>
+
+#pragma warning(disable : 4710)
+#pragma warning(disable : 4711)
+#pragma warning(disable : 5045)
+
+void StcHubCreateCpu(StcHub* const pHub, StcClientCpu* const pClient, const size_t stream) {
+    memset(pHub, 0, sizeof(*pHub));
+    pHub->api = STC_API_CPU;
+    pHub->pCpuClient = pClient;
+    pHub->stream = stream;
+}
+
+#ifdef _WIN32
+void StcHubCreateD3D11(StcHub* const pHub, StcClientD3D11* const pClient) {
+    memset(pHub, 0, sizeof(*pHub));
+    pHub->api = STC_API_D3D11;
+    pHub->pD3D11Client = pClient;
+}
+#endif
+
+static void ReleaseEntry(StcHub* const pHub, const size_t index) {
+    StcHubEntry* const pEntry = &pHub->entries[index];
+    pEntry->live = false;
+    if (pHub->api == STC_API_CPU) {
+        StcClientCpuReleaseFrame(pHub->pCpuClient, &pEntry->lease);
+#ifdef _WIN32
+    } else {
+        StcClientD3D11ReleaseFrame(pHub->pD3D11Client, &pEntry->lease);
+#endif
+    }
+}
+
+// A frame is kept while anyone holds it, while an in-order subscriber has yet to reach it, or as the newest frame for
+// subscribers that only want the latest
+static void CollectEntries(StcHub* const pHub) {
+    for (size_t index = 0; index < STC_MAX_TEXTURE_COUNT; ++index) {
+        const StcHubEntry* const pEntry = &pHub->entries[index];
+        if (pEntry->live && (pEntry->refCount == 0) && (pEntry->frame.sequence != pHub->newestSequence)) {
+            bool wanted = false;
+            for (size_t i = 0; !wanted && (i < STC_HUB_MAX_SUBSCRIBERS); ++i) {
+                const StcHubSubscriber* const pSubscriber = &pHub->subscribers[i];
+                wanted = pSubscriber->active && (pSubscriber->policy == STC_HUB_DROP_POLICY_IN_ORDER) &&
+                         (pSubscriber->cursor < pEntry->frame.sequence);
+            }
+
+            if (!wanted) {
+                ReleaseEntry(pHub, index);
+            }
+        }
+    }
+}
+
+// Gives back the oldest frame nobody holds, even if an in-order subscriber still wanted it
+static bool EvictEntry(StcHub* const pHub) {
+    size_t oldestIndex = STC_MAX_TEXTURE_COUNT;
+    for (size_t index = 0; index < STC_MAX_TEXTURE_COUNT; ++index) {
+        const StcHubEntry* const pEntry = &pHub->entries[index];
+        if (pEntry->live && (pEntry->refCount == 0) &&
+            ((oldestIndex == STC_MAX_TEXTURE_COUNT) || (pEntry->frame.sequence < pHub->entries[oldestIndex].frame.sequence))) {
+            oldestIndex = index;
+        }
+    }
+
+    if (oldestIndex != STC_MAX_TEXTURE_COUNT) {
+        ReleaseEntry(pHub, oldestIndex);
+    }
+
+    return oldestIndex != STC_MAX_TEXTURE_COUNT;
+}
+
+void StcHubReset(StcHub* const pHub) {
+    for (size_t index = 0; index < STC_MAX_TEXTURE_COUNT; ++index) {
+        if (pHub->entries[index].live) {
+            ReleaseEntry(pHub, index);
+        }
+
+        pHub->entries[index].refCount = 0;
+    }
+
+    for (size_t i = 0; i < STC_HUB_MAX_SUBSCRIBERS; ++i) {
+        StcHubSubscriber* const pSubscriber = &pHub->subscribers[i];
+        pSubscriber->cursor = 0;
+        for (size_t index = 0; index < STC_MAX_TEXTURE_COUNT; ++index) {
+            pSubscriber->refCounts[index] = 0;
+        }
+    }
+
+    pHub->lastSequence = 0;
+    pHub->newestSequence = 0;
+}
+
+void StcHubDestroy(StcHub* const pHub) { StcHubReset(pHub); }
+
+// Returns the frame the client holds, whether or not it is new
+static StcClientStatus TickClient(StcHub* const pHub, StcHubFrame* const pFrame, bool* const pHasFrame) {
+    StcClientStatus status = STC_CLIENT_STATUS_FAIL_NOT_CONNECTED;
+    memset(pFrame, 0, sizeof(*pFrame));
+    if (pHub->api == STC_API_CPU) {
+        StcClientCpuNextInfo nextInfo;
+        status = StcClientCpuTickStream(pHub->pCpuClient, pHub->stream, &nextInfo);
+        *pHasFrame = (status == STC_CLIENT_STATUS_SUCCESS) && (nextInfo.pData != NULL);
+        pFrame->index = nextInfo.index;
+        pFrame->sequence = nextInfo.sequence;
+        pFrame->pData = nextInfo.pData;
+        pFrame->rowPitch = nextInfo.rowPitch;
+        pFrame->width = nextInfo.width;
+        pFrame->height = nextInfo.height;
+        pFrame->format = nextInfo.format;
+#ifdef _WIN32
+    } else {
+        StcClientD3D11NextInfo nextInfo;
+        status = StcClientD3D11Tick(pHub->pD3D11Client, &nextInfo);
+        *pHasFrame = (status == STC_CLIENT_STATUS_SUCCESS) && (nextInfo.pTexture != NULL);
+        pFrame->index = nextInfo.index;
+        pFrame->sequence = nextInfo.sequence;
+        pFrame->pTexture = nextInfo.pTexture;
+#endif
+    }
+
+    return status;
+}
+
+// The hub reads each frame once on behalf of every subscriber. The lease outlives SignalRead, and for D3D11 it keeps the
+// keyed mutex so subscribers can use the texture without one.
+static StcClientStatus RetainNewFrame(StcHub* const pHub, StcClientFrameLease* const pLease, bool* const pRetained) {
+    StcClientStatus status = STC_CLIENT_STATUS_FAIL_NOT_CONNECTED;
+    *pRetained = false;
+    if (pHub->api == STC_API_CPU) {
+        StcClientCpu* const pClient = pHub->pCpuClient;
+        status = StcClientCpuWaitForServerWriteStream(pClient, pHub->stream);
+        if (status == STC_CLIENT_STATUS_SUCCESS) {
+            StcClientStatus retainStatus;
+            while (((retainStatus = StcClientCpuRetainFrameStream(pClient, pHub->stream, pLease)) ==
+                    STC_CLIENT_STATUS_FAIL_LEASE_LIMIT) &&
+                   EvictEntry(pHub)) {
+            }
+
+            *pRetained = retainStatus == STC_CLIENT_STATUS_SUCCESS;
+            status = StcClientCpuSignalReadStream(pClient, pHub->stream);
+        }
+#ifdef _WIN32
+    } else {
+        StcClientD3D11* const pClient = pHub->pD3D11Client;
+        status = StcClientD3D11WaitForServerWrite(pClient);
+        if (status == STC_CLIENT_STATUS_SUCCESS) {
+            StcClientStatus retainStatus;
+            while (((retainStatus = StcClientD3D11RetainFrame(pClient, pLease)) == STC_CLIENT_STATUS_FAIL_LEASE_LIMIT) &&
+                   EvictEntry(pHub)) {
+            }
+
+            *pRetained = retainStatus == STC_CLIENT_STATUS_SUCCESS;
+            status = StcClientD3D11SignalRead(pClient);
+        }
+#endif
+    }
+
+    return status;
+}
+
+StcClientStatus StcHubTick(StcHub* const pHub) {
+    StcHubFrame frame;
+    bool hasFrame;
+    StcClientStatus status = TickClient(pHub, &frame, &hasFrame);
+    if (status == STC_CLIENT_STATUS_SUCCESS) {
+        if (hasFrame && (frame.sequence != pHub->lastSequence)) {
+            pHub->lastSequence = frame.sequence;
+
+            StcClientFrameLease lease;
+            bool retained;
+            status = RetainNewFrame(pHub, &lease, &retained);
+            if ((status == STC_CLIENT_STATUS_SUCCESS) && retained) {
+                StcHubEntry* const pEntry = &pHub->entries[frame.index];
+                pEntry->live = true;
+                pEntry->lease = lease;
+                pEntry->frame = frame;
+                pEntry->refCount = 0;
+                pHub->newestSequence = frame.sequence;
+
+                CollectEntries(pHub);
+            }
+        }
+    }
+
+    // The client has already disconnected itself, so only the bookkeeping is left
+    if (status != STC_CLIENT_STATUS_SUCCESS) {
+        StcHubReset(pHub);
+    }
+
+    return status;
+}
+
+StcClientStatus StcHubSubscribe(StcHub* const pHub, const StcHubDropPolicy policy, size_t* const pSubscriberIndex) {
+    StcClientStatus status = STC_CLIENT_STATUS_FAIL_HUB_FULL;
+
+    for (size_t i = 0; (status != STC_CLIENT_STATUS_SUCCESS) && (i < STC_HUB_MAX_SUBSCRIBERS); ++i) {
+        StcHubSubscriber* const pSubscriber = &pHub->subscribers[i];
+        if (!pSubscriber->active) {
+            memset(pSubscriber, 0, sizeof(*pSubscriber));
+            pSubscriber->active = true;
+            pSubscriber->policy = policy;
+            *pSubscriberIndex = i;
+            status = STC_CLIENT_STATUS_SUCCESS;
+        }
+    }
+
+    return status;
+}
+
+void StcHubUnsubscribe(StcHub* const pHub, const size_t subscriber) {
+    StcHubSubscriber* const pSubscriber = &pHub->subscribers[subscriber];
+    for (size_t index = 0; index < STC_MAX_TEXTURE_COUNT; ++index) {
+        pHub->entries[index].refCount -= pSubscriber->refCounts[index];
+        pSubscriber->refCounts[index] = 0;
+    }
+
+    pSubscriber->active = false;
+    CollectEntries(pHub);
+}
+
+StcClientStatus StcHubAcquire(StcHub* const pHub, const size_t subscriber, StcHubFrame* const pFrame) {
+    StcClientStatus status = STC_CLIENT_STATUS_FAIL_NO_FRAME;
+
+    StcHubSubscriber* const pSubscriber = &pHub->subscribers[subscriber];
+    const bool latest = pSubscriber->policy == STC_HUB_DROP_POLICY_LATEST;
+    size_t pickIndex = STC_MAX_TEXTURE_COUNT;
+    for (size_t index = 0; index < STC_MAX_TEXTURE_COUNT; ++index) {
+        const StcHubEntry* const pEntry = &pHub->entries[index];
+        if (pEntry->live && (pEntry->frame.sequence > pSubscriber->cursor) &&
+            ((pickIndex == STC_MAX_TEXTURE_COUNT) ||
+             ((pEntry->frame.sequence > pHub->entries[pickIndex].frame.sequence) == latest))) {
+            pickIndex = index;
+        }
+    }
+
+    if (pickIndex != STC_MAX_TEXTURE_COUNT) {
+        StcHubEntry* const pEntry = &pHub->entries[pickIndex];
+        *pFrame = pEntry->frame;
+        pFrame->framesSkipped = (pSubscriber->cursor != 0) ? (uint32_t)(pEntry->frame.sequence - pSubscriber->cursor - 1) : 0;
+
+        pSubscriber->cursor = pEntry->frame.sequence;
+        ++pSubscriber->refCounts[pickIndex];
+        ++pEntry->refCount;
+
+        CollectEntries(pHub);
+        status = STC_CLIENT_STATUS_SUCCESS;
+    }
+
+    return status;
+}
+
+void StcHubRelease(StcHub* const pHub, const size_t subscriber, const StcHubFrame* const pFrame) {
+    StcHubSubscriber* const pSubscriber = &pHub->subscribers[subscriber];
+    StcHubEntry* const pEntry = &pHub->entries[pFrame->index];
+    if (pEntry->live && (pEntry->frame.sequence == pFrame->sequence) && (pSubscriber->refCounts[pFrame->index] > 0)) {
+        --pSubscriber->refCounts[pFrame->index];
+        --pEntry->refCount;
+
+        CollectEntries(pHub);
+    }
+}
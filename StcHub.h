@@ -0,0 +1,122 @@
+/*
+ * Copyright 2020 Lag Free Games, LLC
+ * All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sub license, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the
+ * next paragraph) shall be included in all copies or substantial portions
+ * of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT.
+ * IN NO EVENT SHALL VMWARE AND/OR ITS SUPPLIERS BE LIABLE FOR
+ * ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#pragma once
+
+#include "StcClient.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#pragma warning(push)
+#pragma warning(disable : 4820)
+
+// A hub owns one client connection and shares its frames with any number of consumers in the same process. It is driven
+// from one thread like the client it wraps, and subscribers are cursors into the frames it holds rather than threads.
+#define STC_HUB_MAX_SUBSCRIBERS 8
+
+typedef enum StcHubDropPolicy {
+    // Each acquire returns the newest frame, skipping any the subscriber did not get to
+    STC_HUB_DROP_POLICY_LATEST = 0,
+    // Frames are returned in order, and only skipped once the hub had to give them back to the server
+    STC_HUB_DROP_POLICY_IN_ORDER = 1,
+    STC_HUB_DROP_POLICY_MAX_ENUM = 0x7FFFFFFF,
+} StcHubDropPolicy;
+
+typedef struct StcHubFrame {
+    size_t index;
+    uint64_t sequence;
+    uint32_t framesSkipped;
+
+    // CPU hubs
+    const void* pData;
+    size_t rowPitch;
+    UINT width;
+    UINT height;
+    StcFormat format;
+
+#ifdef _WIN32
+    // D3D11 hubs
+    ID3D11Texture2D* pTexture;
+#endif
+} StcHubFrame;
+
+// One retained slot, indexed by the slot it pins
+typedef struct StcHubEntry {
+    bool live;
+    StcClientFrameLease lease;
+    StcHubFrame frame;
+    uint32_t refCount;
+} StcHubEntry;
+
+typedef struct StcHubSubscriber {
+    // Subscribe initialized
+    bool active;
+    StcHubDropPolicy policy;
+
+    // Acquire initialized
+    uint64_t cursor;
+    uint32_t refCounts[STC_MAX_TEXTURE_COUNT];
+} StcHubSubscriber;
+
+typedef struct StcHub {
+    // Create initialized
+    enum StcApi api;
+    struct StcClientCpu* pCpuClient;
+#ifdef _WIN32
+    struct StcClientD3D11* pD3D11Client;
+#endif
+    size_t stream;
+    StcHubSubscriber subscribers[STC_HUB_MAX_SUBSCRIBERS];
+
+    // Tick initialized
+    uint64_t lastSequence;
+    uint64_t newestSequence;
+    StcHubEntry entries[STC_MAX_TEXTURE_COUNT];
+} StcHub;
+
+#pragma warning(pop)
+
+void StcHubCreateCpu(struct StcHub* pHub, struct StcClientCpu* pClient, size_t stream);
+#ifdef _WIN32
+void StcHubCreateD3D11(struct StcHub* pHub, struct StcClientD3D11* pClient);
+#endif
+void StcHubDestroy(struct StcHub* pHub);
+// Drops every frame and cursor. Tick does this itself when the connection fails, a caller that reconnects the client
+// directly has to call it.
+void StcHubReset(struct StcHub* pHub);
+// Ticks the client in place of the caller, and keeps each new frame for the subscribers once the server finished it
+enum StcClientStatus StcHubTick(struct StcHub* pHub);
+enum StcClientStatus StcHubSubscribe(struct StcHub* pHub, StcHubDropPolicy policy, size_t* pSubscriberIndex);
+void StcHubUnsubscribe(struct StcHub* pHub, size_t subscriber);
+// Fails with STC_CLIENT_STATUS_FAIL_NO_FRAME when the subscriber already has everything its policy would return. The frame
+// stays valid until released, releasing one left over from a dropped connection does nothing.
+enum StcClientStatus StcHubAcquire(struct StcHub* pHub, size_t subscriber, struct StcHubFrame* pFrame);
+void StcHubRelease(struct StcHub* pHub, size_t subscriber, const struct StcHubFrame* pFrame);
+
+#ifdef __cplusplus
+}
+#endif
@@ -23,12 +23,38 @@
  * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
  */
 
+#ifndef _WIN32
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE 1
+#endif
+#endif
+
 #include "StcMisc.h"
 
 #include <stdarg.h>
 
+#ifndef _WIN32
+#include <time.h>
+#include <unistd.h>
+#endif
+
 static const int64_t timeoutInSeconds = 5;
 
+#ifdef STC_VIRTUAL_CLOCK
+// Simulation builds advance time explicitly, in nanoseconds, see bench/StcSimulator.c
+static int64_t virtualTicks;
+
+int64_t StcGetCurrentTicks(void) { return virtualTicks; }
+
+int64_t StcGetTimeoutTicks(void) { return 1000000000 * timeoutInSeconds; }
+
+int64_t StcGetTickFrequency(void) { return 1000000000; }
+
+void StcSetVirtualTicks(const int64_t ticks) { virtualTicks = ticks; }
+#endif
+
+#ifdef _WIN32
+#ifndef STC_VIRTUAL_CLOCK
 int64_t StcGetCurrentTicks(void) {
     LARGE_INTEGER count;
     QueryPerformanceCounter(&count);
@@ -41,13 +67,81 @@ int64_t StcGetTimeoutTicks(void) {
     return frequency.QuadPart * timeoutInSeconds;
 }
 
+int64_t StcGetTickFrequency(void) {
+    LARGE_INTEGER frequency;
+    QueryPerformanceFrequency(&frequency);
+    return frequency.QuadPart;
+}
+#endif
+
+uint32_t StcGetCurrentProcessId(void) { return (uint32_t)GetCurrentProcessId(); }
+#else
+#ifndef STC_VIRTUAL_CLOCK
+int64_t StcGetCurrentTicks(void) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return ((int64_t)now.tv_sec * 1000000000) + now.tv_nsec;
+}
+
+int64_t StcGetTimeoutTicks(void) { return 1000000000 * timeoutInSeconds; }
+
+int64_t StcGetTickFrequency(void) { return 1000000000; }
+#endif
+
+uint32_t StcGetCurrentProcessId(void) { return (uint32_t)getpid(); }
+#endif
+
 static const char* pApiNames[] = {
     "D3D11",
     "D3D12",
+    "CPU",
 };
 
 const char* StcGetApiName(const StcApi api) { return pApiNames[api]; }
 
+bool StcIsClientApiSupported(const StcApi serverApi, const StcApi clientApi) {
+    // D3D11 and D3D12 interoperate through shared handles, but CPU frames are plain shared memory
+    return (serverApi == STC_API_CPU) == (clientApi == STC_API_CPU);
+}
+
+size_t StcComputeCpuRowPitch(const UINT width, const StcFormat format) {
+    const size_t bytesPerPixel = (format == STC_FORMAT_R16G16B16A16_FLOAT) ? 8 : 4;
+    return ((width * bytesPerPixel) + (STC_CPU_ROW_ALIGNMENT - 1)) & ~(size_t)(STC_CPU_ROW_ALIGNMENT - 1);
+}
+
+// Every slice but the last has this many rows, so both sides agree on where slices start without sharing a table
+UINT StcComputeSliceHeight(const UINT height, const uint32_t sliceCount) {
+    return (sliceCount > 1) ? ((height + sliceCount - 1) / sliceCount) : height;
+}
+
+bool StcFormatCpuFrameName(TCHAR* const pBuffer, const size_t count, const TCHAR* const pGlobalName, const size_t index,
+                           const uint32_t generation) {
+    const int result = stc_stprintf(pBuffer, count, TEXT("%") STC_TSTRINGWIDTH TEXT("s_%u_%u"), pGlobalName, (unsigned)index,
+                                    (unsigned)generation);
+    return (result >= 0) && ((size_t)result < count);
+}
+
+bool StcCpuKeyAcquire(StcAtomicUint32* const pKey, const uint32_t key, uint32_t* const pObserved) {
+    *pObserved = StcAtomicUint32CompareExchange(pKey, key | STC_KEY_OWNED_BIT, key);
+    return *pObserved == key;
+}
+
+bool StcCpuKeyRelease(StcAtomicUint32* const pKey, const uint32_t key, uint32_t* const pObserved) {
+    *pObserved = StcAtomicUint32LoadRelaxed(pKey);
+    const bool owned = (*pObserved & STC_KEY_OWNED_BIT) != 0;
+    if (owned) {
+        StcAtomicUint32StoreRelease(pKey, key);
+    }
+
+    return owned;
+}
+
+// Readers share a frame, so they only confirm the server handed it over and never take the owned bit
+bool StcCpuKeyCheck(const StcAtomicUint32* const pKey, const uint32_t key, uint32_t* const pObserved) {
+    *pObserved = StcAtomicUint32Load(pKey);
+    return *pObserved == key;
+}
+
 typedef struct MessageInfo {
     StcMessageCategory category;
     StcMessageSeverity severity;
@@ -75,6 +169,24 @@ static const MessageInfo pInfos[] = {
         "SERVER_FAIL_MAP_GLOBAL_INFO",
         "Failed to map view of global mapping: %d",
     },
+    {
+        STC_MESSAGE_CATEGORY_SERVER_CREATE,
+        STC_MESSAGE_SEVERITY_ERROR,
+        "SERVER_FAIL_CREATE_WAKE_EVENT",
+        "Failed to create wake event: %d",
+    },
+    {
+        STC_MESSAGE_CATEGORY_SERVER_CREATE,
+        STC_MESSAGE_SEVERITY_ERROR,
+        "SERVER_FAIL_ADD_STREAM",
+        "Failed to add stream \"%s\": %u of %u streams in use, names are limited to %u characters",
+    },
+    {
+        STC_MESSAGE_CATEGORY_SERVER_CREATE,
+        STC_MESSAGE_SEVERITY_ERROR,
+        "SERVER_FAIL_METADATA_CAPACITY",
+        "Frame metadata capacity of %u bytes exceeds the limit of %u bytes",
+    },
     {
         STC_MESSAGE_CATEGORY_SERVER_CREATE,
         STC_MESSAGE_SEVERITY_WARNING,
@@ -201,6 +313,12 @@ static const MessageInfo pInfos[] = {
         "SERVER_CREATE_D3D12_SUCCESS",
         "Successfully created D3D12 server.",
     },
+    {
+        STC_MESSAGE_CATEGORY_SERVER_CREATE,
+        STC_MESSAGE_SEVERITY_INFO,
+        "SERVER_CREATE_CPU_SUCCESS",
+        "Successfully created CPU server.",
+    },
     {
         STC_MESSAGE_CATEGORY_SERVER_DESTROY,
         STC_MESSAGE_SEVERITY_INFO,
@@ -213,6 +331,12 @@ static const MessageInfo pInfos[] = {
         "SERVER_DESTROY_D3D12_SUCCESS",
         "Successfully destroyed D3D12 server.",
     },
+    {
+        STC_MESSAGE_CATEGORY_SERVER_DESTROY,
+        STC_MESSAGE_SEVERITY_INFO,
+        "SERVER_DESTROY_CPU_SUCCESS",
+        "Successfully destroyed CPU server.",
+    },
     {
         STC_MESSAGE_CATEGORY_SERVER_OPEN,
         STC_MESSAGE_SEVERITY_ERROR,
@@ -231,6 +355,12 @@ static const MessageInfo pInfos[] = {
         "SERVER_FAIL_MAP_CONNECTION_INFO",
         "Failed to map view of connection mapping: %d",
     },
+    {
+        STC_MESSAGE_CATEGORY_SERVER_OPEN,
+        STC_MESSAGE_SEVERITY_ERROR,
+        "SERVER_FAIL_CREATE_CHANNEL",
+        "Failed to create connection channel: %d",
+    },
     {
         STC_MESSAGE_CATEGORY_SERVER_OPEN,
         STC_MESSAGE_SEVERITY_INFO,
@@ -249,6 +379,12 @@ static const MessageInfo pInfos[] = {
         "SERVER_D3D12_CONNECTION_RESET",
         "Resetting D3D12 server, discarding client if one is connected.",
     },
+    {
+        STC_MESSAGE_CATEGORY_SERVER_RESET,
+        STC_MESSAGE_SEVERITY_INFO,
+        "SERVER_CPU_CONNECTION_RESET",
+        "Resetting CPU server, discarding client if one is connected.",
+    },
     {
         STC_MESSAGE_CATEGORY_SERVER_TICK,
         STC_MESSAGE_SEVERITY_INFO,
@@ -265,7 +401,55 @@ static const MessageInfo pInfos[] = {
         STC_MESSAGE_CATEGORY_SERVER_TICK,
         STC_MESSAGE_SEVERITY_INFO,
         "SERVER_CONNECT_HANDSHAKE_COMPLETE",
-        "Handshake complete. Connection established.",
+        "Handshake complete. Connection established with %u textures and capabilities 0x%x.",
+    },
+    {
+        STC_MESSAGE_CATEGORY_SERVER_TICK,
+        STC_MESSAGE_SEVERITY_INFO,
+        "SERVER_CLIENT_PARAMETERS_UPDATED",
+        "Client updated bind flags to 0x%x and sRGB channel type to %u. Frames are recreated as their slots come around.",
+    },
+    {
+        STC_MESSAGE_CATEGORY_SERVER_TICK,
+        STC_MESSAGE_SEVERITY_WARNING,
+        "SERVER_CLIENT_CONTROL_OVERRUN",
+        "Client control ring claimed %u pending messages, more than the %u it holds. Only the newest were read.",
+    },
+    {
+        STC_MESSAGE_CATEGORY_SERVER_TICK,
+        STC_MESSAGE_SEVERITY_ERROR,
+        "SERVER_CLIENT_API_UNSUPPORTED",
+        "%s server cannot share frames with %s client.",
+    },
+    {
+        STC_MESSAGE_CATEGORY_SERVER_TICK,
+        STC_MESSAGE_SEVERITY_ERROR,
+        "SERVER_FAIL_ACCEPT_CHANNEL",
+        "Failed to accept client on connection channel: %d",
+    },
+    {
+        STC_MESSAGE_CATEGORY_SERVER_TICK,
+        STC_MESSAGE_SEVERITY_ERROR,
+        "SERVER_FAIL_EXCHANGE_WAKE_DESCRIPTORS",
+        "Failed to exchange wake descriptors with client: %d",
+    },
+    {
+        STC_MESSAGE_CATEGORY_SERVER_TICK,
+        STC_MESSAGE_SEVERITY_ERROR,
+        "SERVER_CLIENT_TEXTURE_COUNT_UNSUPPORTED",
+        "Client requested %u textures, supported range is %d to %d.",
+    },
+    {
+        STC_MESSAGE_CATEGORY_SERVER_TICK,
+        STC_MESSAGE_SEVERITY_ERROR,
+        "SERVER_CLIENT_STREAMS_UNSUPPORTED",
+        "Client requested stream mask 0x%x, server has %u streams.",
+    },
+    {
+        STC_MESSAGE_CATEGORY_SERVER_TICK,
+        STC_MESSAGE_SEVERITY_ERROR,
+        "SERVER_CLIENT_API_UNSHARED",
+        "%s client reads through a keyed mutex, so it cannot join the %u clients already connected.",
     },
     {
         STC_MESSAGE_CATEGORY_SERVER_TICK,
@@ -333,6 +517,18 @@ static const MessageInfo pInfos[] = {
         "SERVER_FAIL_D3D12_RELEASE_KEYED_MUTEX_TO_OWN",
         "Failed to release D3D12 keyed mutex to own. HRESULT: 0x%08lX",
     },
+    {
+        STC_MESSAGE_CATEGORY_SERVER_TICK,
+        STC_MESSAGE_SEVERITY_ERROR,
+        "SERVER_FAIL_CPU_ACQUIRE_KEYED_MUTEX_TO_OWN",
+        "Failed to acquire CPU keyed mutex to own. Key: 0x%08X",
+    },
+    {
+        STC_MESSAGE_CATEGORY_SERVER_TICK,
+        STC_MESSAGE_SEVERITY_ERROR,
+        "SERVER_FAIL_CPU_RELEASE_KEYED_MUTEX_TO_OWN",
+        "Failed to release CPU keyed mutex to own. Key: 0x%08X",
+    },
     {
         STC_MESSAGE_CATEGORY_SERVER_FRAME_CREATE,
         STC_MESSAGE_SEVERITY_INFO,
@@ -369,6 +565,36 @@ static const MessageInfo pInfos[] = {
         "SERVER_D3D12_CREATE_FRAME_SUCCESS",
         "Successfully created D3D12 frame of resources. Index: %d",
     },
+    {
+        STC_MESSAGE_CATEGORY_SERVER_FRAME_CREATE,
+        STC_MESSAGE_SEVERITY_INFO,
+        "SERVER_CPU_CREATE_FRAME_ATTEMPT",
+        "Attempting to create CPU frame of resources. Index: %d",
+    },
+    {
+        STC_MESSAGE_CATEGORY_SERVER_FRAME_CREATE,
+        STC_MESSAGE_SEVERITY_ERROR,
+        "SERVER_FAIL_CPU_CREATE_BUFFER",
+        "Failed to create CPU frame buffer. Index: %d, Error: %d",
+    },
+    {
+        STC_MESSAGE_CATEGORY_SERVER_FRAME_CREATE,
+        STC_MESSAGE_SEVERITY_ERROR,
+        "SERVER_FAIL_CPU_SEND_BUFFERS",
+        "Failed to send CPU frame buffers to client: %d",
+    },
+    {
+        STC_MESSAGE_CATEGORY_SERVER_FRAME_CREATE,
+        STC_MESSAGE_SEVERITY_ERROR,
+        "SERVER_FAIL_CPU_CREATE_FRAME_CALLBACK",
+        "User CPU create callback returned failure. Index: %d",
+    },
+    {
+        STC_MESSAGE_CATEGORY_SERVER_FRAME_CREATE,
+        STC_MESSAGE_SEVERITY_INFO,
+        "SERVER_CPU_CREATE_FRAME_SUCCESS",
+        "Successfully created CPU frame of resources. Index: %d",
+    },
     {
         STC_MESSAGE_CATEGORY_SERVER_WAIT,
         STC_MESSAGE_SEVERITY_ERROR,
@@ -393,6 +619,12 @@ static const MessageInfo pInfos[] = {
         "SERVER_FAIL_D3D12_QUEUE_WAIT",
         "Failed to wait for D3D12 queue before write. HRESULT: 0x%08lX",
     },
+    {
+        STC_MESSAGE_CATEGORY_SERVER_WAIT,
+        STC_MESSAGE_SEVERITY_ERROR,
+        "SERVER_FAIL_CPU_ACQUIRE_KEYED_MUTEX_TO_WRITE",
+        "Failed to acquire CPU keyed mutex to write. Key: 0x%08X",
+    },
     {
         STC_MESSAGE_CATEGORY_SERVER_SIGNAL,
         STC_MESSAGE_SEVERITY_ERROR,
@@ -417,6 +649,12 @@ static const MessageInfo pInfos[] = {
         "SERVER_FAIL_D3D12_QUEUE_SIGNAL",
         "Failed to signal D3D12 queue after write. HRESULT: 0x%08lX",
     },
+    {
+        STC_MESSAGE_CATEGORY_SERVER_SIGNAL,
+        STC_MESSAGE_SEVERITY_ERROR,
+        "SERVER_FAIL_CPU_RELEASE_KEYED_MUTEX_TO_WRITE",
+        "Failed to release CPU keyed mutex after write. Key: 0x%08X",
+    },
     {
         STC_MESSAGE_CATEGORY_CLIENT_CREATE,
         STC_MESSAGE_SEVERITY_INFO,
@@ -435,6 +673,12 @@ static const MessageInfo pInfos[] = {
         "CLIENT_CREATE_D3D12_SUCCESS",
         "Successfully created D3D11 client.",
     },
+    {
+        STC_MESSAGE_CATEGORY_CLIENT_CREATE,
+        STC_MESSAGE_SEVERITY_INFO,
+        "CLIENT_CREATE_CPU_SUCCESS",
+        "Successfully created CPU client.",
+    },
     {
         STC_MESSAGE_CATEGORY_CLIENT_DESTROY,
         STC_MESSAGE_SEVERITY_INFO,
@@ -447,6 +691,12 @@ static const MessageInfo pInfos[] = {
         "CLIENT_DESTROY_D3D12_SUCCESS",
         "Successfully destroyed D3D12 client.",
     },
+    {
+        STC_MESSAGE_CATEGORY_CLIENT_DESTROY,
+        STC_MESSAGE_SEVERITY_INFO,
+        "CLIENT_DESTROY_CPU_SUCCESS",
+        "Successfully destroyed CPU client.",
+    },
     {
         STC_MESSAGE_CATEGORY_CLIENT_FRAME_OPEN,
         STC_MESSAGE_SEVERITY_INFO,
@@ -483,6 +733,24 @@ static const MessageInfo pInfos[] = {
         "CLIENT_D3D12_CREATE_FRAME_SUCCESS",
         "Successfully opened D3D12 frame of resources. Index: %d",
     },
+    {
+        STC_MESSAGE_CATEGORY_CLIENT_FRAME_OPEN,
+        STC_MESSAGE_SEVERITY_INFO,
+        "CLIENT_CPU_OPEN_FRAME_ATTEMPT",
+        "Attempting to open CPU frame of resources. Index: %d",
+    },
+    {
+        STC_MESSAGE_CATEGORY_CLIENT_FRAME_OPEN,
+        STC_MESSAGE_SEVERITY_ERROR,
+        "CLIENT_FAIL_CPU_OPEN_FRAME_CALLBACK",
+        "User CPU create callback returned failure. Index: %d",
+    },
+    {
+        STC_MESSAGE_CATEGORY_CLIENT_FRAME_OPEN,
+        STC_MESSAGE_SEVERITY_INFO,
+        "CLIENT_CPU_OPEN_FRAME_SUCCESS",
+        "Successfully opened CPU frame of resources. Index: %d",
+    },
 };
 
 static const char* const pCategoryNames[] = {
@@ -515,6 +783,13 @@ static const char* const pClientStopReasonDescriptions[] = {
     "Client failed to signal for D3D12 texture read.",
     "User callbcak for D3D11 frame creation failed.",
     "User callbcak for D3D12 frame creation failed.",
+    "Client failed to open a shared CPU frame buffer.",
+    "Client failed to acquire CPU frame buffer before read.",
+    "Client failed to release CPU frame buffer after read.",
+    "User callback for CPU frame creation failed.",
+    "Client failed to receive CPU frame buffers from the server.",
+    "Server reported a texture count outside the supported range.",
+    "Client failed to receive the server's wake descriptor.",
 };
 
 #pragma warning(push)
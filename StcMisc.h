@@ -43,10 +43,26 @@ extern "C" {
 #define STC_KEY_SERVER 1
 #define STC_KEY_CLIENT 2
 
+// Set while a CPU frame is acquired, mirroring a held IDXGIKeyedMutex
+#define STC_KEY_OWNED_BIT 0x80000000u
+
 int64_t StcGetCurrentTicks(void);
 int64_t StcGetTimeoutTicks(void);
+int64_t StcGetTickFrequency(void);
+#ifdef STC_VIRTUAL_CLOCK
+void StcSetVirtualTicks(int64_t ticks);
+#endif
+uint32_t StcGetCurrentProcessId(void);
 
 const char* StcGetApiName(StcApi serverApi);
+bool StcIsClientApiSupported(StcApi serverApi, StcApi clientApi);
+
+size_t StcComputeCpuRowPitch(UINT width, StcFormat format);
+UINT StcComputeSliceHeight(UINT height, uint32_t sliceCount);
+bool StcFormatCpuFrameName(TCHAR* pBuffer, size_t count, const TCHAR* pGlobalName, size_t index, uint32_t generation);
+bool StcCpuKeyAcquire(StcAtomicUint32* pKey, uint32_t key, uint32_t* pObserved);
+bool StcCpuKeyRelease(StcAtomicUint32* pKey, uint32_t key, uint32_t* pObserved);
+bool StcCpuKeyCheck(const StcAtomicUint32* pKey, uint32_t key, uint32_t* pObserved);
 
 void StcLogMessage(const StcMessageCallbacks* pMessenger, StcMessageId id, ...);
 const char* StcGetClientReasonDescription(StcClientStopReason reason);
@@ -27,75 +27,258 @@
 
 #include "StcMisc.h"
 
+#include <string.h>
+#ifdef STC_TRANSPORT_PASSES_DESCRIPTORS
+#include <errno.h>
+#endif
+
 #pragma comment(lib, "d3d11")
 #pragma comment(lib, "dxguid")
 #pragma warning(disable : 4710)
 #pragma warning(disable : 4711)
 #pragma warning(disable : 5045)
 
+// Opens the connection the next client takes through connectToken. Callers make sure one of the connections is closed.
 static StcServerStatus OpenServer(StcServerBase* const pBase, StcGlobalInfo* const pGlobalInfo) {
     StcServerStatus status = STC_SERVER_STATUS_SUCCESS;
 
     const StcMessageCallbacks* const pMessenger = &pBase->messenger;
 
-    TCHAR pNameBuffer[256];
-    const int result = stc_stprintf(pNameBuffer, _countof(pNameBuffer), TEXT("%") STC_TSTRINGWIDTH TEXT("s_%llu"),
-                                    pBase->pNameBuffer, (unsigned long long)pBase->nextConnectToken);
-    if (result < 0 || result >= _countof(pNameBuffer)) {
+    StcServerConnection* pConnection = pBase->connections;
+    while (pConnection->pInfo != NULL) {
+        ++pConnection;
+    }
+
+    TCHAR* const pNameBuffer = pConnection->pConnectionNameBuffer;
+    const int result = stc_stprintf(pNameBuffer, _countof(pConnection->pConnectionNameBuffer),
+                                    TEXT("%") STC_TSTRINGWIDTH TEXT("s_%llu"), pBase->pNameBuffer,
+                                    (unsigned long long)pBase->nextConnectToken);
+    if (result < 0 || (result >= (int)_countof(pConnection->pConnectionNameBuffer))) {
         StcLogMessage(pMessenger, STC_MESSAGE_ID_SERVER_FAIL_CONNECTION_STRING_FORMAT, result);
         status = STC_SERVER_STATUS_FAIL_STRING_FORMAT;
         goto fail0;
     }
 
-    const HANDLE hMapFile = CreateFileMapping(INVALID_HANDLE_VALUE, NULL, PAGE_READWRITE, 0, STC_MAP_SIZE, pNameBuffer);
-    if (hMapFile == NULL) {
-        StcLogMessage(pMessenger, STC_MESSAGE_ID_SERVER_FAIL_CREATE_CONNECTION_FILE_MAPPING, GetLastError());
+    StcMapping mapping;
+    int error;
+    const StcMappingResult mappingResult =
+        StcMappingCreate(&mapping, pNameBuffer, StcGetConnectionMapSize(pBase->metadataCapacity, true), &error);
+    if (mappingResult == STC_MAPPING_RESULT_FAIL_CREATE) {
+        StcLogMessage(pMessenger, STC_MESSAGE_ID_SERVER_FAIL_CREATE_CONNECTION_FILE_MAPPING, error);
         status = STC_SERVER_STATUS_FAIL_CREATE_CONNECTION_FILE_MAPPING;
         goto fail0;
     }
 
-    StcInfo* const pInfo = MapViewOfFile(hMapFile, FILE_MAP_ALL_ACCESS, 0, 0, sizeof(StcInfo));
-    if (pInfo == NULL) {
-        StcLogMessage(pMessenger, STC_MESSAGE_ID_SERVER_FAIL_MAP_CONNECTION_INFO, GetLastError());
+    if (mappingResult != STC_MAPPING_RESULT_SUCCESS) {
+        StcLogMessage(pMessenger, STC_MESSAGE_ID_SERVER_FAIL_MAP_CONNECTION_INFO, error);
         status = STC_SERVER_STATUS_FAIL_MAP_CONNECTION_INFO;
+        goto fail0;
+    }
+
+    StcInfo* const pInfo = mapping.pView;
+
+#ifdef STC_TRANSPORT_PASSES_DESCRIPTORS
+    // A client connects once its parameters are out, so a poller on the wake descriptor sees new clients too
+    StcChannel listener;
+    if (!StcChannelListen(&listener, pNameBuffer, &error)) {
+        StcLogMessage(pMessenger, STC_MESSAGE_ID_SERVER_FAIL_CREATE_CHANNEL, error);
+        status = STC_SERVER_STATUS_FAIL_CREATE_CHANNEL;
         goto fail1;
     }
 
-    StcAtomicUint32StoreRelaxed(&pInfo->pendingWrites, STC_TEXTURE_COUNT - 1);
-    StcAtomicUint32StoreRelaxed(&pInfo->pendingReads, 0);
+    if (!StcEventWatchDescriptor(&pBase->serverWake, listener.fd, &error)) {
+        StcLogMessage(pMessenger, STC_MESSAGE_ID_SERVER_FAIL_CREATE_CHANNEL, error);
+        status = STC_SERVER_STATUS_FAIL_CREATE_CHANNEL;
+        goto fail2;
+    }
+#endif
+
+    // Each client waits on its own event, since an auto-reset event shared by several waiters wakes only one of them
+    TCHAR pEventNameBuffer[_countof(pConnection->pConnectionNameBuffer) + 16];
+    stc_stprintf(pEventNameBuffer, _countof(pEventNameBuffer), TEXT("%") STC_TSTRINGWIDTH TEXT("s_ClientWake"), pNameBuffer);
+    StcEvent clientWake;
+    if (!StcEventCreate(&clientWake, pEventNameBuffer, &error)) {
+        StcLogMessage(pMessenger, STC_MESSAGE_ID_SERVER_FAIL_CREATE_WAKE_EVENT, error);
+        status = STC_SERVER_STATUS_FAIL_CREATE_EVENT;
+        goto fail2;
+    }
+
     StcAtomicInt64StoreRelaxed(&pInfo->serverKeepAlive, StcGetCurrentTicks());
 
     StcAtomicInt64Store(&pGlobalInfo->connectToken, pBase->nextConnectToken);
     ++pBase->nextConnectToken;
 
-    pBase->hMapFile = hMapFile;
-    pBase->pInfo = pInfo;
-    pBase->copyIndex = STC_TEXTURE_COUNT - 1;
-    for (size_t i = 0; i < STC_TEXTURE_COUNT; ++i) {
-        pInfo->writeFenceValues12[i] = 0;
-        pInfo->readFenceValues12[i] = 0;
-        pInfo->invalidated[i] = false;
-        pBase->needResize[i] = true;
+    pConnection->clientInProgress = false;
+    pConnection->connected = false;
+    pConnection->announceFrames = false;
+    pConnection->mapping = mapping;
+#ifdef STC_TRANSPORT_PASSES_DESCRIPTORS
+    pConnection->listener = listener;
+    StcChannelReset(&pConnection->channel);
+#endif
+    pConnection->pInfo = pInfo;
+    pConnection->clientWake = clientWake;
+    pConnection->clientWake.pWord = &pInfo->clientWake;
+    pConnection->swapMode = STC_SWAP_MODE_FIFO;
+    pConnection->streamMask = 0;
+    for (size_t stream = 0; stream < STC_MAX_STREAM_COUNT; ++stream) {
+        pConnection->nextWantedTicks[stream] = 0;
+    }
+    pConnection->parameterGeneration = 0;
+    pConnection->capabilities = STC_CAPABILITY_FLAG_NONE;
+    pConnection->paused = false;
+    pConnection->requestedStreamMask = 0;
+    pConnection->auxDropped = 0;
+    StcAtomicUint32StoreRelaxed(&pInfo->parameterGeneration, 0);
+    StcAtomicUint32StoreRelaxed(&pInfo->controlHead, 0);
+    StcAtomicUint32StoreRelaxed(&pInfo->controlTail, 0);
+    StcAtomicUint32StoreRelaxed(&pInfo->auxHead, 0);
+    StcAtomicUint32StoreRelaxed(&pInfo->auxTail, 0);
+    StcAtomicUint32StoreRelaxed(&pInfo->leaseLimit, 0);
+    for (size_t stream = 0; stream < STC_MAX_STREAM_COUNT; ++stream) {
+        StcStreamInfo* const pStreamInfo = &pInfo->streams[stream];
+        StcAtomicUint32StoreRelaxed(&pStreamInfo->leaseCount, 0);
+        for (size_t i = 0; i < STC_MAX_TEXTURE_COUNT; ++i) {
+            StcAtomicUint32StoreRelaxed(&pStreamInfo->slotStates[i], STC_SLOT_STATE_FREE);
+            pStreamInfo->writeFenceValues12[i] = 0;
+            pStreamInfo->readFenceValues12[i] = 0;
+            pStreamInfo->invalidated[i] = false;
+            pStreamInfo->frameRecords[i].sequence = 0;
+            pStreamInfo->frameRecords[i].sliceCount = 1;
+            pStreamInfo->frameRecords[i].resizeGeneration = 0;
+            pStreamInfo->sliceHeights[i] = 0;
+            StcAtomicUint32StoreRelaxed(&pStreamInfo->sliceProgress[i], 0);
+            if (pBase->metadataCapacity > 0) {
+                StcFrameMetadata* const pMetadata = StcGetFrameMetadata(pInfo, pBase->metadataCapacity, stream, i);
+                StcAtomicUint32StoreRelaxed(&pMetadata->lock, 0);
+                pMetadata->size = 0;
+                pMetadata->frameSequence = 0;
+            }
+        }
+    }
+
+    // The ring depth is unknown until the first client specifies its parameters, so nothing can be written yet
+    if (pBase->clientCount == 0) {
+        pBase->textureCount = 0;
+        for (size_t stream = 0; stream < pBase->streamCount; ++stream) {
+            StcServerStream* const pStream = &pBase->streams[stream];
+            pStream->copyIndex = 0;
+            pStream->frameSequence = 0;
+            for (size_t i = 0; i < STC_MAX_TEXTURE_COUNT; ++i) {
+                pStream->needResize[i] = true;
+            }
+        }
     }
 
     StcLogMessage(pMessenger, STC_MESSAGE_ID_SERVER_CONNECTION_READY);
     goto success;
 
+fail2:
+#ifdef STC_TRANSPORT_PASSES_DESCRIPTORS
+    StcChannelClose(&listener);
+#endif
 fail1:
-    CloseHandle(hMapFile);
+    StcMappingClose(&mapping);
 fail0:
 success:
     return status;
 }
 
+static void CloseConnection(StcServerBase* const pBase, StcServerConnection* const pConnection,
+                            const StcServerStopReason reason) {
+    StcAtomicUint32StoreRelease(&pConnection->pInfo->serverStopReason, reason);
+    StcEventSignal(&pConnection->clientWake);
+
+#ifdef STC_TRANSPORT_PASSES_DESCRIPTORS
+    StcChannelClose(&pConnection->channel);
+    StcChannelClose(&pConnection->listener);
+#endif
+    StcEventClose(&pConnection->clientWake);
+    StcMappingClose(&pConnection->mapping);
+
+    if (pConnection->connected) {
+        pConnection->connected = false;
+        --pBase->clientCount;
+    }
+
+    pConnection->pInfo = NULL;
+}
+
+// The frames being written go with the connections, so no stream is left between Tick and SignalWrite
+static void CloseConnections(StcServerBase* const pBase, const StcServerStopReason reason) {
+    pBase->writingStreamMask = 0;
+    for (size_t i = 0; i < STC_MAX_CLIENT_COUNT; ++i) {
+        StcServerConnection* const pConnection = &pBase->connections[i];
+        if (pConnection->pInfo != NULL) {
+            CloseConnection(pBase, pConnection, reason);
+        }
+    }
+}
+
+// Connections still in the handshake or not subscribed to the stream have no claim on its ring, so they are skipped
+static StcStreamInfo* GetClientStreamInfo(const StcServerBase* const pBase, const size_t stream, const size_t connectionIndex) {
+    const StcServerConnection* const pConnection = &pBase->connections[connectionIndex];
+    const bool subscribed = pConnection->connected && ((pConnection->streamMask & (1u << stream)) != 0);
+    return subscribed ? &pConnection->pInfo->streams[stream] : NULL;
+}
+
+#ifdef _WIN32
+static void ReleaseD3D11ResourceFrame(const StcServerD3D11* const pServer, const StcServerD3D11Frame* const pFrame) {
+    ID3D11Texture2D_Release(pFrame->pTexture);
+    IDXGIKeyedMutex_Release(pFrame->pKeyedMutex);
+    if (!pServer->usesLegacyHandles) {
+        CloseHandle(pFrame->hTexture);
+    }
+
+    if (pFrame->pTexture11On12 != NULL) {
+        ID3D11Texture2D_Release(pFrame->pTexture11On12);
+        ID3D11Fence_Release(pFrame->pWriteFence11On12);
+        ID3D11Fence_Release(pFrame->pReadFence11On12);
+        CloseHandle(pFrame->hWriteFence11On12);
+        CloseHandle(pFrame->hReadFence11On12);
+    }
+}
+
+static void DiscardPendingD3D11Frames(StcServerD3D11* const pServer) {
+    for (size_t i = 0; i < STC_MAX_TEXTURE_COUNT; ++i) {
+        if (pServer->pendingFrames[i].pTexture) {
+            ReleaseD3D11ResourceFrame(pServer, &pServer->pendingFrames[i]);
+            pServer->pendingFrames[i].pTexture = NULL;
+        }
+    }
+}
+
+// Pending frames were never handed to the queue, so unlike the slots they need no fence wait
+static void ReleaseD3D12ResourceFrame(const StcServerD3D12Frame* const pFrame) {
+    ID3D12Resource_Release(pFrame->pTexture);
+    CloseHandle(pFrame->hTexture);
+    ID3D12Fence_Release(pFrame->pWriteFence);
+
+    if (pFrame->pTexture11 != NULL) {
+        ID3D11Texture2D_Release(pFrame->pTexture11);
+        IDXGIKeyedMutex_Release(pFrame->pKeyedMutex11);
+    } else {
+        CloseHandle(pFrame->hWriteFence);
+    }
+}
+
+static void DiscardPendingD3D12Frames(StcServerD3D12* const pServer) {
+    for (size_t i = 0; i < STC_MAX_TEXTURE_COUNT; ++i) {
+        if (pServer->pendingFrames[i].pTexture) {
+            ReleaseD3D12ResourceFrame(&pServer->pendingFrames[i]);
+            pServer->pendingFrames[i].pTexture = NULL;
+        }
+    }
+}
+
 static void CloseServerD3D11(StcServerD3D11* const pServer, const StcServerStopReason reason) {
     StcServerBase* const pBase = &pServer->base;
-    StcInfo* const pInfo = pBase->pInfo;
+    StcInfo* const pInfo = pBase->connections[0].pInfo;
 
     if (pInfo) {
-        StcAtomicUint32Store(&pInfo->serverStopReason, reason);
+        StcAtomicUint32StoreRelease(&pInfo->serverStopReason, reason);
 
-        for (size_t i = 0; i < STC_TEXTURE_COUNT; ++i) {
+        for (size_t i = 0; i < STC_MAX_TEXTURE_COUNT; ++i) {
             if (pServer->pTextures[i]) {
                 pServer->allocator.pfnDestroy(pServer->allocator.pUserData, i);
 
@@ -104,7 +287,7 @@ static void CloseServerD3D11(StcServerD3D11* const pServer, const StcServerStopR
                 IDXGIKeyedMutex_Release(pServer->pKeyedMutexes[i]);
                 pServer->pKeyedMutexes[i] = NULL;
                 if (!pServer->usesLegacyHandles) {
-                    CloseHandle((HANDLE)(uintptr_t)pInfo->hTextures[i]);
+                    CloseHandle((HANDLE)(uintptr_t)pInfo->streams[0].hTextures[i]);
                 }
 
                 if (pServer->pTextures11On12[i] != NULL) {
@@ -114,67 +297,90 @@ static void CloseServerD3D11(StcServerD3D11* const pServer, const StcServerStopR
                     pServer->pWriteFences11On12[i] = NULL;
                     ID3D11Fence_Release(pServer->pReadFences11On12[i]);
                     pServer->pReadFences11On12[i] = NULL;
-                    CloseHandle((HANDLE)(uintptr_t)pInfo->hWriteFences12[i]);
-                    CloseHandle((HANDLE)(uintptr_t)pInfo->hReadFences12[i]);
+                    CloseHandle((HANDLE)(uintptr_t)pInfo->streams[0].hWriteFences12[i]);
+                    CloseHandle((HANDLE)(uintptr_t)pInfo->streams[0].hReadFences12[i]);
                 }
             }
         }
 
-        UnmapViewOfFile(pInfo);
-        CloseHandle(pBase->hMapFile);
+        DiscardPendingD3D11Frames(pServer);
+        CloseConnections(pBase, reason);
+    }
+}
+
+static void WaitForD3D12Write(const StcServerD3D12* const pServer, const size_t index) {
+    ID3D12Fence* const fence = pServer->pWriteFences[index];
+    const UINT64 fenceValue = pServer->writeFenceValues[index];
+    if (ID3D12Fence_GetCompletedValue(fence) < fenceValue) {
+        const HANDLE hFenceClearedAutoEvent = pServer->hFenceClearedAutoEvent;
+        ID3D12Fence_SetEventOnCompletion(fence, fenceValue, hFenceClearedAutoEvent);
+        WaitForSingleObject(hFenceClearedAutoEvent, INFINITE);
+    }
+}
+
+// The server's queue waits on read fences ahead of each write, so every write queued so far has to finish before they go
+static void WaitForD3D12Writes(const StcServerD3D12* const pServer) {
+    for (size_t i = 0; i < STC_MAX_TEXTURE_COUNT; ++i) {
+        if (pServer->pTextures[i] != NULL) {
+            WaitForD3D12Write(pServer, i);
+        }
+    }
+}
 
-        pBase->pInfo = NULL;
+static void CloseD3D12Reader(StcServerD3D12* const pServer, const size_t connectionIndex) {
+    for (size_t i = 0; i < STC_MAX_TEXTURE_COUNT; ++i) {
+        if (pServer->pReadFences[connectionIndex][i] != NULL) {
+            ID3D12Fence_Release(pServer->pReadFences[connectionIndex][i]);
+            pServer->pReadFences[connectionIndex][i] = NULL;
+            CloseHandle(pServer->hReadFences[connectionIndex][i]);
+        }
     }
+
+    pServer->readerOpen[connectionIndex] = false;
 }
 
 static void CloseServerD3D12(StcServerD3D12* const pServer, const StcServerStopReason reason) {
     StcServerBase* const pBase = &pServer->base;
-    StcInfo* const pInfo = pBase->pInfo;
 
-    if (pInfo) {
-        StcAtomicUint32Store(&pInfo->serverStopReason, reason);
-
-        const size_t copyIndex = pBase->copyIndex;
-        if (pServer->pTextures[copyIndex] != NULL) {
-            ID3D12Fence* const fence = pServer->pWriteFences[copyIndex];
-            const UINT64 fenceValue = pInfo->writeFenceValues12[copyIndex];
-            if (ID3D12Fence_GetCompletedValue(fence) < fenceValue) {
-                const HANDLE hFenceClearedAutoEvent = pServer->hFenceClearedAutoEvent;
-                ID3D12Fence_SetEventOnCompletion(fence, fenceValue, hFenceClearedAutoEvent);
-                WaitForSingleObject(hFenceClearedAutoEvent, INFINITE);
-            }
+    for (size_t i = 0; i < STC_MAX_CLIENT_COUNT; ++i) {
+        StcInfo* const pInfo = pBase->connections[i].pInfo;
+        if (pInfo != NULL) {
+            StcAtomicUint32StoreRelease(&pInfo->serverStopReason, reason);
         }
+    }
 
-        for (size_t i = 0; i < STC_TEXTURE_COUNT; ++i) {
-            if (pServer->pTextures[i]) {
-                pServer->allocator.pfnDestroy(pServer->allocator.pUserData, i);
+    WaitForD3D12Writes(pServer);
 
-                ID3D12Resource_Release(pServer->pTextures[i]);
-                pServer->pTextures[i] = NULL;
-                CloseHandle((HANDLE)(uintptr_t)pInfo->hTextures[i]);
+    for (size_t i = 0; i < STC_MAX_CLIENT_COUNT; ++i) {
+        if (pServer->readerOpen[i]) {
+            CloseD3D12Reader(pServer, i);
+        }
+    }
 
-                ID3D12Fence_Release(pServer->pWriteFences[i]);
-                pServer->pWriteFences[i] = NULL;
+    for (size_t i = 0; i < STC_MAX_TEXTURE_COUNT; ++i) {
+        if (pServer->pTextures[i]) {
+            pServer->allocator.pfnDestroy(pServer->allocator.pUserData, i);
 
-                if (pServer->pTextures11[i] != NULL) {
-                    ID3D11Texture2D_Release(pServer->pTextures11[i]);
-                    pServer->pTextures11[i] = NULL;
-                    IDXGIKeyedMutex_Release(pServer->pKeyedMutexes11[i]);
-                    pServer->pKeyedMutexes11[i] = NULL;
-                } else {
-                    ID3D12Fence_Release(pServer->pReadFences[i]);
-                    pServer->pReadFences[i] = NULL;
-                    CloseHandle((HANDLE)(uintptr_t)pInfo->hWriteFences12[i]);
-                    CloseHandle((HANDLE)(uintptr_t)pInfo->hReadFences12[i]);
-                }
-            }
-        }
+            ID3D12Resource_Release(pServer->pTextures[i]);
+            pServer->pTextures[i] = NULL;
+            CloseHandle(pServer->hTextures[i]);
 
-        UnmapViewOfFile(pInfo);
-        CloseHandle(pBase->hMapFile);
+            ID3D12Fence_Release(pServer->pWriteFences[i]);
+            pServer->pWriteFences[i] = NULL;
 
-        pBase->pInfo = NULL;
+            if (pServer->pTextures11[i] != NULL) {
+                ID3D11Texture2D_Release(pServer->pTextures11[i]);
+                pServer->pTextures11[i] = NULL;
+                IDXGIKeyedMutex_Release(pServer->pKeyedMutexes11[i]);
+                pServer->pKeyedMutexes11[i] = NULL;
+            } else {
+                CloseHandle(pServer->hWriteFences[i]);
+            }
+        }
     }
+
+    DiscardPendingD3D12Frames(pServer);
+    CloseConnections(pBase, reason);
 }
 
 static StcServerStatus ReopenServerD3D11(StcServerD3D11* const pServer, const StcServerStopReason reason,
@@ -194,10 +400,54 @@ static StcServerStatus ReopenServerD3D12(StcServerD3D12* const pServer, const St
     CloseServerD3D12(pServer, reason);
     return OpenServer(pBase, pGlobalInfo);
 }
+#endif
+
+static void DiscardPendingCpuFrames(StcServerCpu* const pServer, const size_t stream) {
+    StcServerCpuStream* const pCpuStream = &pServer->streams[stream];
+    for (size_t i = 0; i < STC_MAX_TEXTURE_COUNT; ++i) {
+        if (pCpuStream->pPendingHeaders[i]) {
+            StcMappingClose(&pCpuStream->pendingMappings[i]);
+            pCpuStream->pPendingHeaders[i] = NULL;
+        }
+    }
+}
+
+static void CloseServerCpu(StcServerCpu* const pServer, const StcServerStopReason reason) {
+    StcServerBase* const pBase = &pServer->base;
+
+    for (size_t s = 0; s < pBase->streamCount; ++s) {
+        StcServerCpuStream* const pCpuStream = &pServer->streams[s];
+        for (size_t i = 0; i < STC_MAX_TEXTURE_COUNT; ++i) {
+            if (pCpuStream->pFrameHeaders[i]) {
+                pServer->allocator.pfnDestroy(pServer->allocator.pUserData, s * STC_MAX_TEXTURE_COUNT + i);
+
+                StcMappingClose(&pCpuStream->frameMappings[i]);
+                pCpuStream->pFrameHeaders[i] = NULL;
+            }
+        }
+
+        DiscardPendingCpuFrames(pServer, s);
+    }
+
+    CloseConnections(pBase, reason);
+}
+
+static StcServerStatus ReopenServerCpu(StcServerCpu* const pServer, const StcServerStopReason reason,
+                                       StcGlobalInfo* const pGlobalInfo) {
+    StcServerBase* const pBase = &pServer->base;
+    StcLogMessage(&pBase->messenger, STC_MESSAGE_ID_SERVER_CPU_CONNECTION_RESET);
+
+    CloseServerCpu(pServer, reason);
+    return OpenServer(pBase, pGlobalInfo);
+}
+
+static void SetResizeDelay(StcServerBase* const pBase, const uint32_t delayMicroseconds) {
+    pBase->resizeDelayTicks = ((int64_t)delayMicroseconds * pBase->tickFrequency) / 1000000;
+}
 
 static StcServerStatus StcServerCreate(StcServerBase* const pBase, const TCHAR* const pPrefix,
-                                       const StcServerGraphicsInfo* const pGraphicsInfo, const StcMessageCallbacks* pMessenger,
-                                       const StcApi serverApi) {
+                                       const StcServerGraphicsInfo* const pGraphicsInfo, const size_t metadataCapacity,
+                                       const StcMessageCallbacks* pMessenger, const StcApi serverApi) {
     StcServerStatus status = STC_SERVER_STATUS_SUCCESS;
 
     if (pMessenger) {
@@ -208,61 +458,116 @@ static StcServerStatus StcServerCreate(StcServerBase* const pBase, const TCHAR*
         pMessenger = &pBase->messenger;
     }
 
+    pBase->controller.pUserData = NULL;
+    pBase->controller.pfnControl = NULL;
+
     StcLogMessage(pMessenger, STC_MESSAGE_ID_SERVER_VERSION, STC_MAJOR_VERSION, STC_MINOR_VERSION, STC_PATCH_VERSION,
                   StcGetApiName(serverApi));
 
     const int result = stc_stprintf(pBase->pNameBuffer, _countof(pBase->pNameBuffer), TEXT("%") STC_TSTRINGWIDTH TEXT("s_%u"),
-                                    pPrefix, (unsigned)GetCurrentProcessId());
-    if (result < 0 || result >= _countof(pBase->pNameBuffer)) {
+                                    pPrefix, (unsigned)StcGetCurrentProcessId());
+    if (result < 0 || (result >= (int)_countof(pBase->pNameBuffer))) {
         StcLogMessage(pMessenger, STC_MESSAGE_ID_SERVER_FAIL_GLOBAL_STRING_FORMAT, result);
         status = STC_SERVER_STATUS_FAIL_STRING_FORMAT;
         goto fail0;
     }
 
-    HANDLE hGlobalMapFile = CreateFileMapping(INVALID_HANDLE_VALUE, NULL, PAGE_READWRITE, 0, STC_MAP_SIZE, pBase->pNameBuffer);
-    if (hGlobalMapFile == NULL) {
-        StcLogMessage(pMessenger, STC_MESSAGE_ID_SERVER_FAIL_CREATE_GLOBAL_FILE_MAPPING, GetLastError());
+    if (metadataCapacity > STC_MAX_METADATA_CAPACITY) {
+        StcLogMessage(pMessenger, STC_MESSAGE_ID_SERVER_FAIL_METADATA_CAPACITY, (uint32_t)metadataCapacity,
+                      STC_MAX_METADATA_CAPACITY);
+        status = STC_SERVER_STATUS_FAIL_METADATA_TOO_LARGE;
+        goto fail0;
+    }
+
+    StcMapping globalMapping;
+    int error;
+    const StcMappingResult mappingResult = StcMappingCreate(&globalMapping, pBase->pNameBuffer, STC_MAP_SIZE, &error);
+    if (mappingResult == STC_MAPPING_RESULT_FAIL_CREATE) {
+        StcLogMessage(pMessenger, STC_MESSAGE_ID_SERVER_FAIL_CREATE_GLOBAL_FILE_MAPPING, error);
         status = STC_SERVER_STATUS_FAIL_CREATE_GLOBAL_FILE_MAPPING;
         goto fail0;
     }
 
-    StcGlobalInfo* const pGlobalInfo = MapViewOfFile(hGlobalMapFile, FILE_MAP_ALL_ACCESS, 0, 0, sizeof(StcGlobalInfo));
-    if (pGlobalInfo == NULL) {
-        StcLogMessage(pMessenger, STC_MESSAGE_ID_SERVER_FAIL_MAP_GLOBAL_INFO, GetLastError());
+    if (mappingResult != STC_MAPPING_RESULT_SUCCESS) {
+        StcLogMessage(pMessenger, STC_MESSAGE_ID_SERVER_FAIL_MAP_GLOBAL_INFO, error);
         status = STC_SERVER_STATUS_FAIL_MAP_GLOBAL_INFO;
+        goto fail0;
+    }
+
+    StcGlobalInfo* const pGlobalInfo = globalMapping.pView;
+
+    TCHAR pEventNameBuffer[_countof(pBase->pNameBuffer) + 16];
+    stc_stprintf(pEventNameBuffer, _countof(pEventNameBuffer), TEXT("%") STC_TSTRINGWIDTH TEXT("s_ServerWake"), pBase->pNameBuffer);
+    if (!StcEventCreate(&pBase->serverWake, pEventNameBuffer, &error)) {
+        StcLogMessage(pMessenger, STC_MESSAGE_ID_SERVER_FAIL_CREATE_WAKE_EVENT, error);
+        status = STC_SERVER_STATUS_FAIL_CREATE_EVENT;
         goto fail1;
     }
 
+#ifdef STC_TRANSPORT_PASSES_DESCRIPTORS
+    if (!StcEventCreateDescriptor(&pBase->serverWake, &error)) {
+        StcLogMessage(pMessenger, STC_MESSAGE_ID_SERVER_FAIL_CREATE_WAKE_EVENT, error);
+        status = STC_SERVER_STATUS_FAIL_CREATE_EVENT;
+        goto fail2;
+    }
+#endif
+
+    pBase->serverWake.pWord = &pGlobalInfo->serverWake;
+    pBase->wakeToken = StcEventGetToken(&pBase->serverWake);
+
     pGlobalInfo->version = STC_MAJOR_VERSION;
     pGlobalInfo->serverApi = serverApi;
+    pGlobalInfo->minorVersion = STC_MINOR_VERSION;
+    pGlobalInfo->capabilities = STC_SUPPORTED_CAPABILITIES;
+    pGlobalInfo->metadataCapacity = (uint32_t)metadataCapacity;
+    pBase->metadataCapacity = metadataCapacity;
 
     pBase->nextConnectToken = 1;
+    pBase->tickFrequency = StcGetTickFrequency();
+    SetResizeDelay(pBase, STC_DEFAULT_RESIZE_DELAY_MICROSECONDS);
+    pBase->writingStreamMask = 0;
+
+    // See StcServerD3D11Create for why D3D11 frames have a single reader
+    pBase->maxClientCount = (serverApi == STC_API_D3D11) ? 1 : STC_MAX_CLIENT_COUNT;
+    for (size_t i = 0; i < STC_MAX_CLIENT_COUNT; ++i) {
+        pBase->connections[i].connected = false;
+        pBase->connections[i].pInfo = NULL;
+    }
+    pBase->clientCount = 0;
+
+    // Stream 0 is unnamed, so a client that asks for no stream by name gets it
+    pBase->streamCount = 1;
+    pBase->streams[0].graphicsInfo = *pGraphicsInfo;
+    pBase->streams[0].sliceCount = 1;
+    pBase->streams[0].resizeGeneration = 1;
+    pBase->streams[0].resizePending = false;
+    pBase->streams[0].frameSliceCount = 1;
+    pBase->streams[0].completedSlices = 0;
+    pGlobalInfo->streamNames[0][0] = '\0';
+    StcAtomicUint32StoreRelease(&pGlobalInfo->streamCount, 1);
 
     status = OpenServer(pBase, pGlobalInfo);
     if (status != STC_SERVER_STATUS_SUCCESS) {
         goto fail2;
     }
 
-    pBase->clientInProgress = false;
-
-    pBase->graphicsInfo = *pGraphicsInfo;
-
-    pBase->hGlobalMapFile = hGlobalMapFile;
+    pBase->globalMapping = globalMapping;
     pBase->pGlobalInfo = pGlobalInfo;
     pBase->initialized = true;
 
     goto success;
 
 fail2:
-    UnmapViewOfFile(pGlobalInfo);
+    StcEventClose(&pBase->serverWake);
 fail1:
-    CloseHandle(hGlobalMapFile);
+    StcMappingClose(&globalMapping);
 fail0:
     pBase->initialized = false;
 success:
     return status;
 }
 
+#ifdef _WIN32
 static bool StcCreateFunctionD3D11Null(void* pUserData, size_t index, ID3D11Texture2D* pTexture) {
     (void)pUserData;
     (void)index;
@@ -440,11 +745,11 @@ success:
 }
 
 StcServerStatus StcServerD3D11Create(StcServerD3D11* const pServer, const TCHAR* const pPrefix,
-                                     const StcServerGraphicsInfo* const pGraphicsInfo, ID3D11Device* const pDevice,
-                                     const StcD3D11AllocationCallbacks* const pAllocator,
+                                     const StcServerGraphicsInfo* const pGraphicsInfo, const size_t metadataCapacity,
+                                     ID3D11Device* const pDevice, const StcD3D11AllocationCallbacks* const pAllocator,
                                      const StcMessageCallbacks* pMessenger) {
     StcServerBase* const pBase = &pServer->base;
-    StcServerStatus status = StcServerCreate(pBase, pPrefix, pGraphicsInfo, pMessenger, STC_API_D3D11);
+    StcServerStatus status = StcServerCreate(pBase, pPrefix, pGraphicsInfo, metadataCapacity, pMessenger, STC_API_D3D11);
     if (status != STC_SERVER_STATUS_SUCCESS) {
         goto fail0;
     }
@@ -453,12 +758,13 @@ StcServerStatus StcServerD3D11Create(StcServerD3D11* const pServer, const TCHAR*
 
     pServer->pDevice = pDevice;
 
-    for (size_t i = 0; i < STC_TEXTURE_COUNT; ++i) {
+    for (size_t i = 0; i < STC_MAX_TEXTURE_COUNT; ++i) {
         pServer->pTextures[i] = NULL;
         pServer->pKeyedMutexes[i] = NULL;
         pServer->pTextures11On12[i] = NULL;
         pServer->pWriteFences11On12[i] = NULL;
         pServer->pReadFences11On12[i] = NULL;
+        pServer->pendingFrames[i].pTexture = NULL;
     }
 
     if (pAllocator) {
@@ -561,8 +867,9 @@ success:
 }
 
 StcServerStatus StcServerD3D12Create(StcServerD3D12* const pServer, const TCHAR* const pPrefix,
-                                     const StcServerGraphicsInfo* const pGraphicsInfo, ID3D12Device* const pDevice,
-                                     const StcD3D12AllocationCallbacks* const pAllocator, const StcMessageCallbacks* pMessenger) {
+                                     const StcServerGraphicsInfo* const pGraphicsInfo, const size_t metadataCapacity,
+                                     ID3D12Device* const pDevice, const StcD3D12AllocationCallbacks* const pAllocator,
+                                     const StcMessageCallbacks* pMessenger) {
     StcServerStatus status;
 
     const HANDLE hFenceClearedAutoEvent = CreateEvent(NULL, FALSE, FALSE, NULL);
@@ -573,7 +880,7 @@ StcServerStatus StcServerD3D12Create(StcServerD3D12* const pServer, const TCHAR*
     }
 
     StcServerBase* const pBase = &pServer->base;
-    status = StcServerCreate(pBase, pPrefix, pGraphicsInfo, pMessenger, STC_API_D3D12);
+    status = StcServerCreate(pBase, pPrefix, pGraphicsInfo, metadataCapacity, pMessenger, STC_API_D3D12);
     if (status != STC_SERVER_STATUS_SUCCESS) {
         goto fail1;
     }
@@ -583,12 +890,19 @@ StcServerStatus StcServerD3D12Create(StcServerD3D12* const pServer, const TCHAR*
     pServer->hFenceClearedAutoEvent = hFenceClearedAutoEvent;
     pServer->pDevice = pDevice;
 
-    for (size_t i = 0; i < STC_TEXTURE_COUNT; ++i) {
+    for (size_t i = 0; i < STC_MAX_TEXTURE_COUNT; ++i) {
         pServer->pTextures[i] = NULL;
         pServer->pWriteFences[i] = NULL;
-        pServer->pReadFences[i] = NULL;
         pServer->pTextures11[i] = NULL;
         pServer->pKeyedMutexes11[i] = NULL;
+        pServer->pendingFrames[i].pTexture = NULL;
+    }
+
+    for (size_t c = 0; c < STC_MAX_CLIENT_COUNT; ++c) {
+        pServer->readerOpen[c] = false;
+        for (size_t i = 0; i < STC_MAX_TEXTURE_COUNT; ++i) {
+            pServer->pReadFences[c][i] = NULL;
+        }
     }
 
     if (pAllocator) {
@@ -633,8 +947,8 @@ void StcServerD3D11Destroy(StcServerD3D11* const pServer) {
 #endif
         }
 
-        UnmapViewOfFile(pBase->pGlobalInfo);
-        CloseHandle(pBase->hGlobalMapFile);
+        StcEventClose(&pBase->serverWake);
+        StcMappingClose(&pBase->globalMapping);
 
         pBase->initialized = false;
     }
@@ -656,8 +970,8 @@ void StcServerD3D12Destroy(StcServerD3D12* const pServer) {
 #endif
         }
 
-        UnmapViewOfFile(pBase->pGlobalInfo);
-        CloseHandle(pBase->hGlobalMapFile);
+        StcEventClose(&pBase->serverWake);
+        StcMappingClose(&pBase->globalMapping);
 
         CloseHandle(pServer->hFenceClearedAutoEvent);
 
@@ -666,49 +980,169 @@ void StcServerD3D12Destroy(StcServerD3D12* const pServer) {
 
     StcLogMessage(&pBase->messenger, STC_MESSAGE_ID_SERVER_DESTROY_D3D12_SUCCESS);
 }
+#endif
+
+static bool StcCreateFunctionCpuNull(void* pUserData, size_t index, void* pData, size_t rowPitch) {
+    (void)pUserData;
+    (void)index;
+    (void)pData;
+    (void)rowPitch;
+
+    return true;
+}
+
+static void StcDestroyFunctionCpuNull(void* pUserData, size_t index) {
+    (void)pUserData;
+    (void)index;
+}
+
+StcServerStatus StcServerCpuCreate(StcServerCpu* const pServer, const TCHAR* const pPrefix,
+                                   const StcServerGraphicsInfo* const pGraphicsInfo, const size_t metadataCapacity,
+                                   const StcCpuAllocationCallbacks* const pAllocator, const StcMessageCallbacks* pMessenger) {
+    for (size_t s = 0; s < STC_MAX_STREAM_COUNT; ++s) {
+        for (size_t i = 0; i < STC_MAX_TEXTURE_COUNT; ++i) {
+            pServer->streams[s].pFrameHeaders[i] = NULL;
+            pServer->streams[s].pPendingHeaders[i] = NULL;
+        }
+    }
+
+    StcServerBase* const pBase = &pServer->base;
+    StcServerStatus status = StcServerCreate(pBase, pPrefix, pGraphicsInfo, metadataCapacity, pMessenger, STC_API_CPU);
+    if (status != STC_SERVER_STATUS_SUCCESS) {
+        goto fail0;
+    }
 
-static void StcServerResizeBuffers(StcServerBase* const pBase, const UINT width, const UINT height, const StcFormat format) {
-    StcServerGraphicsInfo* const pGraphicsInfo = &pBase->graphicsInfo;
-    pGraphicsInfo->width = width;
-    pGraphicsInfo->height = height;
-    pGraphicsInfo->format = format;
+    pMessenger = &pBase->messenger;
 
-    for (size_t i = 0; i < STC_TEXTURE_COUNT; ++i) {
-        pBase->needResize[i] = true;
+    if (pAllocator) {
+        pServer->allocator = *pAllocator;
+    } else {
+        pServer->allocator.pfnCreate = StcCreateFunctionCpuNull;
+        pServer->allocator.pfnDestroy = StcDestroyFunctionCpuNull;
     }
+
+    pServer->nextGeneration = 1;
+
+    StcLogMessage(pMessenger, STC_MESSAGE_ID_SERVER_CREATE_CPU_SUCCESS);
+
+fail0:
+    return status;
 }
 
-void StcServerD3D11ResizeBuffers(StcServerD3D11* const pServer, const UINT width, const UINT height, const StcFormat format) {
-    StcServerResizeBuffers(&pServer->base, width, height, format);
+void StcServerCpuDestroy(StcServerCpu* const pServer) {
+    StcServerBase* const pBase = &pServer->base;
+    if (pBase->initialized) {
+        CloseServerCpu(pServer, STC_SERVER_STOP_REASON_DESTROY);
+
+        StcEventClose(&pBase->serverWake);
+        StcMappingClose(&pBase->globalMapping);
+
+        pBase->initialized = false;
+    }
+
+    StcLogMessage(&pBase->messenger, STC_MESSAGE_ID_SERVER_DESTROY_CPU_SUCCESS);
 }
 
-void StcServerD3D12ResizeBuffers(StcServerD3D12* const pServer, const UINT width, const UINT height, const StcFormat format) {
-    StcServerResizeBuffers(&pServer->base, width, height, format);
+// Clients pick streams by name when they connect, so a stream added later is only seen by clients that connect after it
+StcServerStatus StcServerCpuAddStream(StcServerCpu* const pServer, const char* const pName,
+                                      const StcServerGraphicsInfo* const pGraphicsInfo, size_t* const pStreamIndex) {
+    StcServerStatus status = STC_SERVER_STATUS_SUCCESS;
+
+    StcServerBase* const pBase = &pServer->base;
+    StcGlobalInfo* const pGlobalInfo = pBase->pGlobalInfo;
+    const size_t stream = pBase->streamCount;
+    const size_t nameLength = strlen(pName);
+    if ((stream >= STC_MAX_STREAM_COUNT) || (nameLength >= STC_STREAM_NAME_SIZE)) {
+        StcLogMessage(&pBase->messenger, STC_MESSAGE_ID_SERVER_FAIL_ADD_STREAM, pName, (uint32_t)stream, STC_MAX_STREAM_COUNT,
+                      STC_STREAM_NAME_SIZE - 1);
+        status = (stream >= STC_MAX_STREAM_COUNT) ? STC_SERVER_STATUS_FAIL_TOO_MANY_STREAMS : STC_SERVER_STATUS_FAIL_STRING_FORMAT;
+        goto fail0;
+    }
+
+    StcServerStream* const pStream = &pBase->streams[stream];
+    pStream->graphicsInfo = *pGraphicsInfo;
+    pStream->sliceCount = 1;
+    pStream->resizeGeneration = 1;
+    pStream->resizePending = false;
+    pStream->copyIndex = (pBase->textureCount > 0) ? (pBase->textureCount - 1) : 0;
+    pStream->frameSequence = 0;
+    pStream->frameSliceCount = 1;
+    pStream->completedSlices = 0;
+    for (size_t i = 0; i < STC_MAX_TEXTURE_COUNT; ++i) {
+        pStream->needResize[i] = true;
+    }
+
+    memcpy(pGlobalInfo->streamNames[stream], pName, nameLength + 1);
+    pBase->streamCount = stream + 1;
+    StcAtomicUint32StoreRelease(&pGlobalInfo->streamCount, (uint32_t)pBase->streamCount);
+
+    *pStreamIndex = stream;
+
+fail0:
+    return status;
 }
 
-typedef struct ResourceFrame11 {
-    ID3D11Texture2D* pTexture;
-    IDXGIKeyedMutex* pKeyedMutex;
-    HANDLE hTexture;
+// Only takes note of the size, Tick moves the ring over between two frames once no other resize has come for the delay
+static void StcServerResizeBuffers(StcServerBase* const pBase, const size_t stream, const UINT width, const UINT height,
+                                   const StcFormat format) {
+    if (stream < pBase->streamCount) {
+        StcServerStream* const pStream = &pBase->streams[stream];
+        const int64_t now = StcGetCurrentTicks();
+        if (!pStream->resizePending) {
+            pStream->resizeInfo = pStream->graphicsInfo;
+            pStream->resizeFirstTicks = now;
+            pStream->resizePending = true;
+        }
 
-    ID3D11Texture2D* pTexture11On12;
-    ID3D11Fence* pWriteFence11On12;
-    ID3D11Fence* pReadFence11On12;
-    HANDLE hWriteFence11On12;
-    HANDLE hReadFence11On12;
-} ResourceFrame11;
+        pStream->resizeInfo.width = width;
+        pStream->resizeInfo.height = height;
+        pStream->resizeInfo.format = format;
+        pStream->resizeLastTicks = now;
+    }
+}
 
-typedef struct ResourceFrame12 {
-    ID3D12Resource* pTexture;
-    ID3D12Fence* pWriteFence;
-    ID3D12Fence* pReadFence;
-    HANDLE hTexture;
-    HANDLE hWriteFence;
-    HANDLE hReadFence;
+// Every slot written from here on is recreated at the new size first, and its frame record carries the new generation,
+// so the ring switches sizes once instead of mixing them slot by slot. Clients that negotiated resize generations report
+// the switch with the first new frame only.
+static bool ApplyResize(StcServerBase* const pBase, const size_t stream) {
+    StcServerStream* const pStream = &pBase->streams[stream];
+
+    bool applied = false;
+    if (pStream->resizePending) {
+        const int64_t now = StcGetCurrentTicks();
+        if (((now - pStream->resizeLastTicks) >= pBase->resizeDelayTicks) ||
+            ((now - pStream->resizeFirstTicks) >= (STC_RESIZE_MAX_DELAYS * pBase->resizeDelayTicks))) {
+            pStream->graphicsInfo = pStream->resizeInfo;
+            pStream->resizePending = false;
+            ++pStream->resizeGeneration;
+            for (size_t i = 0; i < STC_MAX_TEXTURE_COUNT; ++i) {
+                pStream->needResize[i] = true;
+            }
+
+            applied = true;
+        }
+    }
+
+    return applied;
+}
+
+void StcServerCpuResizeStreamBuffers(StcServerCpu* const pServer, const size_t stream, const UINT width, const UINT height,
+                                     const StcFormat format) {
+    StcServerResizeBuffers(&pServer->base, stream, width, height, format);
+}
+
+void StcServerCpuResizeBuffers(StcServerCpu* const pServer, const UINT width, const UINT height, const StcFormat format) {
+    StcServerCpuResizeStreamBuffers(pServer, 0, width, height, format);
+}
+
+#ifdef _WIN32
+void StcServerD3D11ResizeBuffers(StcServerD3D11* const pServer, const UINT width, const UINT height, const StcFormat format) {
+    StcServerResizeBuffers(&pServer->base, 0, width, height, format);
+}
 
-    ID3D11Texture2D* pTexture11;
-    IDXGIKeyedMutex* pKeyedMutex11;
-} ResourceFrame12;
+void StcServerD3D12ResizeBuffers(StcServerD3D12* const pServer, const UINT width, const UINT height, const StcFormat format) {
+    StcServerResizeBuffers(&pServer->base, 0, width, height, format);
+}
 
 D3D11_BIND_FLAG ComputeD3D11BindFlags(StcBindFlags flags) {
     D3D11_BIND_FLAG flagsD3D11 = 0;
@@ -799,13 +1233,13 @@ static DXGI_FORMAT ConvertFormat(const StcFormat format, const StcSrgbChannelTyp
 }
 
 static StcServerStopReason CreateD3D11ResourceFrame(const StcServerD3D11* const pServer, bool need12,
-                                                    ResourceFrame11* const pFrame) {
+                                                    StcServerD3D11Frame* const pFrame) {
     StcServerStopReason reason = STC_CLIENT_STOP_REASON_NONE;
 
     const StcServerBase* const pBase = &pServer->base;
     const StcMessageCallbacks* const pMessenger = &pBase->messenger;
-    const StcServerGraphicsInfo* const pGraphicsInfo = &pBase->graphicsInfo;
-    StcInfo* const pInfo = pBase->pInfo;
+    const StcServerGraphicsInfo* const pGraphicsInfo = &pBase->streams[0].graphicsInfo;
+    StcInfo* const pInfo = pBase->connections[0].pInfo;
     ID3D11Device* const pDevice = pServer->pDevice;
 
     ID3D11Texture2D* pTexture;
@@ -1023,7 +1457,23 @@ success:
     return reason;
 }
 
-static StcServerStatus CreateD3D12ResourceFrame(const StcServerD3D12* const pServer, bool need11, ResourceFrame12* const pFrame) {
+// Creates every outstanding slot at once, like CreateCpuResourceFrames, so the textures of a resize are all allocated
+// before the first one is switched in rather than one per Tick. They wait in pendingFrames until their slot comes around.
+static StcServerStopReason CreateD3D11ResourceFrames(StcServerD3D11* const pServer, const bool need12) {
+    StcServerStopReason reason = STC_SERVER_STOP_REASON_NONE;
+
+    const StcServerBase* const pBase = &pServer->base;
+    for (size_t i = 0; (reason == STC_SERVER_STOP_REASON_NONE) && (i < pBase->textureCount); ++i) {
+        if (pBase->streams[0].needResize[i] && (pServer->pendingFrames[i].pTexture == NULL)) {
+            reason = CreateD3D11ResourceFrame(pServer, need12, &pServer->pendingFrames[i]);
+        }
+    }
+
+    return reason;
+}
+
+static StcServerStatus CreateD3D12ResourceFrame(const StcServerD3D12* const pServer, bool need11,
+                                                StcServerD3D12Frame* const pFrame) {
     StcServerStopReason reason = STC_CLIENT_STOP_REASON_NONE;
 
     ID3D11On12Device* const pDevice11On12 = pServer->pDevice11On12;
@@ -1034,8 +1484,20 @@ static StcServerStatus CreateD3D12ResourceFrame(const StcServerD3D12* const pSer
 
     const StcServerBase* const pBase = &pServer->base;
     const StcMessageCallbacks* const pMessenger = &pBase->messenger;
-    const StcServerGraphicsInfo* const pGraphicsInfo = &pBase->graphicsInfo;
-    StcInfo* const pInfo = pBase->pInfo;
+    const StcServerGraphicsInfo* const pGraphicsInfo = &pBase->streams[0].graphicsInfo;
+
+    // Readers share the texture, so it carries every bind flag one of them asked for. The first reader picks the format.
+    const StcInfo* pInfo = NULL;
+    StcBindFlags bindFlags = 0;
+    for (size_t i = 0; i < STC_MAX_CLIENT_COUNT; ++i) {
+        if (pServer->readerOpen[i]) {
+            const StcInfo* const pReaderInfo = pBase->connections[i].pInfo;
+            bindFlags |= pReaderInfo->clientBindFlags;
+            if (pInfo == NULL) {
+                pInfo = pReaderInfo;
+            }
+        }
+    }
 
     D3D12_HEAP_PROPERTIES heapProperties;
     heapProperties.Type = D3D12_HEAP_TYPE_DEFAULT;
@@ -1055,10 +1517,10 @@ static StcServerStatus CreateD3D12ResourceFrame(const StcServerD3D12* const pSer
     resourceDesc.SampleDesc.Count = 1;
     resourceDesc.SampleDesc.Quality = 0;
     resourceDesc.Layout = D3D12_TEXTURE_LAYOUT_UNKNOWN;
-    resourceDesc.Flags = ComputeD3D12ResourceFlags(pInfo->clientBindFlags);
+    resourceDesc.Flags = ComputeD3D12ResourceFlags(bindFlags);
 
     D3D11_RESOURCE_FLAGS flags11;
-    flags11.BindFlags = ComputeD3D11BindFlags(pInfo->clientBindFlags);
+    flags11.BindFlags = ComputeD3D11BindFlags(bindFlags);
     flags11.MiscFlags = D3D11_RESOURCE_MISC_SHARED_KEYEDMUTEX | D3D11_RESOURCE_MISC_SHARED_NTHANDLE;
     flags11.CPUAccessFlags = 0;
     flags11.StructureByteStride = 0;
@@ -1096,9 +1558,7 @@ static StcServerStatus CreateD3D12ResourceFrame(const StcServerD3D12* const pSer
 
     ID3D11Texture2D* pTexture11 = NULL;
     IDXGIKeyedMutex* pKeyedMutex11 = NULL;
-    ID3D12Fence* pReadFence = NULL;
     HANDLE hWriteFence = NULL;
-    HANDLE hReadFence = NULL;
     if (need11) {
         if (FAILED(ID3D11On12Device_CreateWrappedResource(pDevice11On12, (IUnknown*)pTexture, &flags11, D3D12_RESOURCE_STATE_COMMON,
                                                           D3D12_RESOURCE_STATE_COMMON, &IID_ID3D11Texture2D, &pTexture11))) {
@@ -1126,40 +1586,20 @@ static StcServerStatus CreateD3D12ResourceFrame(const StcServerD3D12* const pSer
             reason = STC_SERVER_STOP_REASON_FAIL_D3D12_RELEASE_KEYED_MUTEX_TO_INITIALIZE;
             goto fail11_1;
         }
-    } else {
-        if (FAILED(ID3D12Device_CreateFence(pDevice, 0, D3D12_FENCE_FLAG_SHARED, &IID_ID3D12Fence, &pReadFence))) {
-            reason = STC_SERVER_STOP_REASON_FAIL_CREATE_FENCE;
-            goto fail3;
-        }
-
-        if (FAILED(
-                ID3D12Device_CreateSharedHandle(pDevice, (ID3D12DeviceChild*)pWriteFence, NULL, GENERIC_ALL, NULL, &hWriteFence))) {
-            reason = STC_SERVER_STOP_REASON_FAIL_CREATE_SHARED_HANDLE;
-            goto fail12_0;
-        }
-
-        if (FAILED(
-                ID3D12Device_CreateSharedHandle(pDevice, (ID3D12DeviceChild*)pReadFence, NULL, GENERIC_ALL, NULL, &hReadFence))) {
-            reason = STC_SERVER_STOP_REASON_FAIL_CREATE_SHARED_HANDLE;
-            goto fail12_1;
-        }
+    } else if (FAILED(ID3D12Device_CreateSharedHandle(pDevice, (ID3D12DeviceChild*)pWriteFence, NULL, GENERIC_ALL, NULL,
+                                                      &hWriteFence))) {
+        reason = STC_SERVER_STOP_REASON_FAIL_CREATE_SHARED_HANDLE;
+        goto fail3;
     }
 
     pFrame->pTexture = pTexture;
     pFrame->pWriteFence = pWriteFence;
-    pFrame->pReadFence = pReadFence;
     pFrame->hTexture = hTexture;
     pFrame->hWriteFence = hWriteFence;
-    pFrame->hReadFence = hReadFence;
     pFrame->pTexture11 = pTexture11;
     pFrame->pKeyedMutex11 = pKeyedMutex11;
     goto success;
 
-fail12_1:
-    CloseHandle(hWriteFence);
-fail12_0:
-    ID3D12Fence_Release(pReadFence);
-    goto fail3;
 fail11_1:
     IDXGIKeyedMutex_Release(pKeyedMutex11);
 fail11_0:
@@ -1175,73 +1615,890 @@ success:
     return reason;
 }
 
-static StcServerStatus TickServer(StcServerBase* const pBase, StcServerStopReason* const pReason) {
-    StcServerStatus status = STC_SERVER_STATUS_SUCCESS;
+static void AnnounceD3D12Frame(const StcServerD3D12* const pServer, StcStreamInfo* const pStreamInfo, const size_t index) {
+    pStreamInfo->hTextures[index] = (uint32_t)(uintptr_t)pServer->hTextures[index];
+    pStreamInfo->hWriteFences12[index] = (uint32_t)(uintptr_t)pServer->hWriteFences[index];
+    pStreamInfo->writeFenceValues12[index] = pServer->writeFenceValues[index];
+    pStreamInfo->invalidated[index] = true;
+}
 
-    const int64_t count = StcGetCurrentTicks();
+// A D3D12 reader signals read fences of its own, which outlive resizes since those only replace the shared texture and
+// write fence. A D3D11 reader goes through the keyed mutex instead. Either way a client that joined late is told about the
+// frames already created.
+static StcServerStopReason OpenD3D12Reader(StcServerD3D12* const pServer, const size_t connectionIndex) {
+    StcServerStopReason reason = STC_SERVER_STOP_REASON_NONE;
 
-    const StcMessageCallbacks* const pMessenger = &pBase->messenger;
-    StcGlobalInfo* const pGlobalInfo = pBase->pGlobalInfo;
-    StcInfo* pInfo = pBase->pInfo;
-    if (pInfo == NULL) {
-        StcLogMessage(pMessenger, STC_MESSAGE_ID_SERVER_RECOVER_FROM_OPEN_FAILURE);
-
-        status = OpenServer(pBase, pGlobalInfo);
-        pInfo = pBase->pInfo;
-    }
-
-    if (pInfo != NULL) {
-        StcAtomicInt64Store(&pInfo->serverKeepAlive, count);
-
-        const bool serverInitialized = StcAtomicBoolLoad(&pInfo->serverInitialized);
-        if (serverInitialized) {
-            const StcClientStopReason clientStopReason = StcAtomicUint32Load(&pInfo->clientStopReason);
-            if (clientStopReason != STC_CLIENT_STOP_REASON_NONE) {
-                StcLogMessage(pMessenger, STC_MESSAGE_ID_SERVER_CLIENT_REQUEST_STOP,
-                              StcGetClientReasonDescription(clientStopReason));
-                *pReason = STC_SERVER_STOP_REASON_CLIENT_REQUESTED;
-            } else if ((count - StcAtomicInt64Load(&pInfo->clientKeepAlive)) >= StcGetTimeoutTicks()) {
-                StcLogMessage(pMessenger, STC_MESSAGE_ID_SERVER_CLIENT_TIMEOUT);
-                *pReason = STC_SERVER_STOP_REASON_CLIENT_TIMED_OUT;
-            } else {
-                status = STC_SERVER_STATUS_SUCCESS;
+    StcServerBase* const pBase = &pServer->base;
+    StcServerConnection* const pConnection = &pBase->connections[connectionIndex];
+    StcStreamInfo* const pStreamInfo = &pConnection->pInfo->streams[0];
+    if (pConnection->pInfo->clientApi == STC_API_D3D12) {
+        for (size_t i = 0; i < pBase->textureCount; ++i) {
+            ID3D12Fence* pReadFence;
+            if (FAILED(ID3D12Device_CreateFence(pServer->pDevice, 0, D3D12_FENCE_FLAG_SHARED, &IID_ID3D12Fence, &pReadFence))) {
+                reason = STC_SERVER_STOP_REASON_FAIL_CREATE_FENCE;
+                goto fail0;
             }
-        } else {
-            if (pBase->clientInProgress) {
-                if ((count - pBase->clientFirstSeen) >= StcGetTimeoutTicks()) {
-                    StcLogMessage(pMessenger, STC_MESSAGE_ID_SERVER_CLIENT_TIMEOUT_HANDSHAKE);
-                    *pReason = STC_SERVER_STOP_REASON_CLIENT_TIMED_OUT;
-                } else if (StcAtomicBoolLoad(&pInfo->clientParametersSpecified)) {
-                    StcAtomicBoolStore(&pInfo->serverInitialized, true);
-
-                    StcLogMessage(pMessenger, STC_MESSAGE_ID_SERVER_CONNECT_HANDSHAKE_COMPLETE);
-                    status = STC_SERVER_STATUS_SUCCESS;
-                } else {
-                    status = STC_SERVER_STATUS_FAIL_CONNECT_IN_PROGRESS;
-                }
-            } else if (StcAtomicInt64Load(&pGlobalInfo->connectToken) == 0) {
-                pBase->clientInProgress = true;
-                pBase->clientFirstSeen = count;
 
-                StcLogMessage(pMessenger, STC_MESSAGE_ID_SERVER_CONNECT_TOKEN_TAKEN);
-                status = STC_SERVER_STATUS_FAIL_CONNECT_IN_PROGRESS;
-            } else {
-                status = STC_SERVER_STATUS_FAIL_DISCONNECTED;
+            HANDLE hReadFence;
+            if (FAILED(ID3D12Device_CreateSharedHandle(pServer->pDevice, (ID3D12DeviceChild*)pReadFence, NULL, GENERIC_ALL, NULL,
+                                                       &hReadFence))) {
+                ID3D12Fence_Release(pReadFence);
+                reason = STC_SERVER_STOP_REASON_FAIL_CREATE_SHARED_HANDLE;
+                goto fail0;
             }
-        }
 
-        if (*pReason != STC_SERVER_STOP_REASON_NONE) {
-            pBase->clientInProgress = false;
+            pServer->pReadFences[connectionIndex][i] = pReadFence;
+            pServer->hReadFences[connectionIndex][i] = hReadFence;
+            pStreamInfo->hReadFences12[i] = (uint32_t)(uintptr_t)hReadFence;
+            pStreamInfo->readFenceValues12[i] = 0;
+        }
+    }
 
-            StcAtomicUint32Store(&pInfo->serverStopReason, *pReason);
+    for (size_t i = 0; i < STC_MAX_TEXTURE_COUNT; ++i) {
+        if (pServer->pTextures[i] != NULL) {
+            AnnounceD3D12Frame(pServer, pStreamInfo, i);
         }
     }
 
-    return status;
+    pServer->readerOpen[connectionIndex] = true;
+    pConnection->announceFrames = false;
+    goto success;
+
+fail0:
+    CloseD3D12Reader(pServer, connectionIndex);
+success:
+    return reason;
 }
 
-static StcServerStatus StcServerD3D11ConnectionTick(StcServerD3D11* const pServer) {
-    StcServerBase* const pBase = &pServer->base;
+// D3D11 readers are alone on the server, see StcServerD3D11Create
+static bool HasD3D11Reader(const StcServerD3D12* const pServer) {
+    bool found = false;
+    for (size_t i = 0; i < STC_MAX_CLIENT_COUNT; ++i) {
+        found = found || (pServer->readerOpen[i] && (pServer->base.connections[i].pInfo->clientApi == STC_API_D3D11));
+    }
+
+    return found;
+}
+
+static StcServerStopReason CreateD3D12ResourceFrames(StcServerD3D12* const pServer, const bool need11) {
+    StcServerStopReason reason = STC_SERVER_STOP_REASON_NONE;
+
+    const StcServerBase* const pBase = &pServer->base;
+    for (size_t i = 0; (reason == STC_SERVER_STOP_REASON_NONE) && (i < pBase->textureCount); ++i) {
+        if (pBase->streams[0].needResize[i] && (pServer->pendingFrames[i].pTexture == NULL)) {
+            reason = CreateD3D12ResourceFrame(pServer, need11, &pServer->pendingFrames[i]);
+        }
+    }
+
+    return reason;
+}
+#endif
+
+typedef struct ResourceFrameCpu {
+    StcMapping mapping;
+    StcCpuFrameHeader* pHeader;
+    uint32_t generation;
+} ResourceFrameCpu;
+
+static StcServerStopReason CreateCpuResourceFrame(StcServerCpu* const pServer, const size_t stream, const size_t index,
+                                                  ResourceFrameCpu* const pFrame) {
+    StcServerStopReason reason = STC_SERVER_STOP_REASON_NONE;
+
+    const StcServerBase* const pBase = &pServer->base;
+    const StcMessageCallbacks* const pMessenger = &pBase->messenger;
+    const StcServerGraphicsInfo* const pGraphicsInfo = &pBase->streams[stream].graphicsInfo;
+    const uint32_t generation = pServer->nextGeneration;
+
+    const size_t rowPitch = StcComputeCpuRowPitch(pGraphicsInfo->width, pGraphicsInfo->format);
+    const size_t size = STC_CPU_DATA_OFFSET + (rowPitch * pGraphicsInfo->height);
+
+    StcMapping mapping;
+    int error;
+#ifdef STC_TRANSPORT_PASSES_DESCRIPTORS
+    (void)index;
+    const StcMappingResult mappingResult = StcMappingCreateAnonymous(&mapping, size, &error);
+#else
+    TCHAR pNameBuffer[256];
+    if (!StcFormatCpuFrameName(pNameBuffer, _countof(pNameBuffer), pBase->pNameBuffer, index, generation)) {
+        StcLogMessage(pMessenger, STC_MESSAGE_ID_SERVER_FAIL_CPU_CREATE_BUFFER, (int)index, 0);
+        reason = STC_SERVER_STOP_REASON_FAIL_CREATE_CPU_BUFFER;
+        goto fail0;
+    }
+
+    const StcMappingResult mappingResult = StcMappingCreate(&mapping, pNameBuffer, size, &error);
+#endif
+    if (mappingResult != STC_MAPPING_RESULT_SUCCESS) {
+        StcLogMessage(pMessenger, STC_MESSAGE_ID_SERVER_FAIL_CPU_CREATE_BUFFER, (int)index, error);
+        reason = STC_SERVER_STOP_REASON_FAIL_CREATE_CPU_BUFFER;
+        goto fail0;
+    }
+
+    StcCpuFrameHeader* const pHeader = mapping.pView;
+    pHeader->width = pGraphicsInfo->width;
+    pHeader->height = pGraphicsInfo->height;
+    pHeader->format = pGraphicsInfo->format;
+    pHeader->rowPitch = (uint32_t)rowPitch;
+
+    // Equivalent of acquiring STC_KEY_INITIAL and releasing STC_KEY_SERVER on a new keyed mutex
+    StcAtomicUint32StoreRelaxed(&pHeader->key, STC_KEY_SERVER);
+
+    ++pServer->nextGeneration;
+
+    pFrame->mapping = mapping;
+    pFrame->pHeader = pHeader;
+    pFrame->generation = generation;
+
+fail0:
+    return reason;
+}
+
+// Creates every outstanding slot at once so a client learns about a whole resize in one channel message instead of one
+// open per slot. The new frames wait in the pending arrays until their slot comes around.
+static StcServerStopReason CreateCpuResourceFrames(StcServerCpu* const pServer, const size_t stream) {
+    StcServerStopReason reason = STC_SERVER_STOP_REASON_NONE;
+
+    StcServerBase* const pBase = &pServer->base;
+    StcServerCpuStream* const pCpuStream = &pServer->streams[stream];
+#ifdef STC_TRANSPORT_PASSES_DESCRIPTORS
+    StcCpuFrameBatch batch;
+    batch.stream = (uint32_t)stream;
+    int fds[STC_MAX_TEXTURE_COUNT];
+    size_t fdCount = 0;
+#endif
+    for (size_t i = 0; i < STC_MAX_TEXTURE_COUNT; ++i) {
+#ifdef STC_TRANSPORT_PASSES_DESCRIPTORS
+        batch.generations[i] = 0;
+#endif
+        if ((i < pBase->textureCount) && pBase->streams[stream].needResize[i] && (pCpuStream->pPendingHeaders[i] == NULL) &&
+            (reason == STC_SERVER_STOP_REASON_NONE)) {
+            ResourceFrameCpu frame;
+            reason = CreateCpuResourceFrame(pServer, stream, i, &frame);
+            if (reason == STC_SERVER_STOP_REASON_NONE) {
+                pCpuStream->pendingMappings[i] = frame.mapping;
+                pCpuStream->pPendingHeaders[i] = frame.pHeader;
+                pCpuStream->pendingGenerations[i] = frame.generation;
+#ifdef STC_TRANSPORT_PASSES_DESCRIPTORS
+                batch.generations[i] = frame.generation;
+                fds[fdCount++] = frame.mapping.fd;
+#endif
+            }
+        }
+    }
+
+#ifdef STC_TRANSPORT_PASSES_DESCRIPTORS
+    static_assert(STC_MAX_TEXTURE_COUNT <= STC_CHANNEL_MAX_DESCRIPTORS, "Frame batch does not fit in one channel message");
+
+    // A client that cannot take the batch is dropped on its own, unless the frames would have no reader left
+    for (size_t c = 0; (reason == STC_SERVER_STOP_REASON_NONE) && (c < STC_MAX_CLIENT_COUNT); ++c) {
+        StcServerConnection* const pConnection = &pBase->connections[c];
+        int error;
+        if ((GetClientStreamInfo(pBase, stream, c) != NULL) &&
+            !StcChannelSend(&pConnection->channel, &batch, sizeof(batch), fds, fdCount, &error)) {
+            StcLogMessage(&pBase->messenger, STC_MESSAGE_ID_SERVER_FAIL_CPU_SEND_BUFFERS, error);
+            if (pBase->clientCount > 1) {
+                CloseConnection(pBase, pConnection, STC_SERVER_STOP_REASON_FAIL_SEND_CPU_BUFFERS);
+            } else {
+                reason = STC_SERVER_STOP_REASON_FAIL_SEND_CPU_BUFFERS;
+            }
+        }
+    }
+#endif
+
+    return reason;
+}
+
+// Most frames any one stream has retained across its readers
+static size_t CountLeasedSlots(const StcServerBase* const pBase) {
+    size_t mostLeased = 0;
+    for (size_t stream = 0; stream < pBase->streamCount; ++stream) {
+        size_t leased = 0;
+        for (size_t i = 0; i < STC_MAX_CLIENT_COUNT; ++i) {
+            const StcStreamInfo* const pInfo = GetClientStreamInfo(pBase, stream, i);
+            if (pInfo != NULL) {
+                leased += StcAtomicUint32Load(&pInfo->leaseCount);
+            }
+        }
+
+        if (mostLeased < leased) {
+            mostLeased = leased;
+        }
+    }
+
+    return mostLeased;
+}
+
+// A client reading through a keyed mutex has the frames to itself, see StcServerD3D11Create
+static size_t GetClientLimit(const StcServerBase* const pBase) {
+    size_t limit = pBase->maxClientCount;
+    for (size_t i = 0; i < STC_MAX_CLIENT_COUNT; ++i) {
+        const StcServerConnection* const pConnection = &pBase->connections[i];
+        if (pConnection->connected && (pConnection->pInfo->clientApi == STC_API_D3D11)) {
+            limit = 1;
+        }
+    }
+
+    return limit;
+}
+
+// Every reader pins its current slot and the writer needs one more. The rest is split evenly between the readers, keeping
+// back a slot for the connection offered to the next client.
+static void PublishLeaseLimits(StcServerBase* const pBase) {
+    const size_t reserved = pBase->clientCount + ((pBase->clientCount < GetClientLimit(pBase)) ? 1 : 0);
+    const uint32_t limit = ((pBase->clientCount > 0) && (pBase->textureCount > (reserved + 1)))
+                               ? (uint32_t)((pBase->textureCount - 1 - reserved) / pBase->clientCount)
+                               : 0;
+    for (size_t i = 0; i < STC_MAX_CLIENT_COUNT; ++i) {
+        const StcServerConnection* const pConnection = &pBase->connections[i];
+        if (pConnection->connected && (StcAtomicUint32LoadRelaxed(&pConnection->pInfo->leaseLimit) != limit)) {
+            StcAtomicUint32Store(&pConnection->pInfo->leaseLimit, limit);
+        }
+    }
+}
+
+// Keeps one connection open for the next client to take, as long as the ring has a slot to spare for another reader. Slots
+// that clients retained are not available to a newcomer until released.
+static StcServerStatus OfferConnection(StcServerBase* const pBase) {
+    StcServerStatus status = STC_SERVER_STATUS_SUCCESS;
+
+    size_t clientLimit = GetClientLimit(pBase);
+    if (pBase->textureCount != 0) {
+        const size_t leased = CountLeasedSlots(pBase);
+        const size_t spare = (pBase->textureCount > (leased + 1)) ? (pBase->textureCount - 1 - leased) : 0;
+        if (clientLimit > spare) {
+            clientLimit = spare;
+        }
+    }
+
+    size_t openCount = 0;
+    for (size_t i = 0; i < STC_MAX_CLIENT_COUNT; ++i) {
+        if (pBase->connections[i].pInfo != NULL) {
+            ++openCount;
+        }
+    }
+
+    if ((openCount == pBase->clientCount) && (openCount < clientLimit)) {
+        // Connections are always reopened right after closing, so having none at all means that failed
+        if (openCount == 0) {
+            StcLogMessage(&pBase->messenger, STC_MESSAGE_ID_SERVER_RECOVER_FROM_OPEN_FAILURE);
+        }
+
+        status = OpenServer(pBase, pBase->pGlobalInfo);
+    }
+
+    return status;
+}
+
+// The new values only take effect as each slot is next written, so frames keep flowing while the ring turns over. The
+// server owns clientBindFlags and srgbChannelType once connected, and a client that updates again before the server
+// looks just has its latest values adopted.
+static void UpdateClientParameters(StcServerBase* const pBase, StcServerConnection* const pConnection) {
+    StcInfo* const pInfo = pConnection->pInfo;
+    const uint32_t generation = StcAtomicUint32Load(&pInfo->parameterGeneration);
+    if (generation != pConnection->parameterGeneration) {
+        pConnection->parameterGeneration = generation;
+        pInfo->clientBindFlags = StcAtomicUint32LoadRelaxed(&pInfo->requestedBindFlags);
+        pInfo->srgbChannelType = (StcSrgbChannelType)StcAtomicUint32LoadRelaxed(&pInfo->requestedSrgbChannelType);
+
+        for (size_t stream = 0; stream < pBase->streamCount; ++stream) {
+            for (size_t i = 0; i < STC_MAX_TEXTURE_COUNT; ++i) {
+                pBase->streams[stream].needResize[i] = true;
+            }
+        }
+
+        StcLogMessage(&pBase->messenger, STC_MESSAGE_ID_SERVER_CLIENT_PARAMETERS_UPDATED, pInfo->clientBindFlags,
+                      (uint32_t)pInfo->srgbChannelType);
+    }
+}
+
+// Messages are dispatched from Tick, on the thread calling it. Passing NULL stops dispatching, the built-in requests are
+// still acted on.
+static void SetControlCallbacks(StcServerBase* const pBase, const StcControlCallbacks* const pController) {
+    if (pController) {
+        pBase->controller = *pController;
+    } else {
+        pBase->controller.pUserData = NULL;
+        pBase->controller.pfnControl = NULL;
+    }
+}
+
+// Copies each message out of shared memory before looking at it, so a client rewriting its ring cannot change a message
+// mid-dispatch. The head is only released afterwards, which is what hands the entries back to the client.
+static void DrainControlMessages(StcServerBase* const pBase, StcServerConnection* const pConnection) {
+    StcInfo* const pInfo = pConnection->pInfo;
+    const uint32_t tail = StcAtomicUint32Load(&pInfo->controlTail);
+    uint32_t head = StcAtomicUint32LoadRelaxed(&pInfo->controlHead);
+    if ((tail - head) > STC_CONTROL_RING_SIZE) {
+        StcLogMessage(&pBase->messenger, STC_MESSAGE_ID_SERVER_CLIENT_CONTROL_OVERRUN, tail - head, STC_CONTROL_RING_SIZE);
+        head = tail - STC_CONTROL_RING_SIZE;
+    }
+
+    const size_t connection = (size_t)(pConnection - pBase->connections);
+    for (; head != tail; ++head) {
+        StcControlMessage message = pInfo->controlMessages[head & (STC_CONTROL_RING_SIZE - 1)];
+        if (message.size > STC_CONTROL_PAYLOAD_SIZE) {
+            message.size = STC_CONTROL_PAYLOAD_SIZE;
+        }
+
+        switch (message.type) {
+            case STC_CONTROL_MESSAGE_TYPE_REQUEST_FRAME:
+                pConnection->requestedStreamMask = pConnection->streamMask;
+                for (size_t stream = 0; stream < STC_MAX_STREAM_COUNT; ++stream) {
+                    pConnection->nextWantedTicks[stream] = 0;
+                }
+                break;
+            case STC_CONTROL_MESSAGE_TYPE_PAUSE:
+                pConnection->paused = true;
+                break;
+            case STC_CONTROL_MESSAGE_TYPE_RESUME:
+                pConnection->paused = false;
+                break;
+            default:
+                break;
+        }
+
+        if (pBase->controller.pfnControl != NULL) {
+            pBase->controller.pfnControl(pBase->controller.pUserData, connection, &message);
+        }
+    }
+
+    StcAtomicUint32StoreRelease(&pInfo->controlHead, head);
+}
+
+// Returns the reason a connected client has to go, or STC_SERVER_STOP_REASON_NONE
+static StcServerStopReason TickClientConnection(StcServerBase* const pBase, StcServerConnection* const pConnection,
+                                                const int64_t count) {
+    StcServerStopReason reason = STC_SERVER_STOP_REASON_NONE;
+
+    const StcMessageCallbacks* const pMessenger = &pBase->messenger;
+    StcInfo* const pInfo = pConnection->pInfo;
+    const StcClientStopReason clientStopReason = StcAtomicUint32Load(&pInfo->clientStopReason);
+    if (clientStopReason != STC_CLIENT_STOP_REASON_NONE) {
+        StcLogMessage(pMessenger, STC_MESSAGE_ID_SERVER_CLIENT_REQUEST_STOP, StcGetClientReasonDescription(clientStopReason));
+        reason = STC_SERVER_STOP_REASON_CLIENT_REQUESTED;
+    } else if ((count - StcAtomicInt64LoadRelaxed(&pInfo->clientKeepAlive)) >= StcGetTimeoutTicks()) {
+        StcLogMessage(pMessenger, STC_MESSAGE_ID_SERVER_CLIENT_TIMEOUT);
+        reason = STC_SERVER_STOP_REASON_CLIENT_TIMED_OUT;
+    } else {
+        if ((pConnection->capabilities & STC_CAPABILITY_FLAG_LIVE_PARAMETERS) != 0) {
+            UpdateClientParameters(pBase, pConnection);
+        }
+
+        if ((pConnection->capabilities & STC_CAPABILITY_FLAG_CONTROL) != 0) {
+            DrainControlMessages(pBase, pConnection);
+        }
+    }
+
+    return reason;
+}
+
+#ifdef STC_TRANSPORT_PASSES_DESCRIPTORS
+// The client sends its descriptor as soon as it connects, so the receive only waits out that gap. A client stalled in it
+// must not stall the server for longer.
+#define STC_WAKE_DESCRIPTOR_TIMEOUT_MS 100
+
+static bool ExchangeWakeDescriptors(StcServerBase* const pBase, StcServerConnection* const pConnection, int* const pError) {
+    StcWakeDescriptorMessage message;
+    int fd;
+    if (!StcChannelSetReceiveTimeout(&pConnection->channel, STC_WAKE_DESCRIPTOR_TIMEOUT_MS, pError) ||
+        !StcChannelReceiveDescriptor(&pConnection->channel, &message, sizeof(message), &fd, pError)) {
+        return false;
+    }
+
+    StcEventAttachDescriptor(&pConnection->clientWake, fd);
+
+    message.reserved = 0;
+    return StcChannelSend(&pConnection->channel, &message, sizeof(message), &pBase->serverWake.fd, 1, pError);
+}
+#endif
+
+// Returns the reason the handshake failed, or STC_SERVER_STOP_REASON_NONE while it is pending or once it completes
+static StcServerStopReason TickPendingConnection(StcServerBase* const pBase, StcServerConnection* const pConnection,
+                                                 const int64_t count) {
+    StcServerStopReason reason = STC_SERVER_STOP_REASON_NONE;
+
+    const StcMessageCallbacks* const pMessenger = &pBase->messenger;
+    StcGlobalInfo* const pGlobalInfo = pBase->pGlobalInfo;
+    StcInfo* const pInfo = pConnection->pInfo;
+
+    // Fall through to the handshake in the same Tick, since the client's wake may already be consumed
+    if (!pConnection->clientInProgress && (StcAtomicInt64Load(&pGlobalInfo->connectToken) == 0)) {
+        pConnection->clientInProgress = true;
+        pConnection->clientFirstSeen = count;
+
+        StcLogMessage(pMessenger, STC_MESSAGE_ID_SERVER_CONNECT_TOKEN_TAKEN);
+    }
+
+    if (pConnection->clientInProgress) {
+        if ((count - pConnection->clientFirstSeen) >= StcGetTimeoutTicks()) {
+            StcLogMessage(pMessenger, STC_MESSAGE_ID_SERVER_CLIENT_TIMEOUT_HANDSHAKE);
+            reason = STC_SERVER_STOP_REASON_CLIENT_TIMED_OUT;
+        } else if (StcAtomicBoolLoad(&pInfo->clientParametersSpecified)) {
+            const StcApi clientApi = pInfo->clientApi;
+#ifdef STC_TRANSPORT_PASSES_DESCRIPTORS
+            int error;
+#endif
+            const uint32_t textureCount = pInfo->textureCount;
+            const uint32_t streamMask = pInfo->streamMask;
+            const StcCapabilityFlags capabilities = pInfo->clientCapabilities & STC_SUPPORTED_CAPABILITIES;
+            const uint32_t validStreamMask =
+                ((capabilities & STC_CAPABILITY_FLAG_STREAMS) != 0) ? ((1u << pBase->streamCount) - 1) : 1;
+            if (!StcIsClientApiSupported(pGlobalInfo->serverApi, clientApi)) {
+                StcLogMessage(pMessenger, STC_MESSAGE_ID_SERVER_CLIENT_API_UNSUPPORTED, StcGetApiName(pGlobalInfo->serverApi),
+                              (clientApi <= STC_API_CPU) ? StcGetApiName(clientApi) : "unknown");
+                reason = STC_SERVER_STOP_REASON_UNSUPPORTED_CLIENT_API;
+            } else if ((clientApi == STC_API_D3D11) && (pBase->clientCount > 0)) {
+                StcLogMessage(pMessenger, STC_MESSAGE_ID_SERVER_CLIENT_API_UNSHARED, StcGetApiName(clientApi),
+                              (uint32_t)pBase->clientCount);
+                reason = STC_SERVER_STOP_REASON_UNSHARED_CLIENT_API;
+            } else if ((textureCount < STC_MIN_TEXTURE_COUNT) || (textureCount > STC_MAX_TEXTURE_COUNT)) {
+                StcLogMessage(pMessenger, STC_MESSAGE_ID_SERVER_CLIENT_TEXTURE_COUNT_UNSUPPORTED, textureCount,
+                              STC_MIN_TEXTURE_COUNT, STC_MAX_TEXTURE_COUNT);
+                reason = STC_SERVER_STOP_REASON_UNSUPPORTED_TEXTURE_COUNT;
+            } else if ((streamMask == 0) || ((streamMask & ~validStreamMask) != 0)) {
+                StcLogMessage(pMessenger, STC_MESSAGE_ID_SERVER_CLIENT_STREAMS_UNSUPPORTED, streamMask,
+                              (uint32_t)pBase->streamCount);
+                reason = STC_SERVER_STOP_REASON_UNSUPPORTED_STREAMS;
+#ifdef STC_TRANSPORT_PASSES_DESCRIPTORS
+            } else if (!StcChannelAccept(&pConnection->listener, &pConnection->channel, &error)) {
+                // The client connects right after specifying parameters, so it may not be queued yet
+                if (error != EAGAIN) {
+                    StcLogMessage(pMessenger, STC_MESSAGE_ID_SERVER_FAIL_ACCEPT_CHANNEL, error);
+                    reason = STC_SERVER_STOP_REASON_FAIL_ACCEPT_CHANNEL;
+                }
+            } else if (((capabilities & STC_CAPABILITY_FLAG_WAKE_DESCRIPTORS) != 0) &&
+                       !ExchangeWakeDescriptors(pBase, pConnection, &error)) {
+                StcLogMessage(pMessenger, STC_MESSAGE_ID_SERVER_FAIL_EXCHANGE_WAKE_DESCRIPTORS, error);
+                reason = STC_SERVER_STOP_REASON_FAIL_EXCHANGE_WAKE_DESCRIPTORS;
+#endif
+            } else {
+                // The first client picks the ring depth. Later ones share the frames already in flight, so they are told
+                // the depth and get the existing frames announced by the backend.
+                if (pBase->clientCount == 0) {
+                    pBase->textureCount = textureCount;
+                    for (size_t stream = 0; stream < pBase->streamCount; ++stream) {
+                        pBase->streams[stream].copyIndex = textureCount - 1;
+                    }
+                } else {
+                    pInfo->textureCount = (uint32_t)pBase->textureCount;
+                    pConnection->announceFrames = true;
+                }
+
+                // A client that did not negotiate a feature gets the baseline behaviour, whatever else it wrote
+                pConnection->capabilities = capabilities;
+                pConnection->swapMode =
+                    ((capabilities & STC_CAPABILITY_FLAG_MAILBOX) != 0) ? pInfo->swapMode : STC_SWAP_MODE_FIFO;
+                pConnection->streamMask = streamMask;
+                pConnection->clientInProgress = false;
+                pConnection->connected = true;
+                ++pBase->clientCount;
+
+                // The client starts out holding the last slot of each stream, like a reader that just finished with it
+                for (size_t stream = 0; stream < pBase->streamCount; ++stream) {
+                    if ((streamMask & (1u << stream)) != 0) {
+                        StcAtomicUint32StoreRelaxed(&pInfo->streams[stream].slotStates[pBase->textureCount - 1],
+                                                    STC_SLOT_STATE_READING);
+                    }
+                }
+
+                StcAtomicBoolStoreRelease(&pInfo->serverInitialized, true);
+                StcEventSignal(&pConnection->clientWake);
+
+                StcLogMessage(pMessenger, STC_MESSAGE_ID_SERVER_CONNECT_HANDSHAKE_COMPLETE, (uint32_t)pBase->textureCount,
+                              capabilities);
+            }
+        }
+    }
+
+    return reason;
+}
+
+// A client that fails or leaves is closed on its own. Only when it takes the last reader with it does TickServer report
+// the reason, so the backend can release the frames and start over.
+static StcServerStatus TickServer(StcServerBase* const pBase, StcServerStopReason* const pReason) {
+    const int64_t count = StcGetCurrentTicks();
+
+    StcServerStatus status = OfferConnection(pBase);
+    pBase->wakeToken = StcEventGetToken(&pBase->serverWake);
+
+    bool connectInProgress = false;
+    for (size_t i = 0; (*pReason == STC_SERVER_STOP_REASON_NONE) && (i < STC_MAX_CLIENT_COUNT); ++i) {
+        StcServerConnection* const pConnection = &pBase->connections[i];
+        StcInfo* const pInfo = pConnection->pInfo;
+        if (pInfo != NULL) {
+            // Only a stale keepalive is rewritten, so the client's core keeps its copy of the line between refreshes
+            if ((count - StcAtomicInt64LoadRelaxed(&pInfo->serverKeepAlive)) >= (StcGetTimeoutTicks() / STC_KEEP_ALIVE_DIVISOR)) {
+                StcAtomicInt64StoreRelaxed(&pInfo->serverKeepAlive, count);
+            }
+
+            const bool connected = pConnection->connected;
+            const StcServerStopReason reason = connected ? TickClientConnection(pBase, pConnection, count)
+                                                         : TickPendingConnection(pBase, pConnection, count);
+            if (reason != STC_SERVER_STOP_REASON_NONE) {
+                if (pBase->clientCount > (connected ? 1u : 0u)) {
+                    CloseConnection(pBase, pConnection, reason);
+                } else {
+                    pConnection->clientInProgress = false;
+
+                    StcAtomicUint32StoreRelease(&pInfo->serverStopReason, reason);
+                    StcEventSignal(&pConnection->clientWake);
+                    *pReason = reason;
+                }
+            } else if (pConnection->clientInProgress) {
+                connectInProgress = true;
+            }
+        }
+    }
+
+    PublishLeaseLimits(pBase);
+
+    if (pBase->clientCount > 0) {
+        status = STC_SERVER_STATUS_SUCCESS;
+    } else if (status == STC_SERVER_STATUS_SUCCESS) {
+        status = connectInProgress ? STC_SERVER_STATUS_FAIL_CONNECT_IN_PROGRESS : STC_SERVER_STATUS_FAIL_DISCONNECTED;
+    }
+
+    return status;
+}
+
+static StcServerStatus StcServerWait(StcServerBase* const pBase, const uint32_t timeoutMs) {
+    StcServerStatus status = STC_SERVER_STATUS_SUCCESS;
+
+    // With no connection open the next Tick has to retry opening one, so there is nothing to wait for
+    bool open = false;
+    for (size_t i = 0; i < STC_MAX_CLIENT_COUNT; ++i) {
+        open = open || (pBase->connections[i].pInfo != NULL);
+    }
+
+    // Anything signalled since the last Tick looked at shared state is still pending in wakeToken
+    if (open && !StcEventWait(&pBase->serverWake, pBase->wakeToken, timeoutMs)) {
+        status = STC_SERVER_STATUS_FAIL_WAIT_TIMEOUT;
+    }
+
+    return status;
+}
+
+// A paused client still gets the one frame it explicitly requested
+static bool IsDelivering(const StcServerConnection* const pConnection, const size_t stream) {
+    return !pConnection->paused || ((pConnection->requestedStreamMask & (1u << stream)) != 0);
+}
+
+// A client that asked for a frame interval is due once its next wanted time passes. Any due subscriber makes the frame
+// worth copying, and the others get it too, except for those that paused.
+static bool IsFrameWanted(const StcServerBase* const pBase, const size_t stream) {
+    const int64_t now = StcGetCurrentTicks();
+
+    bool wanted = false;
+    for (size_t i = 0; !wanted && (i < STC_MAX_CLIENT_COUNT); ++i) {
+        const StcServerConnection* const pConnection = &pBase->connections[i];
+        wanted = (GetClientStreamInfo(pBase, stream, i) != NULL) && IsDelivering(pConnection, stream) &&
+                 (now >= pConnection->nextWantedTicks[stream]);
+    }
+
+    return wanted;
+}
+
+// Steps from the previous wanted time rather than from now, so a client keeps its average rate even though frames only
+// land on the server's cadence. One that fell a whole interval behind starts over instead of catching up in a burst.
+static void AdvanceNextWanted(const StcServerBase* const pBase, StcServerConnection* const pConnection, const size_t stream,
+                              const int64_t publishTicks) {
+    const uint32_t intervalMicroseconds = ((pConnection->capabilities & STC_CAPABILITY_FLAG_FRAME_INTERVAL) != 0)
+                                              ? StcAtomicUint32LoadRelaxed(&pConnection->pInfo->frameIntervalMicroseconds)
+                                              : 0;
+    int64_t* const pNextWanted = &pConnection->nextWantedTicks[stream];
+    if (intervalMicroseconds == 0) {
+        *pNextWanted = 0;
+    } else if (publishTicks >= *pNextWanted) {
+        const int64_t intervalTicks = ((int64_t)intervalMicroseconds * pBase->tickFrequency) / 1000000;
+        *pNextWanted += intervalTicks;
+        if (*pNextWanted <= publishTicks) {
+            *pNextWanted = publishTicks + intervalTicks;
+        }
+    }
+}
+
+// The record is stamped before the state word is released so each client sees it along with the frame. A sliced publish
+// happens at the first slice and only reaches clients that read slices. SignalWrite then publishes to the rest, and
+// completes the frame for the slice readers that already have it. A paused client gets its copy of the slot handed
+// straight back, so it never holds up the ring.
+static void PublishSlot(StcServerBase* const pBase, const size_t stream, const bool sliced) {
+    StcServerStream* const pStream = &pBase->streams[stream];
+    const size_t copyIndex = pStream->copyIndex;
+    if (sliced || (pStream->completedSlices == 0)) {
+        ++pStream->frameSequence;
+    }
+
+    const uint64_t sequence = pStream->frameSequence;
+    const uint32_t progress = sliced ? pStream->completedSlices : pStream->frameSliceCount;
+    const int64_t publishTicks = StcGetCurrentTicks();
+    for (size_t i = 0; i < STC_MAX_CLIENT_COUNT; ++i) {
+        StcStreamInfo* const pInfo = GetClientStreamInfo(pBase, stream, i);
+        if (pInfo != NULL) {
+            StcServerConnection* const pConnection = &pBase->connections[i];
+            const bool readsSlices = (pConnection->capabilities & STC_CAPABILITY_FLAG_SLICES) != 0;
+            if (StcAtomicUint32LoadRelaxed(&pInfo->slotStates[copyIndex]) == STC_SLOT_STATE_WRITING) {
+                if (!IsDelivering(pConnection, stream)) {
+                    if (!sliced) {
+                        StcAtomicUint32StoreRelease(&pInfo->slotStates[copyIndex], STC_SLOT_STATE_FREE);
+                    }
+                } else if (!sliced || readsSlices) {
+                    pConnection->requestedStreamMask &= ~(1u << stream);
+
+                    StcFrameRecord* const pRecord = &pInfo->frameRecords[copyIndex];
+                    pRecord->sequence = sequence;
+                    pRecord->publishTicks = publishTicks;
+                    pRecord->sliceCount = readsSlices ? pStream->frameSliceCount : 1;
+                    pRecord->resizeGeneration = pStream->resizeGeneration;
+                    pInfo->sliceHeights[copyIndex] = StcComputeSliceHeight(pStream->graphicsInfo.height, pRecord->sliceCount);
+                    StcAtomicUint32StoreRelaxed(&pInfo->sliceProgress[copyIndex], readsSlices ? progress : 1);
+
+                    StcAtomicUint32StoreRelease(&pInfo->slotStates[copyIndex], StcSlotMakeState(STC_SLOT_STATE_READY, sequence));
+                    StcEventSignal(&pBase->connections[i].clientWake);
+
+                    AdvanceNextWanted(pBase, &pBase->connections[i], stream, publishTicks);
+                }
+            } else if (!sliced && readsSlices) {
+                StcAtomicUint32StoreRelease(&pInfo->sliceProgress[copyIndex], progress);
+                StcEventSignal(&pBase->connections[i].clientWake);
+            }
+        }
+    }
+}
+
+// Counts one more slice of the frame being written as finished. The first one publishes the frame to slice readers, later
+// ones only move their progress on.
+static void CompleteSlice(StcServerBase* const pBase, const size_t stream) {
+    StcServerStream* const pStream = &pBase->streams[stream];
+    ++pStream->completedSlices;
+    if (pStream->completedSlices == 1) {
+        PublishSlot(pBase, stream, true);
+    } else {
+        const size_t copyIndex = pStream->copyIndex;
+        for (size_t i = 0; i < STC_MAX_CLIENT_COUNT; ++i) {
+            StcStreamInfo* const pInfo = GetClientStreamInfo(pBase, stream, i);
+            if ((pInfo != NULL) && ((pBase->connections[i].capabilities & STC_CAPABILITY_FLAG_SLICES) != 0)) {
+                StcAtomicUint32StoreRelease(&pInfo->sliceProgress[copyIndex], pStream->completedSlices);
+                StcEventSignal(&pBase->connections[i].clientWake);
+            }
+        }
+    }
+}
+
+// Stamps the slot being written with the sequence PublishSlot is about to give it, so clients can tell the metadata
+// apart from what an earlier frame left behind. Each subscriber gets its own copy, like the frame record. Outside Tick and
+// SignalWrite the slot may be one a client is reading, so the write is refused.
+static StcServerStatus WriteFrameMetadata(StcServerBase* const pBase, const size_t stream, const void* const pData,
+                                          const size_t size) {
+    StcServerStatus status = STC_SERVER_STATUS_FAIL_METADATA_TOO_LARGE;
+
+    if (stream >= pBase->streamCount) {
+        status = STC_SERVER_STATUS_FAIL_INVALID_STREAM;
+    } else if ((pBase->writingStreamMask & (1u << stream)) == 0) {
+        status = STC_SERVER_STATUS_FAIL_NOT_WRITING;
+    } else if (size <= pBase->metadataCapacity) {
+        const size_t copyIndex = pBase->streams[stream].copyIndex;
+        const StcServerStream* const pStream = &pBase->streams[stream];
+        const uint64_t sequence = pStream->frameSequence + ((pStream->completedSlices == 0) ? 1 : 0);
+        for (size_t i = 0; i < STC_MAX_CLIENT_COUNT; ++i) {
+            if ((GetClientStreamInfo(pBase, stream, i) != NULL) &&
+                ((pBase->connections[i].capabilities & STC_CAPABILITY_FLAG_FRAME_METADATA) != 0)) {
+                StcFrameMetadata* const pMetadata =
+                    StcGetFrameMetadata(pBase->connections[i].pInfo, pBase->metadataCapacity, stream, copyIndex);
+                const uint32_t lock = StcAtomicUint32LoadRelaxed(&pMetadata->lock);
+                StcAtomicUint32StoreRelaxed(&pMetadata->lock, lock + 1);
+                StcAtomicFenceRelease();
+
+                pMetadata->size = (uint32_t)size;
+                pMetadata->frameSequence = sequence;
+                memcpy(pMetadata + 1, pData, size);
+
+                StcAtomicUint32StoreRelease(&pMetadata->lock, lock + 2);
+            }
+        }
+
+        status = STC_SERVER_STATUS_SUCCESS;
+    }
+
+    return status;
+}
+
+// Never waits on a client. One whose ring is full loses the record, and learns how many it lost with the next one that
+// fits. The wake word skips the signal while the client is not waiting, so a burst of records costs no system calls.
+static void AppendAuxRecord(StcServerBase* const pBase, StcServerConnection* const pConnection,
+                            const StcAuxRecordHeader* const pHeader, const void* const pData) {
+    StcInfo* const pInfo = pConnection->pInfo;
+    char* const pRing = StcGetAuxRing(pInfo, pBase->metadataCapacity);
+    const uint32_t head = StcAtomicUint32Load(&pInfo->auxHead);
+    uint32_t tail = StcAtomicUint32LoadRelaxed(&pInfo->auxTail);
+    const uint32_t stride = StcGetAuxRecordStride(pHeader->size);
+    const uint32_t contiguous = STC_AUX_RING_SIZE - (tail & (STC_AUX_RING_SIZE - 1));
+    const uint32_t needed = (contiguous < stride) ? (contiguous + stride) : stride;
+    if ((tail - head) + needed > STC_AUX_RING_SIZE) {
+        ++pConnection->auxDropped;
+    } else {
+        if (contiguous < stride) {
+            StcAuxRecordHeader* const pWrap = StcGetAuxRecordHeader(pRing, tail);
+            pWrap->type = STC_AUX_RECORD_TYPE_WRAP;
+            pWrap->size = contiguous - (uint32_t)sizeof(StcAuxRecordHeader);
+            tail += contiguous;
+        }
+
+        StcAuxRecordHeader* const pRecord = StcGetAuxRecordHeader(pRing, tail);
+        *pRecord = *pHeader;
+        pRecord->droppedBefore = pConnection->auxDropped;
+        memcpy(pRecord + 1, pData, pHeader->size);
+        pConnection->auxDropped = 0;
+
+        StcAtomicUint32StoreRelease(&pInfo->auxTail, tail + stride);
+        StcEventSignal(&pConnection->clientWake);
+    }
+}
+
+// Goes to every client subscribed to the stream that negotiated auxiliary records, stamped with the time it was written
+// and the newest frame the stream has published
+static StcServerStatus WriteAuxRecord(StcServerBase* const pBase, const size_t stream, const uint32_t type,
+                                      const void* const pData, const size_t size) {
+    StcServerStatus status = STC_SERVER_STATUS_FAIL_AUX_RECORD_TOO_LARGE;
+
+    if (stream >= pBase->streamCount) {
+        status = STC_SERVER_STATUS_FAIL_INVALID_STREAM;
+    } else if ((size <= STC_MAX_AUX_RECORD_SIZE) && (type != STC_AUX_RECORD_TYPE_WRAP)) {
+        StcAuxRecordHeader header;
+        header.type = type;
+        header.size = (uint32_t)size;
+        header.stream = (uint32_t)stream;
+        header.droppedBefore = 0;
+        header.ticks = StcGetCurrentTicks();
+        header.frameSequence = pBase->streams[stream].frameSequence;
+        for (size_t i = 0; i < STC_MAX_CLIENT_COUNT; ++i) {
+            StcServerConnection* const pConnection = &pBase->connections[i];
+            if ((GetClientStreamInfo(pBase, stream, i) != NULL) &&
+                ((pConnection->capabilities & STC_CAPABILITY_FLAG_AUX_RECORDS) != 0)) {
+                AppendAuxRecord(pBase, pConnection, &header, pData);
+            }
+        }
+
+        status = STC_SERVER_STATUS_SUCCESS;
+    }
+
+    return status;
+}
+
+// Picks the slot to write next. Every client has its own state word per slot, and a slot is free once all of them are, so
+// the words double as the slot's reader count. Slots come back in any order, so the whole ring is scanned starting after
+// the last write. When the ring is full, the oldest published frame nobody has claimed is taken back if the client asked
+// for mailbox mode, or if there are several clients and a slow one must not hold up the rest. Only subscribers of the
+// stream count, and a stream nobody subscribes to has no slot to write.
+static bool AcquireWriteSlot(StcServerBase* const pBase, const size_t stream, size_t* const pCopyIndex) {
+    const size_t textureCount = pBase->textureCount;
+
+    size_t subscriberCount = 0;
+    bool reclaim = false;
+    for (size_t c = 0; c < STC_MAX_CLIENT_COUNT; ++c) {
+        if (GetClientStreamInfo(pBase, stream, c) != NULL) {
+            ++subscriberCount;
+            reclaim = reclaim || (pBase->connections[c].swapMode == STC_SWAP_MODE_MAILBOX);
+        }
+    }
+
+    reclaim = reclaim || (subscriberCount > 1);
+
+    bool acquired = false;
+    for (size_t i = 1; !acquired && (subscriberCount > 0) && (i <= textureCount); ++i) {
+        const size_t index = (pBase->streams[stream].copyIndex + i) % textureCount;
+
+        // Only the server moves a slot out of FREE, so no compare-exchange is needed
+        bool free = true;
+        for (size_t c = 0; free && (c < STC_MAX_CLIENT_COUNT); ++c) {
+            StcStreamInfo* const pInfo = GetClientStreamInfo(pBase, stream, c);
+            free = (pInfo == NULL) || (StcAtomicUint32Load(&pInfo->slotStates[index]) == STC_SLOT_STATE_FREE);
+        }
+
+        if (free) {
+            for (size_t c = 0; c < STC_MAX_CLIENT_COUNT; ++c) {
+                StcStreamInfo* const pInfo = GetClientStreamInfo(pBase, stream, c);
+                if (pInfo != NULL) {
+                    StcAtomicUint32StoreRelaxed(&pInfo->slotStates[index], STC_SLOT_STATE_WRITING);
+                }
+            }
+
+            *pCopyIndex = index;
+            acquired = true;
+        }
+    }
+
+    while (!acquired && reclaim) {
+        size_t oldestIndex = textureCount;
+        uint32_t oldestState = 0;
+        for (size_t index = 0; index < textureCount; ++index) {
+            bool claimed = false;
+            uint32_t readyState = STC_SLOT_STATE_FREE;
+            for (size_t c = 0; c < STC_MAX_CLIENT_COUNT; ++c) {
+                StcStreamInfo* const pInfo = GetClientStreamInfo(pBase, stream, c);
+                if (pInfo != NULL) {
+                    const uint32_t state = StcAtomicUint32Load(&pInfo->slotStates[index]);
+                    if ((state & STC_SLOT_STATE_MASK) == STC_SLOT_STATE_READY) {
+                        readyState = state;
+                    } else if (state != STC_SLOT_STATE_FREE) {
+                        claimed = true;
+                    }
+                }
+            }
+
+            if (!claimed && (readyState != STC_SLOT_STATE_FREE) &&
+                ((oldestIndex == textureCount) || StcSlotIsOlder(readyState, oldestState))) {
+                oldestIndex = index;
+                oldestState = readyState;
+            }
+        }
+
+        if (oldestIndex == textureCount) {
+            break;
+        }
+
+        // Clients may claim or drop the same frame concurrently. One that claimed it keeps it, so the slot is handed back
+        // to the others as it was and the scan is repeated.
+        uint32_t previousStates[STC_MAX_CLIENT_COUNT];
+        size_t takenCount = 0;
+        bool claimed = false;
+        for (; !claimed && (takenCount < STC_MAX_CLIENT_COUNT); ++takenCount) {
+            StcStreamInfo* const pInfo = GetClientStreamInfo(pBase, stream, takenCount);
+            if (pInfo != NULL) {
+                StcAtomicUint32* const pState = &pInfo->slotStates[oldestIndex];
+                uint32_t state = StcAtomicUint32Load(pState);
+                bool taken = false;
+                while (!taken && !claimed) {
+                    if ((state & STC_SLOT_STATE_MASK) == STC_SLOT_STATE_READING) {
+                        claimed = true;
+                    } else {
+                        const uint32_t observed = StcAtomicUint32CompareExchange(pState, STC_SLOT_STATE_WRITING, state);
+                        taken = (observed == state);
+                        state = observed;
+                    }
+                }
+
+                previousStates[takenCount] = state;
+            }
+        }
+
+        if (claimed) {
+            for (size_t c = 0; c + 1 < takenCount; ++c) {
+                StcStreamInfo* const pInfo = GetClientStreamInfo(pBase, stream, c);
+                if (pInfo != NULL) {
+                    StcAtomicUint32StoreRelease(&pInfo->slotStates[oldestIndex], previousStates[c]);
+                }
+            }
+        } else {
+            *pCopyIndex = oldestIndex;
+            acquired = true;
+        }
+    }
+
+    return acquired;
+}
+
+#ifdef _WIN32
+static StcServerStatus StcServerD3D11ConnectionTick(StcServerD3D11* const pServer) {
+    StcServerBase* const pBase = &pServer->base;
     StcServerStopReason reason = STC_SERVER_STOP_REASON_NONE;
     StcServerStatus status = TickServer(pBase, &reason);
     if (reason != STC_SERVER_STOP_REASON_NONE) {
@@ -1254,10 +2511,28 @@ static StcServerStatus StcServerD3D11ConnectionTick(StcServerD3D11* const pServe
     return status;
 }
 
+// Readers are opened once their handshake completes, and closed once TickServer dropped their connection
 static StcServerStatus StcServerD3D12ConnectionTick(StcServerD3D12* const pServer) {
     StcServerBase* const pBase = &pServer->base;
     StcServerStopReason reason = STC_SERVER_STOP_REASON_NONE;
     StcServerStatus status = TickServer(pBase, &reason);
+    for (size_t i = 0; (reason == STC_SERVER_STOP_REASON_NONE) && (i < STC_MAX_CLIENT_COUNT); ++i) {
+        StcServerConnection* const pConnection = &pBase->connections[i];
+        if (pServer->readerOpen[i] && !pConnection->connected) {
+            WaitForD3D12Writes(pServer);
+            CloseD3D12Reader(pServer, i);
+        } else if (!pServer->readerOpen[i] && pConnection->connected) {
+            const StcServerStopReason readerReason = OpenD3D12Reader(pServer, i);
+            if (readerReason != STC_SERVER_STOP_REASON_NONE) {
+                if (pBase->clientCount > 1) {
+                    CloseConnection(pBase, pConnection, readerReason);
+                } else {
+                    reason = readerReason;
+                }
+            }
+        }
+    }
+
     if (reason != STC_SERVER_STOP_REASON_NONE) {
         status = ReopenServerD3D12(pServer, reason, pBase->pGlobalInfo);
         if (status == STC_SERVER_STATUS_SUCCESS) {
@@ -1274,13 +2549,16 @@ StcServerStatus StcServerD3D11Tick(StcServerD3D11* const pServer, StcServerD3D11
         status = STC_SERVER_STATUS_FAIL_NO_FRAMES_AVAIALBLE;
 
         StcServerBase* const pBase = &pServer->base;
+        if (ApplyResize(pBase, 0)) {
+            DiscardPendingD3D11Frames(pServer);
+        }
         const StcMessageCallbacks* const pMessenger = &pBase->messenger;
-        StcInfo* const pInfo = pBase->pInfo;
-        if (StcAtomicUint32Load(&pInfo->pendingWrites) > 0) {
-            StcAtomicUint32Decrement(&pInfo->pendingWrites);
-
+        StcInfo* const pInfo = pBase->connections[0].pInfo;
+        size_t copyIndex;
+        if (!IsFrameWanted(pBase, 0)) {
+            status = STC_SERVER_STATUS_FAIL_FRAME_NOT_WANTED;
+        } else if (AcquireWriteSlot(pBase, 0, &copyIndex)) {
             StcServerStopReason reason = STC_SERVER_STOP_REASON_NONE;
-            const size_t copyIndex = (pBase->copyIndex + 1) % STC_TEXTURE_COUNT;
 
             if (pServer->pTextures[copyIndex] != NULL) {
                 HRESULT hr = IDXGIKeyedMutex_AcquireSync(pServer->pKeyedMutexes[copyIndex], STC_KEY_CLIENT, 0);
@@ -1297,31 +2575,34 @@ StcServerStatus StcServerD3D11Tick(StcServerD3D11* const pServer, StcServerD3D11
             }
 
             if (reason == STC_SERVER_STOP_REASON_NONE) {
-                pBase->copyIndex = copyIndex;
+                pBase->streams[0].copyIndex = copyIndex;
 
-                if (pBase->needResize[copyIndex]) {
+                if (pBase->streams[0].needResize[copyIndex]) {
                     StcLogMessage(pMessenger, STC_MESSAGE_ID_SERVER_D3D11_CREATE_FRAME_ATTEMPT, (int)copyIndex);
 
-                    const bool need12 = pInfo->clientApi == STC_API_D3D12;
-                    ResourceFrame11 frame;
-                    reason = CreateD3D11ResourceFrame(pServer, need12, &frame);
+                    if (pServer->pendingFrames[copyIndex].pTexture == NULL) {
+                        reason = CreateD3D11ResourceFrames(pServer, pInfo->clientApi == STC_API_D3D12);
+                    }
 
                     if (reason == STC_CLIENT_STOP_REASON_NONE) {
+                        const StcServerD3D11Frame frame = pServer->pendingFrames[copyIndex];
+                        pServer->pendingFrames[copyIndex].pTexture = NULL;
+
                         if (pServer->pTextures[copyIndex] != NULL) {
                             pServer->allocator.pfnDestroy(pServer->allocator.pUserData, copyIndex);
 
                             ID3D11Texture2D_Release(pServer->pTextures[copyIndex]);
                             IDXGIKeyedMutex_Release(pServer->pKeyedMutexes[copyIndex]);
                             if (!pServer->usesLegacyHandles) {
-                                CloseHandle((HANDLE)(uintptr_t)pInfo->hTextures[copyIndex]);
+                                CloseHandle((HANDLE)(uintptr_t)pInfo->streams[0].hTextures[copyIndex]);
                             }
 
                             if (pServer->pTextures11On12[copyIndex] != NULL) {
                                 ID3D11Texture2D_Release(pServer->pTextures11On12[copyIndex]);
                                 ID3D11Fence_Release(pServer->pWriteFences11On12[copyIndex]);
                                 ID3D11Fence_Release(pServer->pReadFences11On12[copyIndex]);
-                                CloseHandle((HANDLE)(uintptr_t)pInfo->hWriteFences12[copyIndex]);
-                                CloseHandle((HANDLE)(uintptr_t)pInfo->hReadFences12[copyIndex]);
+                                CloseHandle((HANDLE)(uintptr_t)pInfo->streams[0].hWriteFences12[copyIndex]);
+                                CloseHandle((HANDLE)(uintptr_t)pInfo->streams[0].hReadFences12[copyIndex]);
                             }
                         }
 
@@ -1330,14 +2611,14 @@ StcServerStatus StcServerD3D11Tick(StcServerD3D11* const pServer, StcServerD3D11
                         pServer->pTextures11On12[copyIndex] = frame.pTexture11On12;
                         pServer->pWriteFences11On12[copyIndex] = frame.pWriteFence11On12;
                         pServer->pReadFences11On12[copyIndex] = frame.pReadFence11On12;
-                        pBase->needResize[copyIndex] = false;
+                        pBase->streams[0].needResize[copyIndex] = false;
 
-                        pInfo->hTextures[copyIndex] = (uint32_t)(uintptr_t)frame.hTexture;
-                        pInfo->hWriteFences12[copyIndex] = (uint32_t)(uintptr_t)frame.hWriteFence11On12;
-                        pInfo->hReadFences12[copyIndex] = (uint32_t)(uintptr_t)frame.hReadFence11On12;
-                        pInfo->writeFenceValues12[copyIndex] = 0;
-                        pInfo->readFenceValues12[copyIndex] = 0;
-                        pInfo->invalidated[copyIndex] = true;
+                        pInfo->streams[0].hTextures[copyIndex] = (uint32_t)(uintptr_t)frame.hTexture;
+                        pInfo->streams[0].hWriteFences12[copyIndex] = (uint32_t)(uintptr_t)frame.hWriteFence11On12;
+                        pInfo->streams[0].hReadFences12[copyIndex] = (uint32_t)(uintptr_t)frame.hReadFence11On12;
+                        pInfo->streams[0].writeFenceValues12[copyIndex] = 0;
+                        pInfo->streams[0].readFenceValues12[copyIndex] = 0;
+                        pInfo->streams[0].invalidated[copyIndex] = true;
 
                         if (pServer->allocator.pfnCreate(pServer->allocator.pUserData, copyIndex, frame.pTexture)) {
                             StcLogMessage(pMessenger, STC_MESSAGE_ID_SERVER_D3D11_CREATE_FRAME_SUCCESS, (int)copyIndex);
@@ -1352,6 +2633,7 @@ StcServerStatus StcServerD3D11Tick(StcServerD3D11* const pServer, StcServerD3D11
             if (reason == STC_SERVER_STOP_REASON_NONE) {
                 pNextInfo->pTexture = pServer->pTextures[copyIndex];
                 pNextInfo->index = copyIndex;
+                pBase->writingStreamMask = 1;
                 status = STC_SERVER_STATUS_SUCCESS;
             } else {
                 ReopenServerD3D11(pServer, reason, pBase->pGlobalInfo);
@@ -1369,14 +2651,16 @@ StcServerStatus StcServerD3D12Tick(StcServerD3D12* const pServer, StcServerD3D12
         status = STC_SERVER_STATUS_FAIL_NO_FRAMES_AVAIALBLE;
 
         StcServerBase* const pBase = &pServer->base;
+        if (ApplyResize(pBase, 0)) {
+            DiscardPendingD3D12Frames(pServer);
+        }
         const StcMessageCallbacks* const pMessenger = &pBase->messenger;
-        StcInfo* const pInfo = pBase->pInfo;
-        if (StcAtomicUint32Load(&pInfo->pendingWrites) > 0) {
-            StcAtomicUint32Decrement(&pInfo->pendingWrites);
-
+        size_t copyIndex;
+        if (!IsFrameWanted(pBase, 0)) {
+            status = STC_SERVER_STATUS_FAIL_FRAME_NOT_WANTED;
+        } else if (AcquireWriteSlot(pBase, 0, &copyIndex)) {
             StcServerStopReason reason = STC_SERVER_STOP_REASON_NONE;
-            const size_t copyIndex = (pBase->copyIndex + 1) % STC_TEXTURE_COUNT;
-            const bool need11 = pInfo->clientApi == STC_API_D3D11;
+            const bool need11 = HasD3D11Reader(pServer);
 
             if (need11 && (pServer->pTextures[copyIndex] != NULL)) {
                 HRESULT hr = IDXGIKeyedMutex_AcquireSync(pServer->pKeyedMutexes11[copyIndex], STC_KEY_CLIENT, 0);
@@ -1396,57 +2680,53 @@ StcServerStatus StcServerD3D12Tick(StcServerD3D12* const pServer, StcServerD3D12
             }
 
             if (reason == STC_SERVER_STOP_REASON_NONE) {
-                pBase->copyIndex = copyIndex;
+                pBase->streams[0].copyIndex = copyIndex;
 
-                if (pBase->needResize[copyIndex]) {
+                if (pBase->streams[0].needResize[copyIndex]) {
                     StcLogMessage(pMessenger, STC_MESSAGE_ID_SERVER_D3D12_CREATE_FRAME_ATTEMPT, (int)copyIndex);
 
-                    ResourceFrame12 frame;
-                    reason = CreateD3D12ResourceFrame(pServer, need11, &frame);
+                    if (pServer->pendingFrames[copyIndex].pTexture == NULL) {
+                        reason = CreateD3D12ResourceFrames(pServer, need11);
+                    }
 
                     if (reason == STC_CLIENT_STOP_REASON_NONE) {
+                        const StcServerD3D12Frame frame = pServer->pendingFrames[copyIndex];
+                        pServer->pendingFrames[copyIndex].pTexture = NULL;
+
                         if (pServer->pTextures[copyIndex] != NULL) {
-                            ID3D12Fence* const fence = pServer->pWriteFences[copyIndex];
-                            const UINT64 fenceValue = pInfo->writeFenceValues12[copyIndex];
-                            if (ID3D12Fence_GetCompletedValue(fence) < fenceValue) {
-                                const HANDLE hFenceClearedAutoEvent = pServer->hFenceClearedAutoEvent;
-                                ID3D12Fence_SetEventOnCompletion(fence, fenceValue, hFenceClearedAutoEvent);
-                                WaitForSingleObject(hFenceClearedAutoEvent, INFINITE);
-                            }
+                            WaitForD3D12Write(pServer, copyIndex);
 
                             pServer->allocator.pfnDestroy(pServer->allocator.pUserData, copyIndex);
 
                             ID3D12Resource_Release(pServer->pTextures[copyIndex]);
-                            CloseHandle((HANDLE)(uintptr_t)pInfo->hTextures[copyIndex]);
+                            CloseHandle(pServer->hTextures[copyIndex]);
 
                             ID3D12Fence_Release(pServer->pWriteFences[copyIndex]);
 
-                            if (need11) {
+                            if (pServer->pTextures11[copyIndex] != NULL) {
                                 ID3D11Texture2D_Release(pServer->pTextures11[copyIndex]);
                                 IDXGIKeyedMutex_Release(pServer->pKeyedMutexes11[copyIndex]);
                             } else {
-                                ID3D12Fence_Release(pServer->pReadFences[copyIndex]);
-                                CloseHandle((HANDLE)(uintptr_t)pInfo->hWriteFences12[copyIndex]);
-                                CloseHandle((HANDLE)(uintptr_t)pInfo->hReadFences12[copyIndex]);
+                                CloseHandle(pServer->hWriteFences[copyIndex]);
                             }
                         }
 
                         pServer->pTextures[copyIndex] = frame.pTexture;
                         pServer->pWriteFences[copyIndex] = frame.pWriteFence;
-                        pServer->pReadFences[copyIndex] = frame.pReadFence;
-                        if (need11) {
-                            pServer->pTextures11[copyIndex] = frame.pTexture11;
-                            pServer->pKeyedMutexes11[copyIndex] = frame.pKeyedMutex11;
+                        pServer->hTextures[copyIndex] = frame.hTexture;
+                        pServer->hWriteFences[copyIndex] = frame.hWriteFence;
+                        pServer->writeFenceValues[copyIndex] = 0;
+                        pServer->pTextures11[copyIndex] = frame.pTexture11;
+                        pServer->pKeyedMutexes11[copyIndex] = frame.pKeyedMutex11;
+
+                        // Read fences are kept, so their values carry on across the new frame
+                        for (size_t i = 0; i < STC_MAX_CLIENT_COUNT; ++i) {
+                            if (pServer->readerOpen[i]) {
+                                AnnounceD3D12Frame(pServer, &pBase->connections[i].pInfo->streams[0], copyIndex);
+                            }
                         }
 
-                        pInfo->hTextures[copyIndex] = (uint32_t)(uintptr_t)frame.hTexture;
-                        pInfo->hWriteFences12[copyIndex] = (uint32_t)(uintptr_t)frame.hWriteFence;
-                        pInfo->hReadFences12[copyIndex] = (uint32_t)(uintptr_t)frame.hReadFence;
-                        pInfo->writeFenceValues12[copyIndex] = 0;
-                        pInfo->readFenceValues12[copyIndex] = 0;
-                        pInfo->invalidated[copyIndex] = true;
-
-                        pBase->needResize[copyIndex] = false;
+                        pBase->streams[0].needResize[copyIndex] = false;
 
                         if (pServer->allocator.pfnCreate(pServer->allocator.pUserData, copyIndex, frame.pTexture)) {
                             StcLogMessage(pMessenger, STC_MESSAGE_ID_SERVER_D3D12_CREATE_FRAME_SUCCESS, (int)copyIndex);
@@ -1459,8 +2739,18 @@ StcServerStatus StcServerD3D12Tick(StcServerD3D12* const pServer, StcServerD3D12
             }
 
             if (reason == STC_SERVER_STOP_REASON_NONE) {
+                // A D3D11 reader only gets the frame through the keyed mutex at SignalWrite, so it is never sliced
+                StcServerStream* const pStream = &pBase->streams[0];
+                const UINT height = pStream->graphicsInfo.height;
+                const UINT sliceHeight = StcComputeSliceHeight(height, need11 ? 1 : pStream->sliceCount);
+                pStream->frameSliceCount = (sliceHeight > 0) ? ((height + sliceHeight - 1) / sliceHeight) : 1;
+                pStream->completedSlices = 0;
+
                 pNextInfo->pTexture = pServer->pTextures[copyIndex];
                 pNextInfo->index = copyIndex;
+                pNextInfo->sliceCount = pStream->frameSliceCount;
+                pNextInfo->sliceHeight = sliceHeight;
+                pBase->writingStreamMask = 1;
                 status = STC_SERVER_STATUS_SUCCESS;
             } else {
                 ReopenServerD3D12(pServer, reason, pBase->pGlobalInfo);
@@ -1477,12 +2767,12 @@ StcServerStatus StcServerD3D11WaitForClientRead(StcServerD3D11* const pServer) {
 
     StcServerBase* const pBase = &pServer->base;
     const StcMessageCallbacks* const pMessenger = &pBase->messenger;
-    StcInfo* const pInfo = pBase->pInfo;
+    StcInfo* const pInfo = pBase->connections[0].pInfo;
 
     if (pInfo->clientApi == STC_API_D3D12) {
-        const size_t copyIndex = pBase->copyIndex;
+        const size_t copyIndex = pBase->streams[0].copyIndex;
         const HRESULT hr = ID3D11DeviceContext4_Wait(pServer->pContext11_4, pServer->pReadFences11On12[copyIndex],
-                                                     pInfo->readFenceValues12[copyIndex]);
+                                                     pInfo->streams[0].readFenceValues12[copyIndex]);
         if (SUCCEEDED(hr)) {
             ID3D11On12Device_AcquireWrappedResources(pServer->pDevice11On12, &(ID3D11Resource*)pServer->pTextures11On12[copyIndex],
                                                      1);
@@ -1493,7 +2783,7 @@ StcServerStatus StcServerD3D11WaitForClientRead(StcServerD3D11* const pServer) {
     }
 
     if (reason == STC_SERVER_STOP_REASON_NONE) {
-        const HRESULT hr = IDXGIKeyedMutex_AcquireSync(pServer->pKeyedMutexes[pBase->copyIndex], STC_KEY_SERVER, 0);
+        const HRESULT hr = IDXGIKeyedMutex_AcquireSync(pServer->pKeyedMutexes[pBase->streams[0].copyIndex], STC_KEY_SERVER, 0);
         if (FAILED(hr) || (hr == WAIT_ABANDONED) || (hr == WAIT_TIMEOUT)) {
             StcLogMessage(pMessenger, STC_MESSAGE_ID_SERVER_FAIL_D3D11_ACQUIRE_KEYED_MUTEX_TO_WRITE, hr);
             reason = STC_SERVER_STOP_REASON_FAIL_D3D11_ACQUIRE_KEYED_MUTEX_TO_WRITE;
@@ -1512,20 +2802,25 @@ StcServerStatus StcServerD3D12WaitForClientRead(StcServerD3D12* const pServer, I
 
     StcServerBase* const pBase = &pServer->base;
     const StcMessageCallbacks* const pMessenger = &pBase->messenger;
-    StcInfo* const pInfo = pBase->pInfo;
 
-    if (pInfo->clientApi == STC_API_D3D11) {
-        const HRESULT hr = IDXGIKeyedMutex_AcquireSync(pServer->pKeyedMutexes11[pBase->copyIndex], STC_KEY_SERVER, 0);
+    if (HasD3D11Reader(pServer)) {
+        const HRESULT hr = IDXGIKeyedMutex_AcquireSync(pServer->pKeyedMutexes11[pBase->streams[0].copyIndex], STC_KEY_SERVER, 0);
         if (FAILED(hr) || (hr == WAIT_ABANDONED) || (hr == WAIT_TIMEOUT)) {
             StcLogMessage(pMessenger, STC_MESSAGE_ID_SERVER_FAIL_D3D12_ACQUIRE_KEYED_MUTEX_TO_WRITE, hr);
             reason = STC_SERVER_STOP_REASON_FAIL_D3D12_ACQUIRE_KEYED_MUTEX_TO_WRITE;
         }
     } else {
-        const size_t copyIndex = pBase->copyIndex;
-        const HRESULT hr = ID3D12CommandQueue_Wait(pQueue, pServer->pReadFences[copyIndex], pInfo->readFenceValues12[copyIndex]);
-        if (FAILED(hr)) {
-            StcLogMessage(pMessenger, STC_MESSAGE_ID_SERVER_FAIL_D3D12_QUEUE_WAIT, hr);
-            reason = STC_SERVER_STOP_REASON_FAIL_D3D12_QUEUE_WAIT;
+        // A reader that never took this slot has nothing left to signal, so its wait is already satisfied
+        const size_t copyIndex = pBase->streams[0].copyIndex;
+        for (size_t i = 0; (reason == STC_SERVER_STOP_REASON_NONE) && (i < STC_MAX_CLIENT_COUNT); ++i) {
+            if (pServer->readerOpen[i]) {
+                const HRESULT hr = ID3D12CommandQueue_Wait(pQueue, pServer->pReadFences[i][copyIndex],
+                                                           pBase->connections[i].pInfo->streams[0].readFenceValues12[copyIndex]);
+                if (FAILED(hr)) {
+                    StcLogMessage(pMessenger, STC_MESSAGE_ID_SERVER_FAIL_D3D12_QUEUE_WAIT, hr);
+                    reason = STC_SERVER_STOP_REASON_FAIL_D3D12_QUEUE_WAIT;
+                }
+            }
         }
     }
 
@@ -1541,8 +2836,9 @@ StcServerStatus StcServerD3D11SignalWrite(StcServerD3D11* const pServer) {
 
     StcServerBase* const pBase = &pServer->base;
     const StcMessageCallbacks* const pMessenger = &pBase->messenger;
-    StcInfo* const pInfo = pBase->pInfo;
-    const size_t copyIndex = pBase->copyIndex;
+    StcInfo* const pInfo = pBase->connections[0].pInfo;
+    const size_t copyIndex = pBase->streams[0].copyIndex;
+    pBase->writingStreamMask = 0;
 
     HRESULT hr = IDXGIKeyedMutex_ReleaseSync(pServer->pKeyedMutexes[copyIndex], STC_KEY_CLIENT);
     if (FAILED(hr)) {
@@ -1553,10 +2849,10 @@ StcServerStatus StcServerD3D11SignalWrite(StcServerD3D11* const pServer) {
     if ((pInfo->clientApi == STC_API_D3D12) && (reason == STC_SERVER_STOP_REASON_NONE)) {
         ID3D11On12Device_ReleaseWrappedResources(pServer->pDevice11On12, &(ID3D11Resource*)pServer->pTextures11On12[copyIndex], 1);
 
-        const UINT64 nextFenceValue = pInfo->writeFenceValues12[copyIndex] + 1;
+        const UINT64 nextFenceValue = pInfo->streams[0].writeFenceValues12[copyIndex] + 1;
         hr = ID3D11DeviceContext4_Signal(pServer->pContext11_4, pServer->pWriteFences11On12[copyIndex], nextFenceValue);
         if (SUCCEEDED(hr)) {
-            pInfo->writeFenceValues12[copyIndex] = nextFenceValue;
+            pInfo->streams[0].writeFenceValues12[copyIndex] = nextFenceValue;
         } else {
             StcLogMessage(pMessenger, STC_MESSAGE_ID_SERVER_FAIL_D3D11_QUEUE_SIGNAL, hr);
             reason = STC_SERVER_STOP_REASON_FAIL_D3D11_QUEUE_SIGNAL;
@@ -1564,7 +2860,7 @@ StcServerStatus StcServerD3D11SignalWrite(StcServerD3D11* const pServer) {
     }
 
     if (reason == STC_SERVER_STOP_REASON_NONE) {
-        StcAtomicUint32Increment(&pInfo->pendingReads);
+        PublishSlot(pBase, 0, false);
     } else {
         ReopenServerD3D11(pServer, reason, pBase->pGlobalInfo);
     }
@@ -1577,10 +2873,10 @@ StcServerStatus StcServerD3D12SignalWrite(StcServerD3D12* const pServer, ID3D12C
 
     StcServerBase* const pBase = &pServer->base;
     const StcMessageCallbacks* const pMessenger = &pBase->messenger;
-    StcInfo* const pInfo = pBase->pInfo;
-    const size_t copyIndex = pBase->copyIndex;
+    const size_t copyIndex = pBase->streams[0].copyIndex;
+    pBase->writingStreamMask = 0;
 
-    if (pInfo->clientApi == STC_API_D3D11) {
+    if (HasD3D11Reader(pServer)) {
         ID3D11On12Device_AcquireWrappedResources(pServer->pDevice11On12, &(ID3D11Resource*)pServer->pTextures11[copyIndex], 1);
 
         HRESULT hr = IDXGIKeyedMutex_ReleaseSync(pServer->pKeyedMutexes11[copyIndex], STC_KEY_CLIENT);
@@ -1590,20 +2886,444 @@ StcServerStatus StcServerD3D12SignalWrite(StcServerD3D12* const pServer, ID3D12C
         }
     }
 
-    const UINT64 nextFenceValue = pInfo->writeFenceValues12[copyIndex] + 1;
+    const UINT64 nextFenceValue = pServer->writeFenceValues[copyIndex] + 1;
     HRESULT hr = ID3D12CommandQueue_Signal(pQueue, pServer->pWriteFences[copyIndex], nextFenceValue);
     if (SUCCEEDED(hr)) {
-        pInfo->writeFenceValues12[copyIndex] = nextFenceValue;
+        pServer->writeFenceValues[copyIndex] = nextFenceValue;
+        for (size_t i = 0; i < STC_MAX_CLIENT_COUNT; ++i) {
+            if (pServer->readerOpen[i]) {
+                pBase->connections[i].pInfo->streams[0].writeFenceValues12[copyIndex] = nextFenceValue;
+            }
+        }
     } else {
         StcLogMessage(pMessenger, STC_MESSAGE_ID_SERVER_FAIL_D3D12_QUEUE_SIGNAL, hr);
         reason = STC_SERVER_STOP_REASON_FAIL_D3D12_QUEUE_SIGNAL;
     }
 
     if (reason == STC_SERVER_STOP_REASON_NONE) {
-        StcAtomicUint32Increment(&pInfo->pendingReads);
+        PublishSlot(pBase, 0, false);
     } else {
         ReopenServerD3D12(pServer, reason, pBase->pGlobalInfo);
     }
 
     return (reason == STC_SERVER_STOP_REASON_NONE) ? STC_SERVER_STATUS_SUCCESS : STC_SERVER_STATUS_FAIL_SIGNAL_WRITE;
 }
+
+// Takes effect from the next Tick, like StcServerCpuSetSliceCountStream
+void StcServerD3D12SetSliceCount(StcServerD3D12* const pServer, const uint32_t sliceCount) {
+    pServer->base.streams[0].sliceCount = (sliceCount > 0) ? sliceCount : 1;
+}
+
+// Each slice signals the write fence with a value of its own, so a client's queue can wait for just the rows it reads. Slice
+// readers get the frame at the first slice, so that is when they learn the value the whole frame finishes at. The last
+// slice is left to SignalWrite, which signals that value.
+StcServerStatus StcServerD3D12SignalSlice(StcServerD3D12* const pServer, ID3D12CommandQueue* const pQueue) {
+    StcServerBase* const pBase = &pServer->base;
+    StcServerStatus status = (pBase->writingStreamMask != 0) ? STC_SERVER_STATUS_SUCCESS : STC_SERVER_STATUS_FAIL_NOT_WRITING;
+
+    const StcServerStream* const pStream = &pBase->streams[0];
+    if ((status == STC_SERVER_STATUS_SUCCESS) && ((pStream->completedSlices + 1) < pStream->frameSliceCount)) {
+        const size_t copyIndex = pStream->copyIndex;
+        const UINT64 nextFenceValue = pServer->writeFenceValues[copyIndex] + 1;
+        const HRESULT hr = ID3D12CommandQueue_Signal(pQueue, pServer->pWriteFences[copyIndex], nextFenceValue);
+        if (SUCCEEDED(hr)) {
+            pServer->writeFenceValues[copyIndex] = nextFenceValue;
+            if (pStream->completedSlices == 0) {
+                const UINT64 frameFenceValue = nextFenceValue + pStream->frameSliceCount - 1;
+                for (size_t i = 0; i < STC_MAX_CLIENT_COUNT; ++i) {
+                    if (pServer->readerOpen[i]) {
+                        pBase->connections[i].pInfo->streams[0].writeFenceValues12[copyIndex] = frameFenceValue;
+                    }
+                }
+            }
+
+            CompleteSlice(pBase, 0);
+        } else {
+            StcLogMessage(&pBase->messenger, STC_MESSAGE_ID_SERVER_FAIL_D3D12_QUEUE_SIGNAL, hr);
+            ReopenServerD3D12(pServer, STC_SERVER_STOP_REASON_FAIL_D3D12_QUEUE_SIGNAL, pBase->pGlobalInfo);
+            status = STC_SERVER_STATUS_FAIL_SIGNAL_WRITE;
+        }
+    }
+
+    return status;
+}
+
+StcServerStatus StcServerD3D11WriteAuxRecord(StcServerD3D11* const pServer, const uint32_t type, const void* const pData,
+                                             const size_t size) {
+    return WriteAuxRecord(&pServer->base, 0, type, pData, size);
+}
+
+StcServerStatus StcServerD3D12WriteAuxRecord(StcServerD3D12* const pServer, const uint32_t type, const void* const pData,
+                                             const size_t size) {
+    return WriteAuxRecord(&pServer->base, 0, type, pData, size);
+}
+
+StcServerStatus StcServerD3D11WriteFrameMetadata(StcServerD3D11* const pServer, const void* const pData, const size_t size) {
+    return WriteFrameMetadata(&pServer->base, 0, pData, size);
+}
+
+StcServerStatus StcServerD3D12WriteFrameMetadata(StcServerD3D12* const pServer, const void* const pData, const size_t size) {
+    return WriteFrameMetadata(&pServer->base, 0, pData, size);
+}
+
+StcServerStatus StcServerD3D11Wait(StcServerD3D11* const pServer, const uint32_t timeoutMs) {
+    return StcServerWait(&pServer->base, timeoutMs);
+}
+
+StcServerStatus StcServerD3D12Wait(StcServerD3D12* const pServer, const uint32_t timeoutMs) {
+    return StcServerWait(&pServer->base, timeoutMs);
+}
+
+HANDLE StcServerD3D11GetWaitHandle(StcServerD3D11* const pServer) { return pServer->base.serverWake.hEvent; }
+
+HANDLE StcServerD3D12GetWaitHandle(StcServerD3D12* const pServer) { return pServer->base.serverWake.hEvent; }
+
+void StcServerD3D11SetControlCallbacks(StcServerD3D11* const pServer, const StcControlCallbacks* const pController) {
+    SetControlCallbacks(&pServer->base, pController);
+}
+
+void StcServerD3D12SetControlCallbacks(StcServerD3D12* const pServer, const StcControlCallbacks* const pController) {
+    SetControlCallbacks(&pServer->base, pController);
+}
+
+void StcServerD3D11SetResizeDelay(StcServerD3D11* const pServer, const uint32_t delayMicroseconds) {
+    SetResizeDelay(&pServer->base, delayMicroseconds);
+}
+
+void StcServerD3D12SetResizeDelay(StcServerD3D12* const pServer, const uint32_t delayMicroseconds) {
+    SetResizeDelay(&pServer->base, delayMicroseconds);
+}
+#endif
+
+// Tells a client that joined after the frames were created where to find them. Pending frames never reached it, so on
+// platforms that pass descriptors they are dropped and created again when their slot comes around.
+static StcServerStopReason AnnounceCpuResourceFrames(StcServerCpu* const pServer, StcServerConnection* const pConnection) {
+    StcServerStopReason reason = STC_SERVER_STOP_REASON_NONE;
+
+    StcServerBase* const pBase = &pServer->base;
+    StcInfo* const pInfo = pConnection->pInfo;
+    const size_t connectionIndex = (size_t)(pConnection - pBase->connections);
+
+    // One batch per stream, so the client can file the frames the same way as a batch sent on resize
+    for (size_t stream = 0; (reason == STC_SERVER_STOP_REASON_NONE) && (stream < pBase->streamCount); ++stream) {
+        if (GetClientStreamInfo(pBase, stream, connectionIndex) != NULL) {
+            const StcServerCpuStream* const pCpuStream = &pServer->streams[stream];
+#ifdef STC_TRANSPORT_PASSES_DESCRIPTORS
+            DiscardPendingCpuFrames(pServer, stream);
+
+            StcCpuFrameBatch batch;
+            batch.stream = (uint32_t)stream;
+            int fds[STC_MAX_TEXTURE_COUNT];
+            size_t fdCount = 0;
+#endif
+            for (size_t i = 0; i < STC_MAX_TEXTURE_COUNT; ++i) {
+#ifdef STC_TRANSPORT_PASSES_DESCRIPTORS
+                batch.generations[i] = 0;
+#endif
+                if (pCpuStream->pFrameHeaders[i] != NULL) {
+                    pInfo->streams[stream].hTextures[i] = pCpuStream->frameGenerations[i];
+                    pInfo->streams[stream].invalidated[i] = true;
+#ifdef STC_TRANSPORT_PASSES_DESCRIPTORS
+                    batch.generations[i] = pCpuStream->frameGenerations[i];
+                    fds[fdCount++] = pCpuStream->frameMappings[i].fd;
+#endif
+                }
+            }
+
+#ifdef STC_TRANSPORT_PASSES_DESCRIPTORS
+            int error;
+            if (!StcChannelSend(&pConnection->channel, &batch, sizeof(batch), fds, fdCount, &error)) {
+                StcLogMessage(&pBase->messenger, STC_MESSAGE_ID_SERVER_FAIL_CPU_SEND_BUFFERS, error);
+                if (pBase->clientCount > 1) {
+                    CloseConnection(pBase, pConnection, STC_SERVER_STOP_REASON_FAIL_SEND_CPU_BUFFERS);
+                } else {
+                    reason = STC_SERVER_STOP_REASON_FAIL_SEND_CPU_BUFFERS;
+                }
+            }
+#endif
+        }
+    }
+
+    pConnection->announceFrames = false;
+
+    return reason;
+}
+
+static StcServerStatus StcServerCpuConnectionTick(StcServerCpu* const pServer) {
+    StcServerBase* const pBase = &pServer->base;
+    StcServerStopReason reason = STC_SERVER_STOP_REASON_NONE;
+    StcServerStatus status = TickServer(pBase, &reason);
+    for (size_t i = 0; (reason == STC_SERVER_STOP_REASON_NONE) && (i < STC_MAX_CLIENT_COUNT); ++i) {
+        if (pBase->connections[i].announceFrames) {
+            reason = AnnounceCpuResourceFrames(pServer, &pBase->connections[i]);
+        }
+    }
+
+    if (reason != STC_SERVER_STOP_REASON_NONE) {
+        status = ReopenServerCpu(pServer, reason, pBase->pGlobalInfo);
+        if (status == STC_SERVER_STATUS_SUCCESS) {
+            status = STC_SERVER_STATUS_FAIL_DISCONNECTED;
+        }
+    }
+
+    return status;
+}
+
+// Connections are only ticked while no other stream is between Tick and SignalWrite, since losing the last client closes
+// every stream's frames. Ticking the streams of a frame set back to back still ticks connections once per set.
+StcServerStatus StcServerCpuTickStream(StcServerCpu* const pServer, const size_t stream, StcServerCpuNextInfo* const pNextInfo) {
+    StcServerStatus status = STC_SERVER_STATUS_FAIL_INVALID_STREAM;
+    if (stream < pServer->base.streamCount) {
+        pServer->base.writingStreamMask &= ~(1u << stream);
+        status = (pServer->base.writingStreamMask == 0) ? StcServerCpuConnectionTick(pServer) : STC_SERVER_STATUS_SUCCESS;
+    }
+
+    if (status == STC_SERVER_STATUS_SUCCESS) {
+        status = STC_SERVER_STATUS_FAIL_NO_FRAMES_AVAIALBLE;
+
+        StcServerBase* const pBase = &pServer->base;
+        const StcMessageCallbacks* const pMessenger = &pBase->messenger;
+        StcServerStream* const pStream = &pBase->streams[stream];
+        StcServerCpuStream* const pCpuStream = &pServer->streams[stream];
+        if (ApplyResize(pBase, stream)) {
+            DiscardPendingCpuFrames(pServer, stream);
+        }
+
+        size_t copyIndex;
+        if (!IsFrameWanted(pBase, stream)) {
+            status = STC_SERVER_STATUS_FAIL_FRAME_NOT_WANTED;
+        } else if (AcquireWriteSlot(pBase, stream, &copyIndex)) {
+            StcServerStopReason reason = STC_SERVER_STOP_REASON_NONE;
+
+            StcCpuFrameHeader* const pHeader = pCpuStream->pFrameHeaders[copyIndex];
+            if (pHeader != NULL) {
+                uint32_t key;
+                if (StcCpuKeyAcquire(&pHeader->key, STC_KEY_CLIENT, &key)) {
+                    if (!StcCpuKeyRelease(&pHeader->key, STC_KEY_SERVER, &key)) {
+                        StcLogMessage(pMessenger, STC_MESSAGE_ID_SERVER_FAIL_CPU_RELEASE_KEYED_MUTEX_TO_OWN, key);
+                        reason = STC_SERVER_STOP_REASON_FAIL_CPU_RELEASE_KEYED_MUTEX_TO_OWN;
+                    }
+                } else {
+                    StcLogMessage(pMessenger, STC_MESSAGE_ID_SERVER_FAIL_CPU_ACQUIRE_KEYED_MUTEX_TO_OWN, key);
+                    reason = STC_SERVER_STOP_REASON_FAIL_CPU_ACQUIRE_KEYED_MUTEX_TO_OWN;
+                }
+            }
+
+            if (reason == STC_SERVER_STOP_REASON_NONE) {
+                pStream->copyIndex = copyIndex;
+
+                if (pStream->needResize[copyIndex]) {
+                    StcLogMessage(pMessenger, STC_MESSAGE_ID_SERVER_CPU_CREATE_FRAME_ATTEMPT, (int)copyIndex);
+
+                    if (pCpuStream->pPendingHeaders[copyIndex] == NULL) {
+                        reason = CreateCpuResourceFrames(pServer, stream);
+                    }
+
+                    if (reason == STC_SERVER_STOP_REASON_NONE) {
+                        ResourceFrameCpu frame;
+                        frame.mapping = pCpuStream->pendingMappings[copyIndex];
+                        frame.pHeader = pCpuStream->pPendingHeaders[copyIndex];
+                        frame.generation = pCpuStream->pendingGenerations[copyIndex];
+                        pCpuStream->pPendingHeaders[copyIndex] = NULL;
+
+                        if (pHeader != NULL) {
+                            pServer->allocator.pfnDestroy(pServer->allocator.pUserData, stream * STC_MAX_TEXTURE_COUNT + copyIndex);
+
+                            StcMappingClose(&pCpuStream->frameMappings[copyIndex]);
+                        }
+
+                        pCpuStream->frameMappings[copyIndex] = frame.mapping;
+                        pCpuStream->pFrameHeaders[copyIndex] = frame.pHeader;
+                        pCpuStream->frameGenerations[copyIndex] = frame.generation;
+                        pStream->needResize[copyIndex] = false;
+
+                        for (size_t i = 0; i < STC_MAX_CLIENT_COUNT; ++i) {
+                            StcStreamInfo* const pInfo = GetClientStreamInfo(pBase, stream, i);
+                            if (pInfo != NULL) {
+                                pInfo->hTextures[copyIndex] = frame.generation;
+                                pInfo->hWriteFences12[copyIndex] = 0;
+                                pInfo->hReadFences12[copyIndex] = 0;
+                                pInfo->writeFenceValues12[copyIndex] = 0;
+                                pInfo->readFenceValues12[copyIndex] = 0;
+                                pInfo->invalidated[copyIndex] = true;
+                            }
+                        }
+
+                        if (pServer->allocator.pfnCreate(pServer->allocator.pUserData, stream * STC_MAX_TEXTURE_COUNT + copyIndex,
+                                                         (char*)frame.pHeader + STC_CPU_DATA_OFFSET, frame.pHeader->rowPitch)) {
+                            StcLogMessage(pMessenger, STC_MESSAGE_ID_SERVER_CPU_CREATE_FRAME_SUCCESS, (int)copyIndex);
+                        } else {
+                            StcLogMessage(pMessenger, STC_MESSAGE_ID_SERVER_FAIL_CPU_USER_CREATE_FRAME_CALLBACK, (int)copyIndex);
+                            reason = STC_SERVER_STOP_REASON_FAIL_CPU_USER_CREATE_FRAME_CALLBACK;
+                        }
+                    }
+                }
+            }
+
+            if (reason == STC_SERVER_STOP_REASON_NONE) {
+                // Rounding the slice height up can leave trailing slices empty, so those are dropped from the count
+                StcCpuFrameHeader* const pCurrentHeader = pCpuStream->pFrameHeaders[copyIndex];
+                const UINT height = pCurrentHeader->height;
+                const UINT sliceHeight = StcComputeSliceHeight(height, pStream->sliceCount);
+                pStream->frameSliceCount = (sliceHeight > 0) ? ((height + sliceHeight - 1) / sliceHeight) : 1;
+                pStream->completedSlices = 0;
+
+                pNextInfo->pData = (char*)pCurrentHeader + STC_CPU_DATA_OFFSET;
+                pNextInfo->rowPitch = pCurrentHeader->rowPitch;
+                pNextInfo->width = pCurrentHeader->width;
+                pNextInfo->height = pCurrentHeader->height;
+                pNextInfo->format = pCurrentHeader->format;
+                pNextInfo->index = copyIndex;
+                pNextInfo->sliceCount = pStream->frameSliceCount;
+                pNextInfo->sliceHeight = sliceHeight;
+                pServer->base.writingStreamMask |= 1u << stream;
+                status = STC_SERVER_STATUS_SUCCESS;
+            } else {
+                ReopenServerCpu(pServer, reason, pBase->pGlobalInfo);
+                status = STC_SERVER_STATUS_FAIL_TICK;
+            }
+        }
+    }
+
+    return status;
+}
+
+StcServerStatus StcServerCpuTick(StcServerCpu* const pServer, StcServerCpuNextInfo* const pNextInfo) {
+    return StcServerCpuTickStream(pServer, 0, pNextInfo);
+}
+
+// Another stream's Tick or a failed call may reset the server after this stream ticked, which closes its frame. The
+// stream then reports the disconnect instead of touching the closed frame.
+static StcServerStatus GetCpuStreamWriteStatus(const StcServerCpu* const pServer, const size_t stream) {
+    StcServerStatus status = STC_SERVER_STATUS_FAIL_INVALID_STREAM;
+    if (stream < pServer->base.streamCount) {
+        const StcCpuFrameHeader* const pHeader = pServer->streams[stream].pFrameHeaders[pServer->base.streams[stream].copyIndex];
+        status = (((pServer->base.writingStreamMask & (1u << stream)) != 0) && (pHeader != NULL)) ? STC_SERVER_STATUS_SUCCESS
+                                                                                              : STC_SERVER_STATUS_FAIL_DISCONNECTED;
+    }
+
+    return status;
+}
+
+StcServerStatus StcServerCpuWaitForClientReadStream(StcServerCpu* const pServer, const size_t stream) {
+    StcServerStatus status = GetCpuStreamWriteStatus(pServer, stream);
+    if (status == STC_SERVER_STATUS_SUCCESS) {
+        StcServerBase* const pBase = &pServer->base;
+        const StcMessageCallbacks* const pMessenger = &pBase->messenger;
+
+        uint32_t key;
+        if (!StcCpuKeyAcquire(&pServer->streams[stream].pFrameHeaders[pBase->streams[stream].copyIndex]->key, STC_KEY_SERVER,
+                              &key)) {
+            StcLogMessage(pMessenger, STC_MESSAGE_ID_SERVER_FAIL_CPU_ACQUIRE_KEYED_MUTEX_TO_WRITE, key);
+            ReopenServerCpu(pServer, STC_SERVER_STOP_REASON_FAIL_CPU_ACQUIRE_KEYED_MUTEX_TO_WRITE, pBase->pGlobalInfo);
+            status = STC_SERVER_STATUS_FAIL_WAIT_CLIENT_READ;
+        }
+    }
+
+    return status;
+}
+
+StcServerStatus StcServerCpuWaitForClientRead(StcServerCpu* const pServer) {
+    return StcServerCpuWaitForClientReadStream(pServer, 0);
+}
+
+StcServerStatus StcServerCpuSignalWriteStream(StcServerCpu* const pServer, const size_t stream) {
+    StcServerStatus status = GetCpuStreamWriteStatus(pServer, stream);
+    if (status == STC_SERVER_STATUS_SUCCESS) {
+        StcServerBase* const pBase = &pServer->base;
+        const StcMessageCallbacks* const pMessenger = &pBase->messenger;
+        const size_t copyIndex = pBase->streams[stream].copyIndex;
+
+        // Writes are complete once the caller returns, so the fence value is published by the key release below.
+        for (size_t i = 0; i < STC_MAX_CLIENT_COUNT; ++i) {
+            StcStreamInfo* const pInfo = GetClientStreamInfo(pBase, stream, i);
+            if (pInfo != NULL) {
+                ++pInfo->writeFenceValues12[copyIndex];
+            }
+        }
+
+        pServer->base.writingStreamMask &= ~(1u << stream);
+
+        uint32_t key;
+        if (StcCpuKeyRelease(&pServer->streams[stream].pFrameHeaders[copyIndex]->key, STC_KEY_CLIENT, &key)) {
+            PublishSlot(pBase, stream, false);
+        } else {
+            StcLogMessage(pMessenger, STC_MESSAGE_ID_SERVER_FAIL_CPU_RELEASE_KEYED_MUTEX_TO_WRITE, key);
+            ReopenServerCpu(pServer, STC_SERVER_STOP_REASON_FAIL_CPU_RELEASE_KEYED_MUTEX_TO_WRITE, pBase->pGlobalInfo);
+            status = STC_SERVER_STATUS_FAIL_SIGNAL_WRITE;
+        }
+    }
+
+    return status;
+}
+
+StcServerStatus StcServerCpuSignalWrite(StcServerCpu* const pServer) {
+    return StcServerCpuSignalWriteStream(pServer, 0);
+}
+
+// Takes effect from the next Tick, which may use fewer slices than requested so that none is empty
+void StcServerCpuSetSliceCountStream(StcServerCpu* const pServer, const size_t stream, const uint32_t sliceCount) {
+    if (stream < pServer->base.streamCount) {
+        pServer->base.streams[stream].sliceCount = (sliceCount > 0) ? sliceCount : 1;
+    }
+}
+
+void StcServerCpuSetSliceCount(StcServerCpu* const pServer, const uint32_t sliceCount) {
+    StcServerCpuSetSliceCountStream(pServer, 0, sliceCount);
+}
+
+// Marks the next slice of the frame being written as finished. The last slice is left to SignalWrite, since a client
+// that saw every slice done would go on to WaitForServerWrite before the key is handed over.
+StcServerStatus StcServerCpuSignalSliceStream(StcServerCpu* const pServer, const size_t stream) {
+    const StcServerStatus status = GetCpuStreamWriteStatus(pServer, stream);
+    if (status == STC_SERVER_STATUS_SUCCESS) {
+        StcServerBase* const pBase = &pServer->base;
+        const StcServerStream* const pStream = &pBase->streams[stream];
+        if ((pStream->completedSlices + 1) < pStream->frameSliceCount) {
+            CompleteSlice(pBase, stream);
+        }
+    }
+
+    return status;
+}
+
+StcServerStatus StcServerCpuSignalSlice(StcServerCpu* const pServer) { return StcServerCpuSignalSliceStream(pServer, 0); }
+
+StcServerStatus StcServerCpuWriteFrameMetadataStream(StcServerCpu* const pServer, const size_t stream, const void* const pData,
+                                                     const size_t size) {
+    return WriteFrameMetadata(&pServer->base, stream, pData, size);
+}
+
+StcServerStatus StcServerCpuWriteFrameMetadata(StcServerCpu* const pServer, const void* const pData, const size_t size) {
+    return WriteFrameMetadata(&pServer->base, 0, pData, size);
+}
+
+StcServerStatus StcServerCpuWriteAuxRecordStream(StcServerCpu* const pServer, const size_t stream, const uint32_t type,
+                                                 const void* const pData, const size_t size) {
+    return WriteAuxRecord(&pServer->base, stream, type, pData, size);
+}
+
+StcServerStatus StcServerCpuWriteAuxRecord(StcServerCpu* const pServer, const uint32_t type, const void* const pData,
+                                           const size_t size) {
+    return WriteAuxRecord(&pServer->base, 0, type, pData, size);
+}
+
+StcServerStatus StcServerCpuWait(StcServerCpu* const pServer, const uint32_t timeoutMs) {
+    return StcServerWait(&pServer->base, timeoutMs);
+}
+
+void StcServerCpuSetControlCallbacks(StcServerCpu* const pServer, const StcControlCallbacks* const pController) {
+    SetControlCallbacks(&pServer->base, pController);
+}
+
+void StcServerCpuSetResizeDelay(StcServerCpu* const pServer, const uint32_t delayMicroseconds) {
+    SetResizeDelay(&pServer->base, delayMicroseconds);
+}
+
+#ifdef _WIN32
+HANDLE StcServerCpuGetWaitHandle(StcServerCpu* const pServer) { return pServer->base.serverWake.hEvent; }
+#endif
+
+#ifdef STC_TRANSPORT_PASSES_DESCRIPTORS
+int StcServerCpuGetWaitFd(StcServerCpu* const pServer) { return StcEventGetDescriptor(&pServer->base.serverWake); }
+#endif
@@ -26,8 +26,11 @@
 #pragma once
 
 #include "StcCommon.h"
+#include "StcTransport.h"
 
+#ifdef _WIN32
 #include "Stc_d3d12compatibility.h"
+#endif
 
 #ifdef __cplusplus
 extern "C" {
@@ -36,20 +39,25 @@ extern "C" {
 #pragma warning(push)
 #pragma warning(disable : 4820)
 
-typedef enum StcFormat {
-    STC_FORMAT_R16G16B16A16_FLOAT,
-    STC_FORMAT_R10G10B10A2_UNORM,
-    STC_FORMAT_R8G8B8A8_SRGB,
-    STC_FORMAT_B8G8R8A8_SRGB,
-    STC_FORMAT_R10G10B10_XR_BIAS_A2_UNORM,
-} StcFormat;
-
 typedef struct StcServerGraphicsInfo {
     UINT width;
     UINT height;
     StcFormat format;
 } StcServerGraphicsInfo;
 
+// A resize only applies once Tick moves the whole ring over, so the frame is written at the size given here
+typedef struct StcServerCpuNextInfo {
+    void* pData;
+    size_t rowPitch;
+    UINT width;
+    UINT height;
+    StcFormat format;
+    size_t index;
+    uint32_t sliceCount;
+    UINT sliceHeight;
+} StcServerCpuNextInfo;
+
+#ifdef _WIN32
 typedef struct StcServerD3D11NextInfo {
     ID3D11Texture2D* pTexture;
     size_t index;
@@ -58,29 +66,124 @@ typedef struct StcServerD3D11NextInfo {
 typedef struct StcServerD3D12NextInfo {
     ID3D12Resource* pTexture;
     size_t index;
+    uint32_t sliceCount;
+    UINT sliceHeight;
 } StcServerD3D12NextInfo;
+#endif
+
+// One ring of frames. The ring depth is shared by every stream, everything else is per stream.
+typedef struct StcServerStream {
+    // AddStream initialized
+    StcServerGraphicsInfo graphicsInfo;
+    uint32_t sliceCount;
+    uint32_t resizeGeneration;
+    bool resizePending;
+
+    // ResizeBuffers initialized, the size Tick moves the ring to once it settles
+    StcServerGraphicsInfo resizeInfo;
+    int64_t resizeFirstTicks;
+    int64_t resizeLastTicks;
+
+    // MakeConnection initialized
+    size_t copyIndex;
+    uint64_t frameSequence;
+    bool needResize[STC_MAX_TEXTURE_COUNT];
+
+    // Tick initialized, so a slice count changed mid-frame waits for the next one
+    uint32_t frameSliceCount;
+    uint32_t completedSlices;
+} StcServerStream;
+
+// One client's view of the ring. Frames are shared by every connection, only the handshake, the StcInfo mapping and the
+// wake event are per client.
+typedef struct StcServerConnection {
+    // Tick initialized
+    bool clientInProgress;
+    int64_t clientFirstSeen;
+    bool connected;
+    bool announceFrames;
+
+    // MakeConnection initialized
+    TCHAR pConnectionNameBuffer[256];
+    StcMapping mapping;
+#ifdef STC_TRANSPORT_PASSES_DESCRIPTORS
+    StcChannel listener;
+    StcChannel channel;
+#endif
+    StcInfo* pInfo;
+    StcEvent clientWake;
+    StcSwapMode swapMode;
+    uint32_t streamMask;
+    int64_t nextWantedTicks[STC_MAX_STREAM_COUNT];
+    uint32_t parameterGeneration;
+    StcCapabilityFlags capabilities;
+    bool paused;
+    uint32_t requestedStreamMask;
+    uint32_t auxDropped;
+} StcServerConnection;
 
 typedef struct StcServerBase {
     // Create initialized
     StcMessageCallbacks messenger;
+    StcControlCallbacks controller;
     TCHAR pNameBuffer[256];
     uint64_t nextConnectToken;
-    bool clientInProgress;
-    StcServerGraphicsInfo graphicsInfo;
-    HANDLE hGlobalMapFile;
+    size_t maxClientCount;
+    StcMapping globalMapping;
     StcGlobalInfo* pGlobalInfo;
+    StcEvent serverWake;
+    StcServerConnection connections[STC_MAX_CLIENT_COUNT];
+    size_t streamCount;
+    StcServerStream streams[STC_MAX_STREAM_COUNT];
+    size_t metadataCapacity;
+    int64_t tickFrequency;
+    int64_t resizeDelayTicks;
     bool initialized;
 
     // Tick initialized
-    int64_t clientFirstSeen;
+    uint32_t wakeToken;
+    // One bit per stream between a successful Tick and its SignalWrite
+    uint32_t writingStreamMask;
 
     // MakeConnection initialized
-    HANDLE hMapFile;
-    StcInfo* pInfo;
-    size_t copyIndex;
-    bool needResize[STC_TEXTURE_COUNT];
+    size_t clientCount;
+    size_t textureCount;
 } StcServerBase;
 
+typedef struct StcServerCpuStream {
+    // Tick initialized
+    StcMapping frameMappings[STC_MAX_TEXTURE_COUNT];
+    StcCpuFrameHeader* pFrameHeaders[STC_MAX_TEXTURE_COUNT];
+    uint32_t frameGenerations[STC_MAX_TEXTURE_COUNT];
+    StcMapping pendingMappings[STC_MAX_TEXTURE_COUNT];
+    StcCpuFrameHeader* pPendingHeaders[STC_MAX_TEXTURE_COUNT];
+    uint32_t pendingGenerations[STC_MAX_TEXTURE_COUNT];
+} StcServerCpuStream;
+
+typedef struct StcServerCpu {
+    StcServerBase base;
+
+    // Create initialized
+    StcCpuAllocationCallbacks allocator;
+    uint32_t nextGeneration;
+
+    StcServerCpuStream streams[STC_MAX_STREAM_COUNT];
+} StcServerCpu;
+
+#ifdef _WIN32
+// A slot's resources built ahead of the Tick that switches it to the new size
+typedef struct StcServerD3D11Frame {
+    ID3D11Texture2D* pTexture;
+    IDXGIKeyedMutex* pKeyedMutex;
+    HANDLE hTexture;
+
+    ID3D11Texture2D* pTexture11On12;
+    ID3D11Fence* pWriteFence11On12;
+    ID3D11Fence* pReadFence11On12;
+    HANDLE hWriteFence11On12;
+    HANDLE hReadFence11On12;
+} StcServerD3D11Frame;
+
 typedef struct StcServerD3D11 {
     StcServerBase base;
 
@@ -98,13 +201,25 @@ typedef struct StcServerD3D11 {
     ID3D12CompatibilityDevice* pCompatibilityDevice;
 
     // Tick initialized
-    ID3D11Texture2D* pTextures[STC_TEXTURE_COUNT];
-    IDXGIKeyedMutex* pKeyedMutexes[STC_TEXTURE_COUNT];
-    ID3D11Texture2D* pTextures11On12[STC_TEXTURE_COUNT];
-    ID3D11Fence* pWriteFences11On12[STC_TEXTURE_COUNT];
-    ID3D11Fence* pReadFences11On12[STC_TEXTURE_COUNT];
+    ID3D11Texture2D* pTextures[STC_MAX_TEXTURE_COUNT];
+    IDXGIKeyedMutex* pKeyedMutexes[STC_MAX_TEXTURE_COUNT];
+    ID3D11Texture2D* pTextures11On12[STC_MAX_TEXTURE_COUNT];
+    ID3D11Fence* pWriteFences11On12[STC_MAX_TEXTURE_COUNT];
+    ID3D11Fence* pReadFences11On12[STC_MAX_TEXTURE_COUNT];
+    StcServerD3D11Frame pendingFrames[STC_MAX_TEXTURE_COUNT];
 } StcServerD3D11;
 
+// Read fences belong to the readers rather than the frame, so only the texture and write fence are rebuilt on resize
+typedef struct StcServerD3D12Frame {
+    ID3D12Resource* pTexture;
+    ID3D12Fence* pWriteFence;
+    HANDLE hTexture;
+    HANDLE hWriteFence;
+
+    ID3D11Texture2D* pTexture11;
+    IDXGIKeyedMutex* pKeyedMutex11;
+} StcServerD3D12Frame;
+
 typedef struct StcServerD3D12 {
     StcServerBase base;
 
@@ -118,21 +233,74 @@ typedef struct StcServerD3D12 {
     ID3D12CompatibilityDevice* pCompatibilityDevice;
     StcD3D12AllocationCallbacks allocator;
 
-    // Tick initialized
-    ID3D12Resource* pTextures[STC_TEXTURE_COUNT];
-    ID3D12Fence* pWriteFences[STC_TEXTURE_COUNT];
-    ID3D12Fence* pReadFences[STC_TEXTURE_COUNT];
-    ID3D11Texture2D* pTextures11[STC_TEXTURE_COUNT];
-    IDXGIKeyedMutex* pKeyedMutexes11[STC_TEXTURE_COUNT];
+    // Tick initialized, shared by every reader
+    ID3D12Resource* pTextures[STC_MAX_TEXTURE_COUNT];
+    ID3D12Fence* pWriteFences[STC_MAX_TEXTURE_COUNT];
+    HANDLE hTextures[STC_MAX_TEXTURE_COUNT];
+    HANDLE hWriteFences[STC_MAX_TEXTURE_COUNT];
+    uint64_t writeFenceValues[STC_MAX_TEXTURE_COUNT];
+    ID3D11Texture2D* pTextures11[STC_MAX_TEXTURE_COUNT];
+    IDXGIKeyedMutex* pKeyedMutexes11[STC_MAX_TEXTURE_COUNT];
+    StcServerD3D12Frame pendingFrames[STC_MAX_TEXTURE_COUNT];
+
+    // Tick initialized, one read fence per slot for each D3D12 reader so a write waits for all of them
+    bool readerOpen[STC_MAX_CLIENT_COUNT];
+    ID3D12Fence* pReadFences[STC_MAX_CLIENT_COUNT][STC_MAX_TEXTURE_COUNT];
+    HANDLE hReadFences[STC_MAX_CLIENT_COUNT][STC_MAX_TEXTURE_COUNT];
 } StcServerD3D12;
+#endif
 
 #pragma warning(pop)
 
+StcServerStatus StcServerCpuCreate(StcServerCpu* pServer, const TCHAR* pPrefix, const StcServerGraphicsInfo* pGraphicsInfo,
+                                   size_t metadataCapacity, const StcCpuAllocationCallbacks* pAllocator,
+                                   const StcMessageCallbacks* pMessenger);
+void StcServerCpuDestroy(StcServerCpu* pServer);
+// Named streams are a CPU backend feature. The D3D servers keep a single texture ring and always publish stream 0 only.
+// Stream indices past the streams added so far fail with STC_SERVER_STATUS_FAIL_INVALID_STREAM.
+StcServerStatus StcServerCpuAddStream(StcServerCpu* pServer, const char* pName, const StcServerGraphicsInfo* pGraphicsInfo,
+                                      size_t* pStreamIndex);
+void StcServerCpuResizeBuffers(StcServerCpu* pServer, UINT width, UINT height, StcFormat format);
+void StcServerCpuResizeStreamBuffers(StcServerCpu* pServer, size_t stream, UINT width, UINT height, StcFormat format);
+StcServerStatus StcServerCpuTick(StcServerCpu* pServer, StcServerCpuNextInfo* pNextInfo);
+StcServerStatus StcServerCpuTickStream(StcServerCpu* pServer, size_t stream, StcServerCpuNextInfo* pNextInfo);
+StcServerStatus StcServerCpuWaitForClientRead(StcServerCpu* pServer);
+StcServerStatus StcServerCpuWaitForClientReadStream(StcServerCpu* pServer, size_t stream);
+StcServerStatus StcServerCpuSignalWrite(StcServerCpu* pServer);
+StcServerStatus StcServerCpuSignalWriteStream(StcServerCpu* pServer, size_t stream);
+void StcServerCpuSetSliceCount(StcServerCpu* pServer, uint32_t sliceCount);
+void StcServerCpuSetSliceCountStream(StcServerCpu* pServer, size_t stream, uint32_t sliceCount);
+StcServerStatus StcServerCpuSignalSlice(StcServerCpu* pServer);
+StcServerStatus StcServerCpuSignalSliceStream(StcServerCpu* pServer, size_t stream);
+StcServerStatus StcServerCpuWriteFrameMetadata(StcServerCpu* pServer, const void* pData, size_t size);
+StcServerStatus StcServerCpuWriteFrameMetadataStream(StcServerCpu* pServer, size_t stream, const void* pData, size_t size);
+StcServerStatus StcServerCpuWriteAuxRecord(StcServerCpu* pServer, uint32_t type, const void* pData, size_t size);
+StcServerStatus StcServerCpuWriteAuxRecordStream(StcServerCpu* pServer, size_t stream, uint32_t type, const void* pData,
+                                                 size_t size);
+StcServerStatus StcServerCpuWait(StcServerCpu* pServer, uint32_t timeoutMs);
+void StcServerCpuSetControlCallbacks(StcServerCpu* pServer, const StcControlCallbacks* pController);
+// A resize waits until no other has come for this long, so a window drag recreates the ring once it settles instead of at
+// every step. Defaults to STC_DEFAULT_RESIZE_DELAY_MICROSECONDS; 0 applies it at the next Tick.
+void StcServerCpuSetResizeDelay(StcServerCpu* pServer, uint32_t delayMicroseconds);
+#ifdef _WIN32
+HANDLE StcServerCpuGetWaitHandle(StcServerCpu* pServer);
+#endif
+#ifdef STC_TRANSPORT_PASSES_DESCRIPTORS
+// Turns readable for epoll or poll when Wait would return, and stays so until the next Tick. Only clients that negotiated
+// STC_CAPABILITY_FLAG_WAKE_DESCRIPTORS reach it once connected, so keep a timeout below the keepalive interval.
+int StcServerCpuGetWaitFd(StcServerCpu* pServer);
+#endif
+
+#ifdef _WIN32
+// A D3D12 server shares its textures and write fences with up to STC_MAX_CLIENT_COUNT D3D12 clients, each with its own
+// read fences. D3D11 clients take frames through a keyed mutex, whose one client key admits a single reader, so a D3D11
+// client of a D3D12 server has the frames to itself. A D3D11 server serves one client of either API: it cycles the keyed
+// mutex itself, and its D3D12 clients share a single read fence per slot.
 StcServerStatus StcServerD3D11Create(StcServerD3D11* pServer, const TCHAR* pPrefix, const StcServerGraphicsInfo* pGraphicsInfo,
-                                     ID3D11Device* pDevice, const StcD3D11AllocationCallbacks* pAllocator,
+                                     size_t metadataCapacity, ID3D11Device* pDevice, const StcD3D11AllocationCallbacks* pAllocator,
                                      const StcMessageCallbacks* pMessenger);
 StcServerStatus StcServerD3D12Create(StcServerD3D12* pServer, const TCHAR* pPrefix, const StcServerGraphicsInfo* pGraphicsInfo,
-                                     ID3D12Device* pDevice, const StcD3D12AllocationCallbacks* pAllocator,
+                                     size_t metadataCapacity, ID3D12Device* pDevice, const StcD3D12AllocationCallbacks* pAllocator,
                                      const StcMessageCallbacks* pMessenger);
 void StcServerD3D11Destroy(StcServerD3D11* pServer);
 void StcServerD3D12Destroy(StcServerD3D12* pServer);
@@ -144,6 +312,23 @@ StcServerStatus StcServerD3D11WaitForClientRead(StcServerD3D11* pServer);
 StcServerStatus StcServerD3D12WaitForClientRead(StcServerD3D12* pServer, ID3D12CommandQueue* pQueue);
 StcServerStatus StcServerD3D11SignalWrite(StcServerD3D11* pServer);
 StcServerStatus StcServerD3D12SignalWrite(StcServerD3D12* pServer, ID3D12CommandQueue* pQueue);
+// Slicing is left to D3D12 servers: a D3D11 texture changes hands through its keyed mutex, which has no partial handover.
+// For the same reason a D3D12 server writes whole frames while a D3D11 client is connected, with NextInfo.sliceCount at 1.
+void StcServerD3D12SetSliceCount(StcServerD3D12* pServer, uint32_t sliceCount);
+StcServerStatus StcServerD3D12SignalSlice(StcServerD3D12* pServer, ID3D12CommandQueue* pQueue);
+StcServerStatus StcServerD3D11WriteFrameMetadata(StcServerD3D11* pServer, const void* pData, size_t size);
+StcServerStatus StcServerD3D12WriteFrameMetadata(StcServerD3D12* pServer, const void* pData, size_t size);
+StcServerStatus StcServerD3D11WriteAuxRecord(StcServerD3D11* pServer, uint32_t type, const void* pData, size_t size);
+StcServerStatus StcServerD3D12WriteAuxRecord(StcServerD3D12* pServer, uint32_t type, const void* pData, size_t size);
+StcServerStatus StcServerD3D11Wait(StcServerD3D11* pServer, uint32_t timeoutMs);
+StcServerStatus StcServerD3D12Wait(StcServerD3D12* pServer, uint32_t timeoutMs);
+HANDLE StcServerD3D11GetWaitHandle(StcServerD3D11* pServer);
+HANDLE StcServerD3D12GetWaitHandle(StcServerD3D12* pServer);
+void StcServerD3D11SetControlCallbacks(StcServerD3D11* pServer, const StcControlCallbacks* pController);
+void StcServerD3D12SetControlCallbacks(StcServerD3D12* pServer, const StcControlCallbacks* pController);
+void StcServerD3D11SetResizeDelay(StcServerD3D11* pServer, uint32_t delayMicroseconds);
+void StcServerD3D12SetResizeDelay(StcServerD3D12* pServer, uint32_t delayMicroseconds);
+#endif
 
 #ifdef __cplusplus
 }
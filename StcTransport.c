@@ -0,0 +1,776 @@
+/*
+ * Copyright 2020 Lag Free Games, LLC
+ * All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sub license, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the
+ * next paragraph) shall be included in all copies or substantial portions
+ * of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT.
+ * IN NO EVENT SHALL VMWARE AND/OR ITS SUPPLIERS BE LIABLE FOR
+ * ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef _WIN32
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE 1
+#endif
+#endif
+
+#include "StcTransport.h"
+
+#ifdef _WIN32
+
+#pragma warning(disable : 4710)
+#pragma warning(disable : 4711)
+
+#define StcCpuRelax() YieldProcessor()
+
+StcMappingResult StcMappingCreate(StcMapping* const pMapping, const TCHAR* const pName, const size_t size, int* const pError) {
+    StcMappingResult result = STC_MAPPING_RESULT_SUCCESS;
+
+    const uint64_t size64 = size;
+    const HANDLE hMapFile =
+        CreateFileMapping(INVALID_HANDLE_VALUE, NULL, PAGE_READWRITE, (DWORD)(size64 >> 32), (DWORD)size64, pName);
+    if (hMapFile == NULL) {
+        *pError = (int)GetLastError();
+        result = STC_MAPPING_RESULT_FAIL_CREATE;
+        goto fail0;
+    }
+
+    void* const pView = MapViewOfFile(hMapFile, FILE_MAP_ALL_ACCESS, 0, 0, size);
+    if (pView == NULL) {
+        *pError = (int)GetLastError();
+        result = STC_MAPPING_RESULT_FAIL_MAP;
+        goto fail1;
+    }
+
+    pMapping->hMapFile = hMapFile;
+    pMapping->pView = pView;
+    pMapping->size = size;
+    goto success;
+
+fail1:
+    CloseHandle(hMapFile);
+fail0:
+success:
+    return result;
+}
+
+StcMappingResult StcMappingOpen(StcMapping* const pMapping, const TCHAR* const pName, const size_t size, int* const pError) {
+    StcMappingResult result = STC_MAPPING_RESULT_SUCCESS;
+
+    const HANDLE hMapFile = OpenFileMapping(FILE_MAP_ALL_ACCESS, FALSE, pName);
+    if (hMapFile == NULL) {
+        *pError = (int)GetLastError();
+        result = STC_MAPPING_RESULT_FAIL_OPEN;
+        goto fail0;
+    }
+
+    void* const pView = MapViewOfFile(hMapFile, FILE_MAP_ALL_ACCESS, 0, 0, size);
+    CloseHandle(hMapFile);
+    if (pView == NULL) {
+        *pError = (int)GetLastError();
+        result = STC_MAPPING_RESULT_FAIL_MAP;
+        goto fail0;
+    }
+
+    size_t viewSize = size;
+    if (viewSize == 0) {
+        MEMORY_BASIC_INFORMATION info;
+        VirtualQuery(pView, &info, sizeof(info));
+        viewSize = info.RegionSize;
+    }
+
+    pMapping->hMapFile = NULL;
+    pMapping->pView = pView;
+    pMapping->size = viewSize;
+
+fail0:
+    return result;
+}
+
+void StcMappingClose(StcMapping* const pMapping) {
+    UnmapViewOfFile(pMapping->pView);
+    if (pMapping->hMapFile != NULL) {
+        CloseHandle(pMapping->hMapFile);
+    }
+
+    pMapping->pView = NULL;
+}
+
+bool StcEventCreate(StcEvent* const pEvent, const TCHAR* const pName, int* const pError) {
+    const HANDLE hEvent = CreateEvent(NULL, FALSE, FALSE, pName);
+    if (hEvent == NULL) {
+        *pError = (int)GetLastError();
+    }
+
+    pEvent->hEvent = hEvent;
+    pEvent->pWord = NULL;
+    return hEvent != NULL;
+}
+
+bool StcEventOpen(StcEvent* const pEvent, const TCHAR* const pName, int* const pError) {
+    const HANDLE hEvent = OpenEvent(SYNCHRONIZE | EVENT_MODIFY_STATE, FALSE, pName);
+    if (hEvent == NULL) {
+        *pError = (int)GetLastError();
+    }
+
+    pEvent->hEvent = hEvent;
+    pEvent->pWord = NULL;
+    return hEvent != NULL;
+}
+
+void StcEventClose(StcEvent* const pEvent) {
+    CloseHandle(pEvent->hEvent);
+    pEvent->hEvent = NULL;
+    pEvent->pWord = NULL;
+}
+
+static void WakeWaiters(StcEvent* const pEvent) { SetEvent(pEvent->hEvent); }
+
+static bool BlockUntilSignaled(StcEvent* const pEvent, const uint32_t token, const uint32_t timeoutMs) {
+    (void)token;
+    return WaitForSingleObject(pEvent->hEvent, timeoutMs) == WAIT_OBJECT_0;
+}
+
+static void ClearDescriptor(StcEvent* const pEvent) { (void)pEvent; }
+
+#else
+
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <linux/futex.h>
+#include <string.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <sys/time.h>
+#include <sys/un.h>
+#include <time.h>
+#include <unistd.h>
+
+#if defined(__i386__) || defined(__x86_64__)
+#define StcCpuRelax() __builtin_ia32_pause()
+#elif defined(__aarch64__)
+#define StcCpuRelax() __asm__ __volatile__("yield")
+#else
+#define StcCpuRelax() ((void)0)
+#endif
+
+#ifdef MAP_POPULATE
+#define STC_MAP_FLAGS (MAP_SHARED | MAP_POPULATE)
+#else
+#define STC_MAP_FLAGS MAP_SHARED
+#endif
+
+static bool FormatObjectName(char* const pBuffer, const size_t count, const char* const pName) {
+    const int result = snprintf(pBuffer, count, "/%s", pName);
+    return (result > 0) && ((size_t)result < count);
+}
+
+StcMappingResult StcMappingCreate(StcMapping* const pMapping, const TCHAR* const pName, const size_t size, int* const pError) {
+    StcMappingResult result = STC_MAPPING_RESULT_SUCCESS;
+
+    char pObjectName[_countof(pMapping->pName)];
+    if (!FormatObjectName(pObjectName, _countof(pObjectName), pName)) {
+        *pError = ENAMETOOLONG;
+        result = STC_MAPPING_RESULT_FAIL_CREATE;
+        goto fail0;
+    }
+
+    int fd = shm_open(pObjectName, O_RDWR | O_CREAT | O_EXCL, S_IRUSR | S_IWUSR);
+    if ((fd < 0) && (errno == EEXIST)) {
+        // Names embed our process ID, so this was left behind by a dead process.
+        shm_unlink(pObjectName);
+        fd = shm_open(pObjectName, O_RDWR | O_CREAT | O_EXCL, S_IRUSR | S_IWUSR);
+    }
+    if (fd < 0) {
+        *pError = errno;
+        result = STC_MAPPING_RESULT_FAIL_CREATE;
+        goto fail0;
+    }
+
+    if (ftruncate(fd, (off_t)size) != 0) {
+        *pError = errno;
+        result = STC_MAPPING_RESULT_FAIL_CREATE;
+        goto fail1;
+    }
+
+    void* const pView = mmap(NULL, size, PROT_READ | PROT_WRITE, STC_MAP_FLAGS, fd, 0);
+    if (pView == MAP_FAILED) {
+        *pError = errno;
+        result = STC_MAPPING_RESULT_FAIL_MAP;
+        goto fail1;
+    }
+
+    close(fd);
+
+    memcpy(pMapping->pName, pObjectName, sizeof(pObjectName));
+    pMapping->owner = true;
+    pMapping->fd = -1;
+    pMapping->pView = pView;
+    pMapping->size = size;
+    goto success;
+
+fail1:
+    close(fd);
+    shm_unlink(pObjectName);
+fail0:
+success:
+    return result;
+}
+
+StcMappingResult StcMappingOpen(StcMapping* const pMapping, const TCHAR* const pName, const size_t size, int* const pError) {
+    StcMappingResult result = STC_MAPPING_RESULT_SUCCESS;
+
+    char pObjectName[_countof(pMapping->pName)];
+    if (!FormatObjectName(pObjectName, _countof(pObjectName), pName)) {
+        *pError = ENAMETOOLONG;
+        result = STC_MAPPING_RESULT_FAIL_OPEN;
+        goto fail0;
+    }
+
+    const int fd = shm_open(pObjectName, O_RDWR, 0);
+    if (fd < 0) {
+        *pError = errno;
+        result = STC_MAPPING_RESULT_FAIL_OPEN;
+        goto fail0;
+    }
+
+    // Touching pages past the end of a short object would raise SIGBUS instead of failing here.
+    struct stat info;
+    if ((fstat(fd, &info) != 0) || (info.st_size == 0) || ((size_t)info.st_size < size)) {
+        *pError = EINVAL;
+        result = STC_MAPPING_RESULT_FAIL_MAP;
+        goto fail1;
+    }
+
+    const size_t viewSize = (size == 0) ? (size_t)info.st_size : size;
+    void* const pView = mmap(NULL, viewSize, PROT_READ | PROT_WRITE, STC_MAP_FLAGS, fd, 0);
+    if (pView == MAP_FAILED) {
+        *pError = errno;
+        result = STC_MAPPING_RESULT_FAIL_MAP;
+        goto fail1;
+    }
+
+    close(fd);
+
+    pMapping->pName[0] = '\0';
+    pMapping->owner = false;
+    pMapping->fd = -1;
+    pMapping->pView = pView;
+    pMapping->size = viewSize;
+    goto success;
+
+fail1:
+    close(fd);
+fail0:
+success:
+    return result;
+}
+
+void StcMappingClose(StcMapping* const pMapping) {
+    munmap(pMapping->pView, pMapping->size);
+    if (pMapping->owner) {
+        shm_unlink(pMapping->pName);
+    }
+    if (pMapping->fd >= 0) {
+        close(pMapping->fd);
+    }
+
+    pMapping->pView = NULL;
+}
+
+#ifdef STC_TRANSPORT_PASSES_DESCRIPTORS
+StcMappingResult StcMappingCreateAnonymous(StcMapping* const pMapping, const size_t size, int* const pError) {
+    StcMappingResult result = STC_MAPPING_RESULT_SUCCESS;
+
+    const int fd = memfd_create("stc", MFD_CLOEXEC | MFD_ALLOW_SEALING);
+    if (fd < 0) {
+        *pError = errno;
+        result = STC_MAPPING_RESULT_FAIL_CREATE;
+        goto fail0;
+    }
+
+    // Sealing the size means the receiver can trust fstat and never fault on a shrunken object
+    if ((ftruncate(fd, (off_t)size) != 0) || (fcntl(fd, F_ADD_SEALS, F_SEAL_SHRINK | F_SEAL_GROW | F_SEAL_SEAL) != 0)) {
+        *pError = errno;
+        result = STC_MAPPING_RESULT_FAIL_CREATE;
+        goto fail1;
+    }
+
+    void* const pView = mmap(NULL, size, PROT_READ | PROT_WRITE, STC_MAP_FLAGS, fd, 0);
+    if (pView == MAP_FAILED) {
+        *pError = errno;
+        result = STC_MAPPING_RESULT_FAIL_MAP;
+        goto fail1;
+    }
+
+    pMapping->pName[0] = '\0';
+    pMapping->owner = false;
+    pMapping->fd = fd;
+    pMapping->pView = pView;
+    pMapping->size = size;
+    goto success;
+
+fail1:
+    close(fd);
+fail0:
+success:
+    return result;
+}
+
+StcMappingResult StcMappingOpenDescriptor(StcMapping* const pMapping, const int fd, int* const pError) {
+    StcMappingResult result = STC_MAPPING_RESULT_SUCCESS;
+
+    const int seals = fcntl(fd, F_GET_SEALS);
+    struct stat info;
+    if ((seals < 0) || ((seals & F_SEAL_SHRINK) == 0) || (fstat(fd, &info) != 0) || (info.st_size == 0)) {
+        *pError = EINVAL;
+        result = STC_MAPPING_RESULT_FAIL_OPEN;
+        goto fail0;
+    }
+
+    const size_t viewSize = (size_t)info.st_size;
+    void* const pView = mmap(NULL, viewSize, PROT_READ | PROT_WRITE, STC_MAP_FLAGS, fd, 0);
+    if (pView == MAP_FAILED) {
+        *pError = errno;
+        result = STC_MAPPING_RESULT_FAIL_MAP;
+        goto fail0;
+    }
+
+    pMapping->pName[0] = '\0';
+    pMapping->owner = false;
+    pMapping->fd = -1;
+    pMapping->pView = pView;
+    pMapping->size = viewSize;
+
+fail0:
+    close(fd);
+    return result;
+}
+
+// Abstract names vanish with their last descriptor, so nothing is left behind by a crash
+static bool FormatChannelAddress(struct sockaddr_un* const pAddress, socklen_t* const pLength, const char* const pName) {
+    memset(pAddress, 0, sizeof(*pAddress));
+    pAddress->sun_family = AF_UNIX;
+
+    const int result = snprintf(pAddress->sun_path + 1, sizeof(pAddress->sun_path) - 1, "%s", pName);
+    *pLength = (socklen_t)(offsetof(struct sockaddr_un, sun_path) + 1 + (size_t)result);
+    return (result > 0) && ((size_t)result < (sizeof(pAddress->sun_path) - 1));
+}
+
+// Only trust peers running as our own user, the same rule the 0600 shared memory objects enforce
+static bool IsPeerTrusted(const int fd) {
+    struct ucred credentials;
+    socklen_t length = sizeof(credentials);
+    return (getsockopt(fd, SOL_SOCKET, SO_PEERCRED, &credentials, &length) == 0) && (credentials.uid == geteuid());
+}
+
+void StcChannelReset(StcChannel* const pChannel) { pChannel->fd = -1; }
+
+bool StcChannelListen(StcChannel* const pChannel, const TCHAR* const pName, int* const pError) {
+    struct sockaddr_un address;
+    socklen_t length;
+    if (!FormatChannelAddress(&address, &length, pName)) {
+        *pError = ENAMETOOLONG;
+        return false;
+    }
+
+    const int fd = socket(AF_UNIX, SOCK_SEQPACKET | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if ((fd < 0) || (bind(fd, (const struct sockaddr*)&address, length) != 0) || (listen(fd, 1) != 0)) {
+        *pError = errno;
+        if (fd >= 0) {
+            close(fd);
+        }
+
+        return false;
+    }
+
+    pChannel->fd = fd;
+    return true;
+}
+
+bool StcChannelAccept(StcChannel* const pListener, StcChannel* const pChannel, int* const pError) {
+    const int fd = accept4(pListener->fd, NULL, NULL, SOCK_CLOEXEC);
+    if (fd < 0) {
+        *pError = errno;
+        return false;
+    }
+
+    if (!IsPeerTrusted(fd)) {
+        close(fd);
+        *pError = EACCES;
+        return false;
+    }
+
+    pChannel->fd = fd;
+    return true;
+}
+
+bool StcChannelConnect(StcChannel* const pChannel, const TCHAR* const pName, int* const pError) {
+    struct sockaddr_un address;
+    socklen_t length;
+    if (!FormatChannelAddress(&address, &length, pName)) {
+        *pError = ENAMETOOLONG;
+        return false;
+    }
+
+    const int fd = socket(AF_UNIX, SOCK_SEQPACKET | SOCK_CLOEXEC, 0);
+    if ((fd < 0) || (connect(fd, (const struct sockaddr*)&address, length) != 0) || !IsPeerTrusted(fd)) {
+        *pError = (fd < 0) ? errno : EACCES;
+        if (fd >= 0) {
+            close(fd);
+        }
+
+        return false;
+    }
+
+    pChannel->fd = fd;
+    return true;
+}
+
+bool StcChannelSend(StcChannel* const pChannel, const void* const pData, const size_t size, const int* const pFds,
+                    const size_t fdCount, int* const pError) {
+    if (fdCount > STC_CHANNEL_MAX_DESCRIPTORS) {
+        *pError = EINVAL;
+        return false;
+    }
+
+    struct iovec vector = {(void*)pData, size};
+
+    union {
+        char buffer[CMSG_SPACE(sizeof(int) * STC_CHANNEL_MAX_DESCRIPTORS)];
+        struct cmsghdr align;
+    } control;
+    memset(&control, 0, sizeof(control));
+
+    struct msghdr message;
+    memset(&message, 0, sizeof(message));
+    message.msg_iov = &vector;
+    message.msg_iovlen = 1;
+    if (fdCount > 0) {
+        message.msg_control = control.buffer;
+        message.msg_controllen = CMSG_SPACE(sizeof(int) * fdCount);
+
+        struct cmsghdr* const pHeader = CMSG_FIRSTHDR(&message);
+        pHeader->cmsg_level = SOL_SOCKET;
+        pHeader->cmsg_type = SCM_RIGHTS;
+        pHeader->cmsg_len = CMSG_LEN(sizeof(int) * fdCount);
+        memcpy(CMSG_DATA(pHeader), pFds, sizeof(int) * fdCount);
+    }
+
+    const ssize_t sent = sendmsg(pChannel->fd, &message, MSG_NOSIGNAL);
+    if (sent != (ssize_t)size) {
+        *pError = (sent < 0) ? errno : EMSGSIZE;
+        return false;
+    }
+
+    return true;
+}
+
+// Fills pFds with every descriptor attached to the message, closing them all unless it is well formed and brought no more
+// than *pFdCount of them
+static bool ReceiveMessage(StcChannel* const pChannel, void* const pData, const size_t size, int* const pFds,
+                           size_t* const pFdCount, int* const pError) {
+    struct iovec vector = {pData, size};
+
+    union {
+        char buffer[CMSG_SPACE(sizeof(int) * STC_CHANNEL_MAX_DESCRIPTORS)];
+        struct cmsghdr align;
+    } control;
+
+    struct msghdr message;
+    memset(&message, 0, sizeof(message));
+    message.msg_iov = &vector;
+    message.msg_iovlen = 1;
+    message.msg_control = control.buffer;
+    message.msg_controllen = sizeof(control.buffer);
+
+    const ssize_t received = recvmsg(pChannel->fd, &message, MSG_CMSG_CLOEXEC);
+    if (received < 0) {
+        *pError = errno;
+        return false;
+    }
+
+    // A short or truncated message means the peer is gone or misbehaving; either way nothing here can be used
+    bool valid = (received == (ssize_t)size) && ((message.msg_flags & (MSG_TRUNC | MSG_CTRUNC)) == 0);
+    *pError = (received == 0) ? ECONNRESET : EBADMSG;
+
+    size_t fdCount = 0;
+    for (struct cmsghdr* pHeader = CMSG_FIRSTHDR(&message); pHeader != NULL; pHeader = CMSG_NXTHDR(&message, pHeader)) {
+        if ((pHeader->cmsg_level == SOL_SOCKET) && (pHeader->cmsg_type == SCM_RIGHTS)) {
+            const size_t count = (pHeader->cmsg_len - CMSG_LEN(0)) / sizeof(int);
+            for (size_t i = 0; i < count; ++i) {
+                int fd;
+                memcpy(&fd, CMSG_DATA(pHeader) + (i * sizeof(int)), sizeof(int));
+                if (valid && (fdCount < *pFdCount)) {
+                    pFds[fdCount++] = fd;
+                } else {
+                    valid = false;
+                    close(fd);
+                }
+            }
+        }
+    }
+
+    if (!valid) {
+        for (size_t i = 0; i < fdCount; ++i) {
+            close(pFds[i]);
+        }
+
+        return false;
+    }
+
+    *pFdCount = fdCount;
+    return true;
+}
+
+bool StcChannelReceive(StcChannel* const pChannel, void* const pData, const size_t size, StcMapping* const pMappings,
+                       size_t* const pMappingCount, int* const pError) {
+    int fds[STC_CHANNEL_MAX_DESCRIPTORS];
+    size_t fdCount = (*pMappingCount < STC_CHANNEL_MAX_DESCRIPTORS) ? *pMappingCount : STC_CHANNEL_MAX_DESCRIPTORS;
+    if (!ReceiveMessage(pChannel, pData, size, fds, &fdCount, pError)) {
+        return false;
+    }
+
+    size_t mappingCount = 0;
+    bool valid = true;
+    for (size_t i = 0; i < fdCount; ++i) {
+        if (valid && (StcMappingOpenDescriptor(&pMappings[mappingCount], fds[i], pError) == STC_MAPPING_RESULT_SUCCESS)) {
+            ++mappingCount;
+        } else {
+            valid = false;
+            close(fds[i]);
+        }
+    }
+
+    if (!valid) {
+        for (size_t i = 0; i < mappingCount; ++i) {
+            StcMappingClose(&pMappings[i]);
+        }
+
+        return false;
+    }
+
+    *pMappingCount = mappingCount;
+    return true;
+}
+
+bool StcChannelReceiveDescriptor(StcChannel* const pChannel, void* const pData, const size_t size, int* const pFd,
+                                 int* const pError) {
+    size_t fdCount = 1;
+    if (!ReceiveMessage(pChannel, pData, size, pFd, &fdCount, pError)) {
+        return false;
+    }
+
+    if (fdCount != 1) {
+        *pError = EBADMSG;
+        return false;
+    }
+
+    return true;
+}
+
+bool StcChannelSetReceiveTimeout(StcChannel* const pChannel, const uint32_t timeoutMs, int* const pError) {
+    struct timeval timeout;
+    timeout.tv_sec = (time_t)(timeoutMs / 1000);
+    timeout.tv_usec = (suseconds_t)((timeoutMs % 1000) * 1000);
+    if (setsockopt(pChannel->fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout)) != 0) {
+        *pError = errno;
+        return false;
+    }
+
+    return true;
+}
+
+void StcChannelClose(StcChannel* const pChannel) {
+    if (pChannel->fd >= 0) {
+        close(pChannel->fd);
+        pChannel->fd = -1;
+    }
+}
+#endif
+
+bool StcEventCreate(StcEvent* const pEvent, const TCHAR* const pName, int* const pError) {
+    (void)pName;
+    (void)pError;
+
+    pEvent->fd = -1;
+    pEvent->pollFd = -1;
+    pEvent->polled = false;
+    pEvent->pWord = NULL;
+    return true;
+}
+
+bool StcEventOpen(StcEvent* const pEvent, const TCHAR* const pName, int* const pError) {
+    (void)pName;
+    (void)pError;
+
+    pEvent->fd = -1;
+    pEvent->pollFd = -1;
+    pEvent->polled = false;
+    pEvent->pWord = NULL;
+    return true;
+}
+
+void StcEventClose(StcEvent* const pEvent) {
+    if (pEvent->polled) {
+        StcAtomicUint32Decrement(&pEvent->pWord->waiters);
+        pEvent->polled = false;
+    }
+
+    if (pEvent->pollFd >= 0) {
+        close(pEvent->pollFd);
+        pEvent->pollFd = -1;
+    }
+
+    if (pEvent->fd >= 0) {
+        close(pEvent->fd);
+        pEvent->fd = -1;
+    }
+
+    pEvent->pWord = NULL;
+}
+
+bool StcEventCreateDescriptor(StcEvent* const pEvent, int* const pError) {
+    const int fd = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+    if (fd < 0) {
+        *pError = errno;
+        return false;
+    }
+
+    pEvent->fd = fd;
+    return true;
+}
+
+void StcEventAttachDescriptor(StcEvent* const pEvent, const int fd) {
+    if (pEvent->fd >= 0) {
+        close(pEvent->fd);
+    }
+
+    pEvent->fd = fd;
+}
+
+bool StcEventWatchDescriptor(StcEvent* const pEvent, const int fd, int* const pError) {
+    struct epoll_event event;
+    memset(&event, 0, sizeof(event));
+    if (pEvent->pollFd < 0) {
+        const int pollFd = epoll_create1(EPOLL_CLOEXEC);
+        event.events = EPOLLIN;
+        if ((pollFd < 0) || (epoll_ctl(pollFd, EPOLL_CTL_ADD, pEvent->fd, &event) != 0)) {
+            *pError = errno;
+            if (pollFd >= 0) {
+                close(pollFd);
+            }
+
+            return false;
+        }
+
+        pEvent->pollFd = pollFd;
+    }
+
+    // Closing fd takes it out of the set again
+    event.events = EPOLLIN | EPOLLET;
+    if (epoll_ctl(pEvent->pollFd, EPOLL_CTL_ADD, fd, &event) != 0) {
+        *pError = errno;
+        return false;
+    }
+
+    return true;
+}
+
+int StcEventGetDescriptor(StcEvent* const pEvent) {
+    if ((pEvent->fd >= 0) && !pEvent->polled) {
+        StcAtomicUint32Increment(&pEvent->pWord->waiters);
+        pEvent->polled = true;
+    }
+
+    return (pEvent->pollFd >= 0) ? pEvent->pollFd : pEvent->fd;
+}
+
+// The words live in a MAP_SHARED mapping, so these must not be the FUTEX_PRIVATE variants.
+static void WakeWaiters(StcEvent* const pEvent) {
+    syscall(SYS_futex, &pEvent->pWord->sequence.storage, FUTEX_WAKE, INT_MAX, NULL, NULL, 0);
+    if (pEvent->fd >= 0) {
+        const uint64_t increment = 1;
+        (void)!write(pEvent->fd, &increment, sizeof(increment));
+    }
+}
+
+static void ClearDescriptor(StcEvent* const pEvent) {
+    if (pEvent->polled) {
+        uint64_t count;
+        (void)!read(pEvent->fd, &count, sizeof(count));
+    }
+}
+
+static bool BlockUntilSignaled(StcEvent* const pEvent, const uint32_t token, const uint32_t timeoutMs) {
+    struct timespec timeout;
+    timeout.tv_sec = timeoutMs / 1000;
+    timeout.tv_nsec = (long)(timeoutMs % 1000) * 1000000;
+    const int result = (int)syscall(SYS_futex, &pEvent->pWord->sequence.storage, FUTEX_WAIT, (int32_t)token,
+                                    (timeoutMs == STC_WAIT_INFINITE) ? NULL : &timeout, NULL, 0);
+    return (result == 0) || (errno != ETIMEDOUT);
+}
+
+#endif
+
+// Spinning first keeps wakeups cheap when the other side is about to signal anyway, e.g. a client keeping pace with a
+// server. A few thousand pauses is on the order of microseconds.
+#define STC_EVENT_SPIN_COUNT 4096
+
+// Clearing first means a signal racing the load leaves the descriptor readable, so a poller wakes at worst once too often
+uint32_t StcEventGetToken(StcEvent* const pEvent) {
+    ClearDescriptor(pEvent);
+    return StcAtomicUint32Load(&pEvent->pWord->sequence);
+}
+
+void StcEventSignal(StcEvent* const pEvent) {
+    StcWakeWord* const pWord = pEvent->pWord;
+
+    // Pairs with the waiter's increment of waiters and re-check of sequence: one of the two sides must see the other.
+    StcAtomicUint32Increment(&pWord->sequence);
+    if (StcAtomicUint32Increment(&pWord->waiters) > 1) {
+        WakeWaiters(pEvent);
+    }
+    StcAtomicUint32Decrement(&pWord->waiters);
+}
+
+bool StcEventWait(StcEvent* const pEvent, const uint32_t token, const uint32_t timeoutMs) {
+    StcWakeWord* const pWord = pEvent->pWord;
+
+    for (int i = 0; i < STC_EVENT_SPIN_COUNT; ++i) {
+        if (StcAtomicUint32Load(&pWord->sequence) != token) {
+            return true;
+        }
+
+        StcCpuRelax();
+    }
+
+    bool signaled = true;
+    StcAtomicUint32Increment(&pWord->waiters);
+    if (StcAtomicUint32Load(&pWord->sequence) == token) {
+        signaled = BlockUntilSignaled(pEvent, token, timeoutMs);
+    }
+    StcAtomicUint32Decrement(&pWord->waiters);
+
+    return signaled;
+}
@@ -0,0 +1,131 @@
+/*
+ * Copyright 2020 Lag Free Games, LLC
+ * All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sub license, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the
+ * next paragraph) shall be included in all copies or substantial portions
+ * of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT.
+ * IN NO EVENT SHALL VMWARE AND/OR ITS SUPPLIERS BE LIABLE FOR
+ * ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#pragma once
+
+#include "StcCommon.h"
+
+// Linux can pass descriptors between processes, so frames there are anonymous and handed over a per-connection channel
+#ifdef __linux__
+#define STC_TRANSPORT_PASSES_DESCRIPTORS 1
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#pragma warning(push)
+#pragma warning(disable : 4820)
+
+typedef enum StcMappingResult {
+    STC_MAPPING_RESULT_SUCCESS,
+    STC_MAPPING_RESULT_FAIL_CREATE,
+    STC_MAPPING_RESULT_FAIL_OPEN,
+    STC_MAPPING_RESULT_FAIL_MAP,
+} StcMappingResult;
+
+typedef struct StcMapping {
+#ifdef _WIN32
+    HANDLE hMapFile;
+#else
+    char pName[256];
+    bool owner;
+    int fd;
+#endif
+    void* pView;
+    size_t size;
+} StcMapping;
+
+#ifdef STC_TRANSPORT_PASSES_DESCRIPTORS
+typedef struct StcChannel {
+    int fd;
+} StcChannel;
+#endif
+
+typedef struct StcEvent {
+#ifdef _WIN32
+    HANDLE hEvent;
+#endif
+#ifdef STC_TRANSPORT_PASSES_DESCRIPTORS
+    int fd;
+    int pollFd;
+    bool polled;
+#endif
+    StcWakeWord* pWord;
+} StcEvent;
+
+#pragma warning(pop)
+
+StcMappingResult StcMappingCreate(StcMapping* pMapping, const TCHAR* pName, size_t size, int* pError);
+// A size of 0 maps the whole object, and the mapped size is returned in pMapping->size.
+StcMappingResult StcMappingOpen(StcMapping* pMapping, const TCHAR* pName, size_t size, int* pError);
+void StcMappingClose(StcMapping* pMapping);
+
+#ifdef STC_TRANSPORT_PASSES_DESCRIPTORS
+// Anonymous mappings keep their descriptor in fd for StcChannelSend. OpenDescriptor takes ownership of fd.
+// StcChannelReceive maps every attached descriptor, so receivers never handle raw descriptors.
+StcMappingResult StcMappingCreateAnonymous(StcMapping* pMapping, size_t size, int* pError);
+StcMappingResult StcMappingOpenDescriptor(StcMapping* pMapping, int fd, int* pError);
+
+#define STC_CHANNEL_MAX_DESCRIPTORS 16
+
+void StcChannelReset(StcChannel* pChannel);
+bool StcChannelListen(StcChannel* pChannel, const TCHAR* pName, int* pError);
+bool StcChannelAccept(StcChannel* pListener, StcChannel* pChannel, int* pError);
+bool StcChannelConnect(StcChannel* pChannel, const TCHAR* pName, int* pError);
+bool StcChannelSend(StcChannel* pChannel, const void* pData, size_t size, const int* pFds, size_t fdCount, int* pError);
+bool StcChannelReceive(StcChannel* pChannel, void* pData, size_t size, StcMapping* pMappings, size_t* pMappingCount,
+                       int* pError);
+// The one exception, for a message carrying an event descriptor to pass on to StcEventAttachDescriptor
+bool StcChannelReceiveDescriptor(StcChannel* pChannel, void* pData, size_t size, int* pFd, int* pError);
+// Bounds how long a receive on the channel blocks, 0 blocks indefinitely
+bool StcChannelSetReceiveTimeout(StcChannel* pChannel, uint32_t timeoutMs, int* pError);
+void StcChannelClose(StcChannel* pChannel);
+#endif
+
+#define STC_WAIT_INFINITE 0xFFFFFFFFu
+
+// Windows backs each event with a named kernel event. Elsewhere the event is only the futex on pWord, and names are ignored.
+bool StcEventCreate(StcEvent* pEvent, const TCHAR* pName, int* pError);
+bool StcEventOpen(StcEvent* pEvent, const TCHAR* pName, int* pError);
+void StcEventClose(StcEvent* pEvent);
+uint32_t StcEventGetToken(StcEvent* pEvent);
+void StcEventSignal(StcEvent* pEvent);
+bool StcEventWait(StcEvent* pEvent, uint32_t token, uint32_t timeoutMs);
+
+#ifdef STC_TRANSPORT_PASSES_DESCRIPTORS
+// A futex cannot go into epoll, so the waiting side can also back its event with an eventfd, which it sends to the
+// signalling side to attach. Signal then writes the eventfd too, but only once the waiter asked for it with
+// GetDescriptor, which counts as a waiter for as long as the event stays open. GetToken drains it.
+bool StcEventCreateDescriptor(StcEvent* pEvent, int* pError);
+void StcEventAttachDescriptor(StcEvent* pEvent, int fd);
+// GetDescriptor then returns an epoll set that also turns readable whenever fd does, edge triggered
+bool StcEventWatchDescriptor(StcEvent* pEvent, int fd, int* pError);
+int StcEventGetDescriptor(StcEvent* pEvent);
+#endif
+
+#ifdef __cplusplus
+}
+#endif
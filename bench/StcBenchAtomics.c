@@ -0,0 +1,217 @@
+/*
+ * Copyright 2020 Lag Free Games, LLC
+ * All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sub license, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the
+ * next paragraph) shall be included in all copies or substantial portions
+ * of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT.
+ * IN NO EVENT SHALL VMWARE AND/OR ITS SUPPLIERS BE LIABLE FOR
+ * ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+// Per-tick cost of the shared-memory accesses made by TickServer/StcServer*Tick/StcServer*SignalWrite and
+// TickClient/StcClient*Tick, using the original fully fenced orderings versus the current ones.
+//
+// Linux: cc -O2 -I.. StcBenchAtomics.c -o StcBenchAtomics -lpthread
+// MSVC:  cl /O2 /I.. StcBenchAtomics.c
+
+#include "StcCommon.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#ifdef _WIN32
+typedef HANDLE BenchThread;
+#else
+#include <pthread.h>
+#include <time.h>
+typedef pthread_t BenchThread;
+#endif
+
+#define BENCH_SOLO_TICKS 20000000
+#define BENCH_PAIRED_TICKS 5000000
+
+static int64_t BenchNow(void) {
+#ifdef _WIN32
+    LARGE_INTEGER count;
+    LARGE_INTEGER frequency;
+    QueryPerformanceCounter(&count);
+    QueryPerformanceFrequency(&frequency);
+    return (int64_t)((double)count.QuadPart * 1e9 / (double)frequency.QuadPart);
+#else
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+#endif
+}
+
+static StcInfo info;
+
+static void ServerTickFenced(StcInfo* const pInfo, const int64_t count) {
+    StcAtomicInt64Store(&pInfo->serverKeepAlive, count);
+    if (StcAtomicBoolLoad(&pInfo->serverInitialized) && (StcAtomicUint32Load(&pInfo->clientStopReason) == 0) &&
+        (StcAtomicInt64Load(&pInfo->clientKeepAlive) <= count)) {
+        StcAtomicUint32* const pState = &pInfo->streams[0].slotStates[count % STC_DEFAULT_TEXTURE_COUNT];
+        if (StcAtomicUint32Load(pState) == STC_SLOT_STATE_FREE) {
+            StcAtomicUint32Store(pState, STC_SLOT_STATE_WRITING);
+            StcAtomicUint32Store(pState, StcSlotMakeState(STC_SLOT_STATE_READY, (uint64_t)count));
+        }
+    }
+}
+
+static void ServerTickOrdered(StcInfo* const pInfo, const int64_t count) {
+    StcAtomicInt64StoreRelaxed(&pInfo->serverKeepAlive, count);
+    if (StcAtomicBoolLoadRelaxed(&pInfo->serverInitialized) && (StcAtomicUint32Load(&pInfo->clientStopReason) == 0) &&
+        (StcAtomicInt64LoadRelaxed(&pInfo->clientKeepAlive) <= count)) {
+        StcAtomicUint32* const pState = &pInfo->streams[0].slotStates[count % STC_DEFAULT_TEXTURE_COUNT];
+        if (StcAtomicUint32Load(pState) == STC_SLOT_STATE_FREE) {
+            StcAtomicUint32StoreRelaxed(pState, STC_SLOT_STATE_WRITING);
+            StcAtomicUint32StoreRelease(pState, StcSlotMakeState(STC_SLOT_STATE_READY, (uint64_t)count));
+        }
+    }
+}
+
+static void ClientTickFenced(StcInfo* const pInfo, const int64_t count) {
+    StcAtomicInt64Store(&pInfo->clientKeepAlive, count);
+    if ((StcAtomicUint32Load(&pInfo->serverStopReason) == 0) && (StcAtomicInt64Load(&pInfo->serverKeepAlive) <= count)) {
+        StcAtomicInt64Store(&pInfo->clientKeepAlive, count);
+        StcAtomicUint32* const pState = &pInfo->streams[0].slotStates[count % STC_DEFAULT_TEXTURE_COUNT];
+        const uint32_t state = StcAtomicUint32Load(pState);
+        if (StcAtomicBoolLoad(&pInfo->serverInitialized) && ((state & STC_SLOT_STATE_MASK) == STC_SLOT_STATE_READY) &&
+            (StcAtomicUint32CompareExchange(pState, (state & ~STC_SLOT_STATE_MASK) | STC_SLOT_STATE_READING, state) == state)) {
+            StcAtomicUint32Store(pState, STC_SLOT_STATE_FREE);
+        }
+    }
+}
+
+static void ClientTickOrdered(StcInfo* const pInfo, const int64_t count) {
+    StcAtomicInt64StoreRelaxed(&pInfo->clientKeepAlive, count);
+    if ((StcAtomicUint32Load(&pInfo->serverStopReason) == 0) && (StcAtomicInt64LoadRelaxed(&pInfo->serverKeepAlive) <= count)) {
+        StcAtomicUint32* const pState = &pInfo->streams[0].slotStates[count % STC_DEFAULT_TEXTURE_COUNT];
+        const uint32_t state = StcAtomicUint32Load(pState);
+        if (StcAtomicBoolLoad(&pInfo->serverInitialized) && ((state & STC_SLOT_STATE_MASK) == STC_SLOT_STATE_READY) &&
+            (StcAtomicUint32CompareExchange(pState, (state & ~STC_SLOT_STATE_MASK) | STC_SLOT_STATE_READING, state) == state)) {
+            StcAtomicUint32StoreRelease(pState, STC_SLOT_STATE_FREE);
+        }
+    }
+}
+
+typedef void (*PFN_BenchTick)(StcInfo* pInfo, int64_t count);
+
+static void ResetInfo(void) {
+    for (size_t i = 0; i < STC_MAX_TEXTURE_COUNT; ++i) {
+        StcAtomicUint32StoreRelaxed(&info.streams[0].slotStates[i], STC_SLOT_STATE_FREE);
+    }
+    StcAtomicInt64StoreRelaxed(&info.serverKeepAlive, 0);
+    StcAtomicInt64StoreRelaxed(&info.clientKeepAlive, 0);
+    StcAtomicUint32StoreRelaxed(&info.serverStopReason, 0);
+    StcAtomicUint32StoreRelaxed(&info.clientStopReason, 0);
+    StcAtomicBoolStore(&info.serverInitialized, true);
+}
+
+static double RunSolo(const PFN_BenchTick pfnServer, const PFN_BenchTick pfnClient) {
+    ResetInfo();
+    const int64_t start = BenchNow();
+    for (int64_t i = 0; i < BENCH_SOLO_TICKS; ++i) {
+        pfnServer(&info, i);
+        pfnClient(&info, i);
+    }
+    return (double)(BenchNow() - start) / BENCH_SOLO_TICKS;
+}
+
+typedef struct PairedArgs {
+    PFN_BenchTick pfnTick;
+    double nsPerTick;
+} PairedArgs;
+
+#ifdef _WIN32
+static DWORD WINAPI PairedMain(void* const pArg) {
+#else
+static void* PairedMain(void* const pArg) {
+#endif
+    PairedArgs* const pArgs = pArg;
+    const int64_t start = BenchNow();
+    for (int64_t i = 0; i < BENCH_PAIRED_TICKS; ++i) {
+        pArgs->pfnTick(&info, i);
+    }
+    pArgs->nsPerTick = (double)(BenchNow() - start) / BENCH_PAIRED_TICKS;
+#ifdef _WIN32
+    return 0;
+#else
+    return NULL;
+#endif
+}
+
+static bool StartThread(BenchThread* const pThread, PairedArgs* const pArgs) {
+#ifdef _WIN32
+    *pThread = CreateThread(NULL, 0, PairedMain, pArgs, 0, NULL);
+    return *pThread != NULL;
+#else
+    return pthread_create(pThread, NULL, PairedMain, pArgs) == 0;
+#endif
+}
+
+static void JoinThread(const BenchThread thread) {
+#ifdef _WIN32
+    WaitForSingleObject(thread, INFINITE);
+    CloseHandle(thread);
+#else
+    pthread_join(thread, NULL);
+#endif
+}
+
+static bool RunPaired(const PFN_BenchTick pfnServer, const PFN_BenchTick pfnClient, double* const pServerNs, double* const pClientNs) {
+    ResetInfo();
+
+    PairedArgs serverArgs = {pfnServer, 0.0};
+    PairedArgs clientArgs = {pfnClient, 0.0};
+    BenchThread serverThread;
+    BenchThread clientThread;
+    if (!StartThread(&serverThread, &serverArgs)) {
+        return false;
+    }
+    if (!StartThread(&clientThread, &clientArgs)) {
+        JoinThread(serverThread);
+        return false;
+    }
+    JoinThread(serverThread);
+    JoinThread(clientThread);
+
+    *pServerNs = serverArgs.nsPerTick;
+    *pClientNs = clientArgs.nsPerTick;
+    return true;
+}
+
+int main(void) {
+    const double soloFenced = RunSolo(ServerTickFenced, ClientTickFenced);
+    const double soloOrdered = RunSolo(ServerTickOrdered, ClientTickOrdered);
+
+    printf("%-28s %12s %12s\n", "", "fenced", "ordered");
+    printf("%-28s %9.2f ns %9.2f ns\n", "server+client tick (1 core)", soloFenced, soloOrdered);
+
+    double serverFenced, clientFenced, serverOrdered, clientOrdered;
+    if (RunPaired(ServerTickFenced, ClientTickFenced, &serverFenced, &clientFenced) &&
+        RunPaired(ServerTickOrdered, ClientTickOrdered, &serverOrdered, &clientOrdered)) {
+        printf("%-28s %9.2f ns %9.2f ns\n", "server tick (2 cores)", serverFenced, serverOrdered);
+        printf("%-28s %9.2f ns %9.2f ns\n", "client tick (2 cores)", clientFenced, clientOrdered);
+    } else {
+        fprintf(stderr, "Failed to start benchmark threads.\n");
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
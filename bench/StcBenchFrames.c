@@ -0,0 +1,358 @@
+/*
+ * Copyright 2020 Lag Free Games, LLC
+ * All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sub license, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the
+ * next paragraph) shall be included in all copies or substantial portions
+ * of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT.
+ * IN NO EVENT SHALL VMWARE AND/OR ITS SUPPLIERS BE LIABLE FOR
+ * ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+// End-to-end frame throughput and latency through the CPU backend, with the server and client in separate processes.
+// The server fills every byte of each frame and the client copies every byte out, as a real producer and consumer would,
+// through the full Tick -> WaitForClientRead -> SignalWrite and Tick -> WaitForServerWrite -> SignalRead sequences.
+// Either side blocks in Stc*CpuWait when it has nothing to do.
+//
+// Latency is from just before SignalWrite to just after WaitForServerWrite returns, on CLOCK_MONOTONIC. CPU time is
+// user plus system time per frame for each process.
+//
+// The client asks for the ring depth when it connects, so --rings sweeps depths in one run.
+//
+// Usage: StcBenchFrames [--frames N] [--resolutions 720p,1080p,1440p,4k,8k] [--formats rgba8,rgba16f] [--rings 2,3,4,8]
+//                       [--swap fifo|mailbox]
+
+#ifdef _WIN32
+#error StcBenchFrames needs fork and is POSIX only
+#endif
+
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE 1
+#endif
+
+#include "StcClient.h"
+#include "StcServer.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <time.h>
+#include <unistd.h>
+
+#define BENCH_WAIT_MS 100
+#define BENCH_CONNECT_ATTEMPTS 5000
+
+typedef struct BenchResolution {
+    const char* pName;
+    UINT width;
+    UINT height;
+} BenchResolution;
+
+static const BenchResolution resolutions[] = {
+    {"720p", 1280, 720}, {"1080p", 1920, 1080}, {"1440p", 2560, 1440}, {"4k", 3840, 2160}, {"8k", 7680, 4320},
+};
+
+typedef struct BenchFormat {
+    const char* pName;
+    StcFormat format;
+} BenchFormat;
+
+static const BenchFormat formats[] = {
+    {"rgba8", STC_FORMAT_R8G8B8A8_SRGB},
+    {"rgba16f", STC_FORMAT_R16G16B16A16_FLOAT},
+};
+
+// Written by the server at the start of each frame's pixel data
+typedef struct BenchStamp {
+    uint64_t sequence;
+    int64_t publishTime;
+} BenchStamp;
+
+// Sent from the client process back to the server process over a pipe
+typedef struct BenchClientResult {
+    bool ok;
+    uint64_t frames;
+    int64_t elapsed;
+    int64_t cpuTime;
+    int64_t latencyP50;
+    int64_t latencyP90;
+    int64_t latencyP99;
+    int64_t latencyMax;
+} BenchClientResult;
+
+static int64_t BenchNow(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+static int64_t BenchCpuTime(void) {
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    return ((int64_t)(usage.ru_utime.tv_sec + usage.ru_stime.tv_sec) * 1000000000) +
+           ((int64_t)(usage.ru_utime.tv_usec + usage.ru_stime.tv_usec) * 1000);
+}
+
+static int BenchCompare(const void* const pA, const void* const pB) {
+    const int64_t a = *(const int64_t*)pA;
+    const int64_t b = *(const int64_t*)pB;
+    return (a > b) - (a < b);
+}
+
+static int64_t BenchPercentile(const int64_t* const pSorted, const size_t count, const double percentile) {
+    size_t index = (size_t)((double)count * percentile);
+    return pSorted[(index < count) ? index : (count - 1)];
+}
+
+static BenchClientResult BenchRunClient(const uint32_t serverProcessId, const uint64_t frames, const uint32_t textureCount,
+                                        const StcSwapMode swapMode) {
+    BenchClientResult result;
+    memset(&result, 0, sizeof(result));
+
+    int64_t* const pLatencies = malloc(sizeof(int64_t) * frames);
+    StcClientCpu client;
+    if ((pLatencies == NULL) || (StcClientCpuCreate(&client, NULL, NULL) != STC_CLIENT_STATUS_SUCCESS)) {
+        free(pLatencies);
+        return result;
+    }
+
+    StcClientStatus status = STC_CLIENT_STATUS_FAIL_NOT_CONNECTED;
+    for (int i = 0; (i < BENCH_CONNECT_ATTEMPTS) && (status != STC_CLIENT_STATUS_SUCCESS); ++i) {
+        status = StcClientCpuConnect(&client, STC_DEFAULT_PREFIX, serverProcessId, textureCount, swapMode);
+        if (status != STC_CLIENT_STATUS_SUCCESS) {
+            usleep(1000);
+        }
+    }
+
+    void* pCopy = NULL;
+    size_t copySize = 0;
+    size_t lastIndex = STC_MAX_TEXTURE_COUNT;
+    uint64_t received = 0;
+    int64_t start = 0;
+    int64_t cpuStart = 0;
+    while ((status == STC_CLIENT_STATUS_SUCCESS) && (received < frames)) {
+        StcClientCpuNextInfo nextInfo;
+        status = StcClientCpuTick(&client, &nextInfo);
+        if (status != STC_CLIENT_STATUS_SUCCESS) {
+            break;
+        }
+
+        // A slot change is the only way a new frame shows up, so anything else is a repeat of the last one
+        if ((nextInfo.pData == NULL) || (nextInfo.index == lastIndex)) {
+            StcClientCpuWait(&client, BENCH_WAIT_MS);
+            continue;
+        }
+
+        status = StcClientCpuWaitForServerWrite(&client);
+        if (status != STC_CLIENT_STATUS_SUCCESS) {
+            break;
+        }
+
+        const int64_t acquireTime = BenchNow();
+        BenchStamp stamp;
+        memcpy(&stamp, nextInfo.pData, sizeof(stamp));
+
+        const size_t size = nextInfo.rowPitch * nextInfo.height;
+        if (size > copySize) {
+            free(pCopy);
+            pCopy = malloc(size);
+            copySize = (pCopy != NULL) ? size : 0;
+        }
+        if (pCopy != NULL) {
+            memcpy(pCopy, nextInfo.pData, size);
+        }
+
+        status = StcClientCpuSignalRead(&client);
+        lastIndex = nextInfo.index;
+
+        if (received == 0) {
+            start = acquireTime;
+            cpuStart = BenchCpuTime();
+        }
+
+        pLatencies[received++] = acquireTime - stamp.publishTime;
+    }
+
+    // The first frame only starts the clocks
+    if ((received == frames) && (frames > 1)) {
+        result.ok = true;
+        result.frames = frames - 1;
+        result.elapsed = BenchNow() - start;
+        result.cpuTime = BenchCpuTime() - cpuStart;
+
+        qsort(pLatencies, (size_t)frames, sizeof(int64_t), BenchCompare);
+        result.latencyP50 = BenchPercentile(pLatencies, (size_t)frames, 0.50);
+        result.latencyP90 = BenchPercentile(pLatencies, (size_t)frames, 0.90);
+        result.latencyP99 = BenchPercentile(pLatencies, (size_t)frames, 0.99);
+        result.latencyMax = pLatencies[frames - 1];
+    }
+
+    StcClientCpuDestroy(&client);
+    free(pCopy);
+    free(pLatencies);
+    return result;
+}
+
+static bool BenchRunConfiguration(const BenchResolution* const pResolution, const BenchFormat* const pFormat,
+                                  const uint64_t frames, const uint32_t textureCount, const StcSwapMode swapMode) {
+    const StcServerGraphicsInfo graphicsInfo = {pResolution->width, pResolution->height, pFormat->format};
+    StcServerCpu server;
+    if (StcServerCpuCreate(&server, STC_DEFAULT_PREFIX, &graphicsInfo, 0, NULL, NULL) != STC_SERVER_STATUS_SUCCESS) {
+        fprintf(stderr, "Failed to create server.\n");
+        return false;
+    }
+
+    int fds[2];
+    if (pipe(fds) != 0) {
+        StcServerCpuDestroy(&server);
+        return false;
+    }
+
+    const uint32_t serverProcessId = (uint32_t)getpid();
+    fflush(stdout);
+    const pid_t child = fork();
+    if (child == 0) {
+        close(fds[0]);
+        const BenchClientResult result = BenchRunClient(serverProcessId, frames, textureCount, swapMode);
+        const ssize_t written = write(fds[1], &result, sizeof(result));
+        _exit((written == (ssize_t)sizeof(result)) ? 0 : 1);
+    }
+    close(fds[1]);
+
+    uint64_t published = 0;
+    int64_t cpuStart = 0;
+    int64_t cpuTime = 0;
+    bool running = child > 0;
+    while (running) {
+        StcServerCpuNextInfo nextInfo;
+        const StcServerStatus status = StcServerCpuTick(&server, &nextInfo);
+        if (status == STC_SERVER_STATUS_SUCCESS) {
+            if ((StcServerCpuWaitForClientRead(&server) == STC_SERVER_STATUS_SUCCESS)) {
+                if (published == 0) {
+                    cpuStart = BenchCpuTime();
+                }
+
+                memset(nextInfo.pData, (int)(published & 0xFF), nextInfo.rowPitch * server.base.streams[0].graphicsInfo.height);
+
+                BenchStamp stamp;
+                stamp.sequence = published;
+                stamp.publishTime = BenchNow();
+                memcpy(nextInfo.pData, &stamp, sizeof(stamp));
+
+                if (StcServerCpuSignalWrite(&server) == STC_SERVER_STATUS_SUCCESS) {
+                    ++published;
+                    cpuTime = BenchCpuTime() - cpuStart;
+                }
+            }
+        } else {
+            StcServerCpuWait(&server, BENCH_WAIT_MS);
+            running = waitpid(child, NULL, WNOHANG) == 0;
+        }
+    }
+
+    BenchClientResult result;
+    const bool received = read(fds[0], &result, sizeof(result)) == (ssize_t)sizeof(result);
+    close(fds[0]);
+    StcServerCpuDestroy(&server);
+
+    if (!received || !result.ok) {
+        printf("%-6s %-8s failed\n", pResolution->pName, pFormat->pName);
+        return false;
+    }
+
+    const double fps = (double)result.frames * 1e9 / (double)result.elapsed;
+    printf("%-6s %-8s %4d %9.1f %9.1f %9.1f %9.1f %9.1f %10.1f %10.1f\n", pResolution->pName, pFormat->pName,
+           (int)textureCount, fps, (double)result.latencyP50 / 1e3, (double)result.latencyP90 / 1e3,
+           (double)result.latencyP99 / 1e3, (double)result.latencyMax / 1e3,
+           (published > 1) ? ((double)cpuTime / 1e3 / (double)(published - 1)) : 0.0,
+           (double)result.cpuTime / 1e3 / (double)result.frames);
+    return true;
+}
+
+static bool BenchIsSelected(const char* const pList, const char* const pName) {
+    if (pList == NULL) {
+        return true;
+    }
+
+    const size_t length = strlen(pName);
+    for (const char* pCursor = pList; (pCursor = strstr(pCursor, pName)) != NULL; pCursor += length) {
+        const bool startsItem = (pCursor == pList) || (pCursor[-1] == ',');
+        const bool endsItem = (pCursor[length] == '\0') || (pCursor[length] == ',');
+        if (startsItem && endsItem) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+int main(int argc, char** argv) {
+    uint64_t frames = 600;
+    const char* pResolutions = NULL;
+    const char* pFormats = NULL;
+    const char* pRings = "4";
+    StcSwapMode swapMode = STC_SWAP_MODE_FIFO;
+    for (int i = 1; (i + 1) < argc; i += 2) {
+        if (strcmp(argv[i], "--frames") == 0) {
+            frames = strtoull(argv[i + 1], NULL, 10);
+        } else if (strcmp(argv[i], "--resolutions") == 0) {
+            pResolutions = argv[i + 1];
+        } else if (strcmp(argv[i], "--formats") == 0) {
+            pFormats = argv[i + 1];
+        } else if (strcmp(argv[i], "--rings") == 0) {
+            pRings = argv[i + 1];
+        } else if ((strcmp(argv[i], "--swap") == 0) && (strcmp(argv[i + 1], "fifo") == 0)) {
+            swapMode = STC_SWAP_MODE_FIFO;
+        } else if ((strcmp(argv[i], "--swap") == 0) && (strcmp(argv[i + 1], "mailbox") == 0)) {
+            swapMode = STC_SWAP_MODE_MAILBOX;
+        } else {
+            fprintf(stderr, "Unknown option %s\n", argv[i]);
+            return 1;
+        }
+    }
+
+    if (frames < 2) {
+        fprintf(stderr, "Need at least 2 frames.\n");
+        return 1;
+    }
+
+    printf("%-6s %-8s %4s %9s %9s %9s %9s %9s %10s %10s\n", "res", "format", "ring", "frames/s", "p50 us", "p90 us",
+           "p99 us", "max us", "srv cpu us", "cli cpu us");
+
+    bool ok = true;
+    for (size_t r = 0; r < _countof(resolutions); ++r) {
+        for (size_t f = 0; f < _countof(formats); ++f) {
+            if (BenchIsSelected(pResolutions, resolutions[r].pName) && BenchIsSelected(pFormats, formats[f].pName)) {
+                for (const char* pCursor = pRings; *pCursor != '\0';) {
+                    char* pEnd;
+                    const unsigned long textureCount = strtoul(pCursor, &pEnd, 10);
+                    if ((pEnd == pCursor) || (textureCount < STC_MIN_TEXTURE_COUNT) || (textureCount > STC_MAX_TEXTURE_COUNT)) {
+                        fprintf(stderr, "Ring depths must be between %d and %d.\n", STC_MIN_TEXTURE_COUNT, STC_MAX_TEXTURE_COUNT);
+                        return 1;
+                    }
+
+                    ok = BenchRunConfiguration(&resolutions[r], &formats[f], frames, (uint32_t)textureCount, swapMode) && ok;
+                    pCursor = (*pEnd == ',') ? (pEnd + 1) : pEnd;
+                }
+            }
+        }
+    }
+
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,381 @@
+/*
+ * Copyright 2020 Lag Free Games, LLC
+ * All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sub license, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the
+ * next paragraph) shall be included in all copies or substantial portions
+ * of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT.
+ * IN NO EVENT SHALL VMWARE AND/OR ITS SUPPLIERS BE LIABLE FOR
+ * ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+// Cost of the shared-memory writes each side makes per frame, with the 0.x StcInfo layout, where the server's and the
+// client's fields share cache lines and both keepalives are written on every tick, versus the current layout. Both runs
+// hand the same frames back and forth through the slot state words, which are shared by design, so the difference is the
+// false sharing around them. The threads must land on different cores for it to show, and more so on different sockets.
+// On Linux, perf c2c shows the contended lines directly. With fewer than two CPUs available the benchmark exits, since
+// every handoff would wait on the scheduler instead.
+//
+// Linux: cc -O2 -I.. StcBenchLayout.c ../StcMisc.c -o StcBenchLayout -lpthread
+// MSVC:  cl /O2 /I.. StcBenchLayout.c ..\StcMisc.c
+
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE 1
+#endif
+
+#include "StcCommon.h"
+#include "StcMisc.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#ifdef _WIN32
+typedef HANDLE BenchThread;
+#else
+#include <pthread.h>
+#include <sched.h>
+#include <time.h>
+#include <unistd.h>
+typedef pthread_t BenchThread;
+#endif
+
+#ifndef BENCH_TICKS
+#define BENCH_TICKS 5000000
+#endif
+
+// Failed attempts in a row before a side gives up its timeslice, in case the other side was preempted
+#define BENCH_SPINS_BEFORE_YIELD 64
+
+static int64_t BenchNow(void) {
+#ifdef _WIN32
+    LARGE_INTEGER count;
+    LARGE_INTEGER frequency;
+    QueryPerformanceCounter(&count);
+    QueryPerformanceFrequency(&frequency);
+    return (int64_t)((double)count.QuadPart * 1e9 / (double)frequency.QuadPart);
+#else
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+#endif
+}
+
+static size_t BenchCpuCount(void) {
+#ifdef _WIN32
+    SYSTEM_INFO systemInfo;
+    GetSystemInfo(&systemInfo);
+    return systemInfo.dwNumberOfProcessors;
+#elif defined(__linux__)
+    cpu_set_t set;
+    return (sched_getaffinity(0, sizeof(set), &set) == 0) ? (size_t)CPU_COUNT(&set) : 1;
+#else
+    const long count = sysconf(_SC_NPROCESSORS_ONLN);
+    return (count > 0) ? (size_t)count : 1;
+#endif
+}
+
+static void BenchPause(void) {
+#ifdef _WIN32
+    YieldProcessor();
+#elif defined(__i386__) || defined(__x86_64__)
+    __builtin_ia32_pause();
+#endif
+}
+
+static void BenchYield(void) {
+#ifdef _WIN32
+    SwitchToThread();
+#else
+    sched_yield();
+#endif
+}
+
+#pragma warning(push)
+#pragma warning(disable : 4820)
+
+// The 0.x layout, field for field, so every offset matches what the library used to map
+typedef struct LegacyFrameRecord {
+    uint64_t sequence;
+    int64_t publishTicks;
+    int64_t acquireTicks;
+    int64_t releaseTicks;
+    uint32_t sliceCount;
+} LegacyFrameRecord;
+
+typedef struct LegacyStreamInfo {
+    uint32_t hTextures[STC_MAX_TEXTURE_COUNT];
+    uint32_t hWriteFences12[STC_MAX_TEXTURE_COUNT];
+    uint32_t hReadFences12[STC_MAX_TEXTURE_COUNT];
+    uint64_t writeFenceValues12[STC_MAX_TEXTURE_COUNT];
+    uint64_t readFenceValues12[STC_MAX_TEXTURE_COUNT];
+    bool invalidated[STC_MAX_TEXTURE_COUNT];
+    StcAtomicUint32 slotStates[STC_MAX_TEXTURE_COUNT];
+    LegacyFrameRecord frameRecords[STC_MAX_TEXTURE_COUNT];
+    StcAtomicUint32 sliceProgress[STC_MAX_TEXTURE_COUNT];
+    StcAtomicUint32 leaseCount;
+} LegacyStreamInfo;
+
+typedef struct LegacyInfo {
+    StcBindFlags clientBindFlags;
+    StcSrgbChannelType srgbChannelType;
+    StcApi clientApi;
+    uint32_t textureCount;
+    StcSwapMode swapMode;
+    uint32_t streamMask;
+    uint32_t clientMinorVersion;
+    StcCapabilityFlags clientCapabilities;
+    StcAtomicBool clientParametersSpecified;
+    StcAtomicUint32 frameIntervalMicroseconds;
+    StcAtomicUint32 requestedBindFlags;
+    StcAtomicUint32 requestedSrgbChannelType;
+    StcAtomicUint32 parameterGeneration;
+    StcAtomicInt64 serverKeepAlive;
+    StcAtomicBool serverInitialized;
+    StcAtomicUint32 serverStopReason;
+    StcAtomicUint32 leaseLimit;
+    StcAtomicInt64 clientKeepAlive;
+    StcAtomicUint32 clientStopReason;
+    StcWakeWord clientWake;
+    StcAtomicUint32 controlHead;
+    StcAtomicUint32 controlTail;
+    StcControlMessage controlMessages[STC_CONTROL_RING_SIZE];
+    StcAtomicUint32 auxHead;
+    StcAtomicUint32 auxTail;
+    LegacyStreamInfo streams[STC_MAX_STREAM_COUNT];
+} LegacyInfo;
+
+#pragma warning(pop)
+
+// The fields one frame touches, wherever the layout puts them
+typedef struct BenchLayout {
+    StcAtomicInt64* pServerKeepAlive;
+    StcAtomicInt64* pClientKeepAlive;
+    StcAtomicUint32* pServerStopReason;
+    StcAtomicUint32* pClientStopReason;
+    StcAtomicUint32* pSlotStates;
+    StcAtomicUint32* pSliceProgress;
+    uint64_t* pWriteFenceValues;
+    uint64_t* pReadFenceValues;
+    uint64_t* pSequences[STC_MAX_TEXTURE_COUNT];
+    int64_t* pPublishTicks[STC_MAX_TEXTURE_COUNT];
+    int64_t* pAcquireTicks[STC_MAX_TEXTURE_COUNT];
+    int64_t* pReleaseTicks[STC_MAX_TEXTURE_COUNT];
+    // Ticks between keepalive refreshes, 0 refreshes on every tick
+    int64_t keepAliveTicks;
+} BenchLayout;
+
+static LegacyInfo legacyInfo;
+static StcInfo info;
+
+static void MakeLegacyLayout(BenchLayout* const pLayout) {
+    LegacyInfo* const pInfo = &legacyInfo;
+    LegacyStreamInfo* const pStream = &pInfo->streams[0];
+    pLayout->pServerKeepAlive = &pInfo->serverKeepAlive;
+    pLayout->pClientKeepAlive = &pInfo->clientKeepAlive;
+    pLayout->pServerStopReason = &pInfo->serverStopReason;
+    pLayout->pClientStopReason = &pInfo->clientStopReason;
+    pLayout->pSlotStates = pStream->slotStates;
+    pLayout->pSliceProgress = pStream->sliceProgress;
+    pLayout->pWriteFenceValues = pStream->writeFenceValues12;
+    pLayout->pReadFenceValues = pStream->readFenceValues12;
+    for (size_t i = 0; i < STC_MAX_TEXTURE_COUNT; ++i) {
+        pLayout->pSequences[i] = &pStream->frameRecords[i].sequence;
+        pLayout->pPublishTicks[i] = &pStream->frameRecords[i].publishTicks;
+        pLayout->pAcquireTicks[i] = &pStream->frameRecords[i].acquireTicks;
+        pLayout->pReleaseTicks[i] = &pStream->frameRecords[i].releaseTicks;
+    }
+    pLayout->keepAliveTicks = 0;
+}
+
+static void MakeCurrentLayout(BenchLayout* const pLayout) {
+    StcInfo* const pInfo = &info;
+    StcStreamInfo* const pStream = &pInfo->streams[0];
+    pLayout->pServerKeepAlive = &pInfo->serverKeepAlive;
+    pLayout->pClientKeepAlive = &pInfo->clientKeepAlive;
+    pLayout->pServerStopReason = &pInfo->serverStopReason;
+    pLayout->pClientStopReason = &pInfo->clientStopReason;
+    pLayout->pSlotStates = pStream->slotStates;
+    pLayout->pSliceProgress = pStream->sliceProgress;
+    pLayout->pWriteFenceValues = pStream->writeFenceValues12;
+    pLayout->pReadFenceValues = pStream->readFenceValues12;
+    for (size_t i = 0; i < STC_MAX_TEXTURE_COUNT; ++i) {
+        pLayout->pSequences[i] = &pStream->frameRecords[i].sequence;
+        pLayout->pPublishTicks[i] = &pStream->frameRecords[i].publishTicks;
+        pLayout->pAcquireTicks[i] = &pStream->frameReadTicks[i].acquireTicks;
+        pLayout->pReleaseTicks[i] = &pStream->frameReadTicks[i].releaseTicks;
+    }
+    pLayout->keepAliveTicks = StcGetTimeoutTicks() / STC_KEEP_ALIVE_DIVISOR;
+}
+
+static void RefreshKeepAlive(StcAtomicInt64* const pKeepAlive, const int64_t interval, const int64_t now) {
+    if ((now - StcAtomicInt64LoadRelaxed(pKeepAlive)) >= interval) {
+        StcAtomicInt64StoreRelaxed(pKeepAlive, now);
+    }
+}
+
+// Mirrors TickServer, PublishSlot and the fence value the D3D12 backend stores with each frame
+static bool ServerTick(const BenchLayout* const pLayout, const uint64_t frame) {
+    const int64_t now = StcGetCurrentTicks();
+    RefreshKeepAlive(pLayout->pServerKeepAlive, pLayout->keepAliveTicks, now);
+
+    bool published = false;
+    const size_t index = (size_t)(frame % STC_DEFAULT_TEXTURE_COUNT);
+    StcAtomicUint32* const pState = &pLayout->pSlotStates[index];
+    if ((StcAtomicUint32Load(pLayout->pClientStopReason) == 0) &&
+        ((now - StcAtomicInt64LoadRelaxed(pLayout->pClientKeepAlive)) < StcGetTimeoutTicks()) &&
+        (StcAtomicUint32Load(pState) == STC_SLOT_STATE_FREE)) {
+        StcAtomicUint32StoreRelaxed(pState, STC_SLOT_STATE_WRITING);
+        pLayout->pWriteFenceValues[index] = frame;
+        *pLayout->pSequences[index] = frame;
+        *pLayout->pPublishTicks[index] = now;
+        StcAtomicUint32StoreRelaxed(&pLayout->pSliceProgress[index], 1);
+        StcAtomicUint32StoreRelease(pState, StcSlotMakeState(STC_SLOT_STATE_READY, frame));
+        published = true;
+    }
+
+    return published;
+}
+
+// Mirrors TickClient, AcquireFrameRecord and SignalRead
+static bool ClientTick(const BenchLayout* const pLayout, const uint64_t frame) {
+    const int64_t now = StcGetCurrentTicks();
+    RefreshKeepAlive(pLayout->pClientKeepAlive, pLayout->keepAliveTicks, now);
+
+    bool consumed = false;
+    const size_t index = (size_t)(frame % STC_DEFAULT_TEXTURE_COUNT);
+    StcAtomicUint32* const pState = &pLayout->pSlotStates[index];
+    const uint32_t state = StcAtomicUint32Load(pState);
+    if ((StcAtomicUint32Load(pLayout->pServerStopReason) == 0) &&
+        ((now - StcAtomicInt64LoadRelaxed(pLayout->pServerKeepAlive)) < StcGetTimeoutTicks()) &&
+        ((state & STC_SLOT_STATE_MASK) == STC_SLOT_STATE_READY) &&
+        (StcAtomicUint32CompareExchange(pState, (state & ~STC_SLOT_STATE_MASK) | STC_SLOT_STATE_READING, state) == state)) {
+        *pLayout->pAcquireTicks[index] = now;
+        *pLayout->pReleaseTicks[index] = 0;
+        const uint64_t sequence = *pLayout->pSequences[index];
+        pLayout->pReadFenceValues[index] = sequence;
+        *pLayout->pReleaseTicks[index] = StcGetCurrentTicks();
+        StcAtomicUint32StoreRelease(pState, STC_SLOT_STATE_FREE);
+        consumed = true;
+    }
+
+    return consumed;
+}
+
+typedef struct SideArgs {
+    const BenchLayout* pLayout;
+    bool server;
+    uint64_t ticks;
+} SideArgs;
+
+#ifdef _WIN32
+static DWORD WINAPI SideMain(void* const pArg) {
+#else
+static void* SideMain(void* const pArg) {
+#endif
+    SideArgs* const pArgs = pArg;
+    uint64_t frame = 0;
+    uint64_t ticks = 0;
+    uint32_t spins = 0;
+    while (frame < BENCH_TICKS) {
+        if (pArgs->server ? ServerTick(pArgs->pLayout, frame) : ClientTick(pArgs->pLayout, frame)) {
+            ++frame;
+            spins = 0;
+        } else if (++spins < BENCH_SPINS_BEFORE_YIELD) {
+            BenchPause();
+        } else {
+            BenchYield();
+            spins = 0;
+        }
+        ++ticks;
+    }
+    pArgs->ticks = ticks;
+#ifdef _WIN32
+    return 0;
+#else
+    return NULL;
+#endif
+}
+
+static bool StartThread(BenchThread* const pThread, SideArgs* const pArgs) {
+#ifdef _WIN32
+    *pThread = CreateThread(NULL, 0, SideMain, pArgs, 0, NULL);
+    return *pThread != NULL;
+#else
+    return pthread_create(pThread, NULL, SideMain, pArgs) == 0;
+#endif
+}
+
+static void JoinThread(const BenchThread thread) {
+#ifdef _WIN32
+    WaitForSingleObject(thread, INFINITE);
+    CloseHandle(thread);
+#else
+    pthread_join(thread, NULL);
+#endif
+}
+
+// Returns nanoseconds per frame handed from the server thread to the client thread
+static bool RunPaired(const BenchLayout* const pLayout, double* const pNsPerFrame) {
+    for (size_t i = 0; i < STC_MAX_TEXTURE_COUNT; ++i) {
+        StcAtomicUint32StoreRelaxed(&pLayout->pSlotStates[i], STC_SLOT_STATE_FREE);
+    }
+    StcAtomicInt64StoreRelaxed(pLayout->pServerKeepAlive, StcGetCurrentTicks());
+    StcAtomicInt64StoreRelaxed(pLayout->pClientKeepAlive, StcGetCurrentTicks());
+
+    SideArgs serverArgs = {pLayout, true, 0};
+    SideArgs clientArgs = {pLayout, false, 0};
+    BenchThread serverThread;
+    BenchThread clientThread;
+    const int64_t start = BenchNow();
+    if (!StartThread(&serverThread, &serverArgs)) {
+        return false;
+    }
+    if (!StartThread(&clientThread, &clientArgs)) {
+        JoinThread(serverThread);
+        return false;
+    }
+    JoinThread(serverThread);
+    JoinThread(clientThread);
+
+    *pNsPerFrame = (double)(BenchNow() - start) / BENCH_TICKS;
+    return true;
+}
+
+int main(void) {
+    const size_t cpuCount = BenchCpuCount();
+    if (cpuCount < 2) {
+        fprintf(stderr, "Needs at least 2 CPUs for the server and client threads, %u available.\n", (unsigned)cpuCount);
+        return EXIT_FAILURE;
+    }
+
+    BenchLayout legacyLayout;
+    BenchLayout currentLayout;
+    MakeLegacyLayout(&legacyLayout);
+    MakeCurrentLayout(&currentLayout);
+
+    double legacyNs, currentNs;
+    if (!RunPaired(&legacyLayout, &legacyNs) || !RunPaired(&currentLayout, &currentNs)) {
+        fprintf(stderr, "Failed to start benchmark threads.\n");
+        return EXIT_FAILURE;
+    }
+
+    printf("%-28s %12s %12s\n", "", "0.x layout", "current");
+    printf("%-28s %9.2f ns %9.2f ns\n", "frame handoff (2 cores)", legacyNs, currentNs);
+    printf("%-28s %10.2f M %10.2f M\n", "frames per second", 1e3 / legacyNs, 1e3 / currentNs);
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,509 @@
+/*
+ * Copyright 2020 Lag Free Games, LLC
+ * All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sub license, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the
+ * next paragraph) shall be included in all copies or substantial portions
+ * of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT.
+ * IN NO EVENT SHALL VMWARE AND/OR ITS SUPPLIERS BE LIABLE FOR
+ * ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+// Deterministic simulation of one CPU server and N CPU clients. Everything runs on one thread against the real
+// StcServer.c/StcClient.c state machines and shared memory, while StcGetCurrentTicks reads a virtual clock that only
+// moves when the scheduler says so. Each actor step costs a delay picked by the scheduling policy, so a run of millions
+// of frames, including 5 second keepalive timeouts, finishes in seconds and replays exactly for a given seed.
+//
+// Linux: cc -O2 -DSTC_VIRTUAL_CLOCK -I.. StcSimulator.c ../StcServer.c ../StcClient.c ../StcMisc.c ../StcTransport.c
+//           -o StcSimulator
+// MSVC:  cl /O2 /DSTC_VIRTUAL_CLOCK /I.. StcSimulator.c ..\StcServer.c ..\StcClient.c ..\StcMisc.c ..\StcTransport.c
+//
+// Usage: StcSimulator [--frames N] [--clients N] [--client-frames N] [--seed N] [--policy jitter|burst]
+//                     [--server-period NS] [--client-period NS] [--jitter F] [--stall-chance F] [--stall NS]
+//                     [--resize-every N] [--connect-retry NS] [--ring N] [--swap fifo|mailbox] [--client-interval NS]
+
+#ifndef STC_VIRTUAL_CLOCK
+#error StcSimulator must be built with STC_VIRTUAL_CLOCK
+#endif
+
+#include "StcClient.h"
+#include "StcMisc.h"
+#include "StcServer.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define SIM_MAX_CLIENTS 64
+#define SIM_HISTOGRAM_BUCKETS 64
+
+typedef struct SimRng {
+    uint64_t state;
+} SimRng;
+
+static uint64_t SimRngNext(SimRng* const pRng) {
+    // xorshift64*
+    uint64_t x = pRng->state;
+    x ^= x >> 12;
+    x ^= x << 25;
+    x ^= x >> 27;
+    pRng->state = x;
+    return x * 0x2545F4914F6CDD1DULL;
+}
+
+static double SimRngUnit(SimRng* const pRng) { return (double)(SimRngNext(pRng) >> 11) * (1.0 / 9007199254740992.0); }
+
+// Log2 buckets of nanoseconds, plus exact count, sum and max
+typedef struct SimHistogram {
+    uint64_t buckets[SIM_HISTOGRAM_BUCKETS];
+    uint64_t count;
+    double sum;
+    int64_t max;
+} SimHistogram;
+
+static void SimHistogramAdd(SimHistogram* const pHistogram, const int64_t value) {
+    size_t bucket = 0;
+    while ((bucket + 1 < SIM_HISTOGRAM_BUCKETS) && ((int64_t)1 << (bucket + 1)) <= value) {
+        ++bucket;
+    }
+
+    ++pHistogram->buckets[bucket];
+    ++pHistogram->count;
+    pHistogram->sum += (double)value;
+    if (value > pHistogram->max) {
+        pHistogram->max = value;
+    }
+}
+
+// Upper bound of the bucket holding the given quantile
+static int64_t SimHistogramQuantile(const SimHistogram* const pHistogram, const double quantile) {
+    const uint64_t target = (uint64_t)((double)pHistogram->count * quantile);
+    uint64_t seen = 0;
+    for (size_t i = 0; i < SIM_HISTOGRAM_BUCKETS; ++i) {
+        seen += pHistogram->buckets[i];
+        if (seen > target) {
+            const int64_t bound = ((int64_t)1 << (i + 1)) - 1;
+            return (bound < pHistogram->max) ? bound : pHistogram->max;
+        }
+    }
+
+    return pHistogram->max;
+}
+
+static void SimHistogramPrint(const char* const pName, const SimHistogram* const pHistogram) {
+    if (pHistogram->count == 0) {
+        printf("%-22s %10s\n", pName, "none");
+    } else {
+        printf("%-22s %10llu %12.0f %12lld %12lld %12lld\n", pName, (unsigned long long)pHistogram->count,
+               pHistogram->sum / (double)pHistogram->count, (long long)SimHistogramQuantile(pHistogram, 0.5),
+               (long long)SimHistogramQuantile(pHistogram, 0.99), (long long)pHistogram->max);
+    }
+}
+
+typedef enum SimActorKind {
+    SIM_ACTOR_SERVER,
+    SIM_ACTOR_CLIENT,
+} SimActorKind;
+
+typedef struct SimConfig SimConfig;
+typedef struct SimActor SimActor;
+
+// Returns how long the actor's step took, i.e. when it runs next. Policies are the injection point for scheduling.
+typedef int64_t (*PFN_SimSchedule)(const SimConfig* pConfig, SimActor* pActor, SimRng* pRng, int64_t now);
+
+struct SimConfig {
+    uint64_t frames;
+    size_t clientCount;
+    uint64_t clientFrames;
+    uint64_t seed;
+    int64_t serverPeriod;
+    int64_t clientPeriod;
+    double jitter;
+    double stallChance;
+    int64_t stall;
+    uint64_t resizeEvery;
+    int64_t connectRetry;
+    uint32_t textureCount;
+    StcSwapMode swapMode;
+    int64_t clientInterval;
+    const char* pPolicyName;
+    PFN_SimSchedule pfnSchedule;
+};
+
+struct SimActor {
+    SimActorKind kind;
+    int64_t nextTime;
+
+    // Client state
+    StcClientCpu client;
+    bool connected;
+    bool sawFirstFrame;
+    int64_t connectStart;
+    int64_t connectedAt;
+    int64_t lastNewFrame;
+    uint32_t lastStamp;
+    uint64_t framesRead;
+
+    // Burst policy state
+    int64_t burstUntil;
+    bool sleeping;
+};
+
+static int64_t SimJittered(const SimConfig* const pConfig, SimRng* const pRng, const int64_t period) {
+    const double scale = 1.0 + (pConfig->jitter * ((SimRngUnit(pRng) * 2.0) - 1.0));
+    int64_t delay = (int64_t)((double)period * scale);
+    if (SimRngUnit(pRng) < pConfig->stallChance) {
+        delay += pConfig->stall;
+    }
+
+    return (delay > 0) ? delay : 1;
+}
+
+// Independent jittered periods with occasional stalls
+static int64_t SimScheduleJitter(const SimConfig* const pConfig, SimActor* const pActor, SimRng* const pRng,
+                                 const int64_t now) {
+    (void)now;
+    return SimJittered(pConfig, pRng, (pActor->kind == SIM_ACTOR_SERVER) ? pConfig->serverPeriod : pConfig->clientPeriod);
+}
+
+// Actors alternate between running flat out and sleeping for random bursts, which starves one side of the ring
+static int64_t SimScheduleBurst(const SimConfig* const pConfig, SimActor* const pActor, SimRng* const pRng, const int64_t now) {
+    const int64_t period = (pActor->kind == SIM_ACTOR_SERVER) ? pConfig->serverPeriod : pConfig->clientPeriod;
+    if (now >= pActor->burstUntil) {
+        pActor->sleeping = !pActor->sleeping;
+        pActor->burstUntil = now + (int64_t)((double)period * 64.0 * SimRngUnit(pRng)) + period;
+    }
+
+    return pActor->sleeping ? (pActor->burstUntil - now) : SimJittered(pConfig, pRng, period / 4);
+}
+
+typedef struct SimPolicy {
+    const char* pName;
+    PFN_SimSchedule pfnSchedule;
+} SimPolicy;
+
+static const SimPolicy policies[] = {
+    {"jitter", SimScheduleJitter},
+    {"burst", SimScheduleBurst},
+};
+
+// Written by the server at the start of each frame
+typedef struct SimStamp {
+    uint32_t sequence;
+    int64_t publishTime;
+} SimStamp;
+
+typedef struct SimStats {
+    uint64_t published;
+    uint64_t notWanted;
+    uint64_t read;
+    uint64_t handshakes;
+    uint64_t serverResets;
+    SimHistogram connectWait;
+    SimHistogram handshakeLatency;
+    SimHistogram serverStall;
+    SimHistogram clientGap;
+    SimHistogram frameAge;
+} SimStats;
+
+typedef struct SimServerState {
+    StcServerCpu server;
+    int64_t stallStart;
+    bool stalled;
+} SimServerState;
+
+static void SimStepServer(const SimConfig* const pConfig, SimServerState* const pState, SimStats* const pStats,
+                          const int64_t now) {
+    StcServerCpu* const pServer = &pState->server;
+
+    StcServerCpuNextInfo nextInfo;
+    const StcServerStatus status = StcServerCpuTick(pServer, &nextInfo);
+    if (status == STC_SERVER_STATUS_SUCCESS) {
+        if (pState->stalled) {
+            SimHistogramAdd(&pStats->serverStall, now - pState->stallStart);
+            pState->stalled = false;
+        }
+
+        if (StcServerCpuWaitForClientRead(pServer) == STC_SERVER_STATUS_SUCCESS) {
+            const SimStamp stamp = {(uint32_t)(pStats->published + 1), now};
+            memcpy(nextInfo.pData, &stamp, sizeof(stamp));
+
+            if (StcServerCpuSignalWrite(pServer) == STC_SERVER_STATUS_SUCCESS) {
+                ++pStats->published;
+
+                if ((pConfig->resizeEvery != 0) && ((pStats->published % pConfig->resizeEvery) == 0)) {
+                    const StcServerGraphicsInfo* const pInfo = &pServer->base.streams[0].graphicsInfo;
+                    StcServerCpuResizeBuffers(pServer, (pInfo->width == 16) ? 32 : 16, pInfo->height, pInfo->format);
+                }
+            }
+        }
+    } else if (status == STC_SERVER_STATUS_FAIL_FRAME_NOT_WANTED) {
+        ++pStats->notWanted;
+    } else if (status == STC_SERVER_STATUS_FAIL_NO_FRAMES_AVAIALBLE) {
+        if (!pState->stalled) {
+            pState->stallStart = now;
+            pState->stalled = true;
+        }
+    } else if ((status != STC_SERVER_STATUS_FAIL_DISCONNECTED) && (status != STC_SERVER_STATUS_FAIL_CONNECT_IN_PROGRESS)) {
+        ++pStats->serverResets;
+        pState->stalled = false;
+    }
+}
+
+static void SimStepClient(const SimConfig* const pConfig, SimActor* const pActor, SimStats* const pStats, const int64_t now) {
+    StcClientCpu* const pClient = &pActor->client;
+
+    if (!pActor->connected) {
+        if (pActor->connectStart < 0) {
+            pActor->connectStart = now;
+        }
+
+        if (StcClientCpuConnect(pClient, STC_DEFAULT_PREFIX, StcGetCurrentProcessId(), pConfig->textureCount, pConfig->swapMode) ==
+            STC_CLIENT_STATUS_SUCCESS) {
+            pActor->connected = true;
+            pActor->sawFirstFrame = false;
+            pActor->connectedAt = now;
+            SimHistogramAdd(&pStats->connectWait, now - pActor->connectStart);
+        }
+
+        return;
+    }
+
+    StcClientCpuNextInfo nextInfo;
+    if (StcClientCpuTick(pClient, &nextInfo) != STC_CLIENT_STATUS_SUCCESS) {
+        // Dropped, e.g. by a keepalive timeout during a stall. Queue up for the token again.
+        pActor->connected = false;
+        pActor->connectStart = now;
+        return;
+    }
+
+    if ((nextInfo.pData != NULL) && (StcClientCpuWaitForServerWrite(pClient) == STC_CLIENT_STATUS_SUCCESS)) {
+        SimStamp stamp;
+        memcpy(&stamp, nextInfo.pData, sizeof(stamp));
+        StcClientCpuSignalRead(pClient);
+
+        if (stamp.sequence != pActor->lastStamp) {
+            pActor->lastStamp = stamp.sequence;
+            SimHistogramAdd(&pStats->frameAge, now - stamp.publishTime);
+            ++pActor->framesRead;
+            ++pStats->read;
+
+            if (!pActor->sawFirstFrame) {
+                pActor->sawFirstFrame = true;
+                ++pStats->handshakes;
+                SimHistogramAdd(&pStats->handshakeLatency, now - pActor->connectedAt);
+            } else {
+                SimHistogramAdd(&pStats->clientGap, now - pActor->lastNewFrame);
+            }
+
+            pActor->lastNewFrame = now;
+        }
+    }
+
+    if ((pConfig->clientFrames != 0) && (pActor->framesRead >= pConfig->clientFrames)) {
+        // Leaving hands the connection to the next client in line
+        StcClientCpuDestroy(pClient);
+        StcClientCpuCreate(pClient, NULL, NULL);
+        StcClientCpuSetFrameInterval(pClient, (uint32_t)(pConfig->clientInterval / 1000));
+        pActor->connected = false;
+        pActor->connectStart = -1;
+        pActor->framesRead = 0;
+    }
+}
+
+static bool ParseArguments(SimConfig* const pConfig, const int argc, char** const argv) {
+    for (int i = 1; i < argc; ++i) {
+        const char* const pName = argv[i];
+        if ((i + 1) >= argc) {
+            fprintf(stderr, "Missing value for %s\n", pName);
+            return false;
+        }
+
+        const char* const pValue = argv[++i];
+        if (strcmp(pName, "--frames") == 0) {
+            pConfig->frames = strtoull(pValue, NULL, 10);
+        } else if (strcmp(pName, "--clients") == 0) {
+            pConfig->clientCount = (size_t)strtoull(pValue, NULL, 10);
+        } else if (strcmp(pName, "--client-frames") == 0) {
+            pConfig->clientFrames = strtoull(pValue, NULL, 10);
+        } else if (strcmp(pName, "--seed") == 0) {
+            pConfig->seed = strtoull(pValue, NULL, 10);
+        } else if (strcmp(pName, "--server-period") == 0) {
+            pConfig->serverPeriod = strtoll(pValue, NULL, 10);
+        } else if (strcmp(pName, "--client-period") == 0) {
+            pConfig->clientPeriod = strtoll(pValue, NULL, 10);
+        } else if (strcmp(pName, "--jitter") == 0) {
+            pConfig->jitter = strtod(pValue, NULL);
+        } else if (strcmp(pName, "--stall-chance") == 0) {
+            pConfig->stallChance = strtod(pValue, NULL);
+        } else if (strcmp(pName, "--stall") == 0) {
+            pConfig->stall = strtoll(pValue, NULL, 10);
+        } else if (strcmp(pName, "--resize-every") == 0) {
+            pConfig->resizeEvery = strtoull(pValue, NULL, 10);
+        } else if (strcmp(pName, "--connect-retry") == 0) {
+            pConfig->connectRetry = strtoll(pValue, NULL, 10);
+        } else if (strcmp(pName, "--client-interval") == 0) {
+            pConfig->clientInterval = strtoll(pValue, NULL, 10);
+        } else if (strcmp(pName, "--ring") == 0) {
+            pConfig->textureCount = (uint32_t)strtoul(pValue, NULL, 10);
+        } else if (strcmp(pName, "--swap") == 0) {
+            if (strcmp(pValue, "fifo") == 0) {
+                pConfig->swapMode = STC_SWAP_MODE_FIFO;
+            } else if (strcmp(pValue, "mailbox") == 0) {
+                pConfig->swapMode = STC_SWAP_MODE_MAILBOX;
+            } else {
+                fprintf(stderr, "Unknown swap mode %s\n", pValue);
+                return false;
+            }
+        } else if (strcmp(pName, "--policy") == 0) {
+            pConfig->pfnSchedule = NULL;
+            for (size_t p = 0; p < _countof(policies); ++p) {
+                if (strcmp(pValue, policies[p].pName) == 0) {
+                    pConfig->pPolicyName = policies[p].pName;
+                    pConfig->pfnSchedule = policies[p].pfnSchedule;
+                }
+            }
+
+            if (pConfig->pfnSchedule == NULL) {
+                fprintf(stderr, "Unknown policy %s\n", pValue);
+                return false;
+            }
+        } else {
+            fprintf(stderr, "Unknown option %s\n", pName);
+            return false;
+        }
+    }
+
+    if ((pConfig->clientCount == 0) || (pConfig->clientCount > SIM_MAX_CLIENTS) || (pConfig->serverPeriod <= 0) ||
+        (pConfig->clientPeriod <= 0)) {
+        fprintf(stderr, "Need 1-%d clients and positive periods\n", SIM_MAX_CLIENTS);
+        return false;
+    }
+
+    if ((pConfig->textureCount < STC_MIN_TEXTURE_COUNT) || (pConfig->textureCount > STC_MAX_TEXTURE_COUNT)) {
+        fprintf(stderr, "Ring depth must be %d-%d\n", STC_MIN_TEXTURE_COUNT, STC_MAX_TEXTURE_COUNT);
+        return false;
+    }
+
+    return true;
+}
+
+static SimActor actors[SIM_MAX_CLIENTS + 1];
+
+int main(int argc, char** argv) {
+    SimConfig config;
+    config.frames = 1000000;
+    config.clientCount = 1;
+    config.clientFrames = 0;
+    config.seed = 1;
+    config.serverPeriod = 16666667 / 8;
+    config.clientPeriod = 16666667 / 8;
+    config.jitter = 0.5;
+    config.stallChance = 0.0;
+    config.stall = 0;
+    config.resizeEvery = 0;
+    config.connectRetry = 16666667;
+    config.textureCount = STC_DEFAULT_TEXTURE_COUNT;
+    config.swapMode = STC_SWAP_MODE_FIFO;
+    config.clientInterval = 0;
+    config.pPolicyName = policies[0].pName;
+    config.pfnSchedule = policies[0].pfnSchedule;
+    if (!ParseArguments(&config, argc, argv)) {
+        return 1;
+    }
+
+    SimRng rng;
+    rng.state = (config.seed * 0x9E3779B97F4A7C15ULL) | 1;
+
+    StcSetVirtualTicks(0);
+
+    static SimServerState serverState;
+    const StcServerGraphicsInfo graphicsInfo = {16, 16, STC_FORMAT_R8G8B8A8_SRGB};
+    if (StcServerCpuCreate(&serverState.server, STC_DEFAULT_PREFIX, &graphicsInfo, 0, NULL, NULL) != STC_SERVER_STATUS_SUCCESS) {
+        fprintf(stderr, "Failed to create server.\n");
+        return 1;
+    }
+
+    const size_t actorCount = config.clientCount + 1;
+    actors[0].kind = SIM_ACTOR_SERVER;
+    for (size_t i = 1; i < actorCount; ++i) {
+        SimActor* const pActor = &actors[i];
+        pActor->kind = SIM_ACTOR_CLIENT;
+        pActor->connectStart = -1;
+        pActor->nextTime = (int64_t)(SimRngUnit(&rng) * (double)config.clientPeriod);
+        StcClientCpuCreate(&pActor->client, NULL, NULL);
+        StcClientCpuSetFrameInterval(&pActor->client, (uint32_t)(config.clientInterval / 1000));
+    }
+
+    static SimStats stats;
+    uint64_t steps = 0;
+    int64_t now = 0;
+    const clock_t wallStart = clock();
+    while (stats.published < config.frames) {
+        // Earliest actor runs next. Ties go to the lowest index, which keeps runs reproducible.
+        SimActor* pNext = &actors[0];
+        for (size_t i = 1; i < actorCount; ++i) {
+            if (actors[i].nextTime < pNext->nextTime) {
+                pNext = &actors[i];
+            }
+        }
+
+        now = pNext->nextTime;
+        StcSetVirtualTicks(now);
+
+        if (pNext->kind == SIM_ACTOR_SERVER) {
+            SimStepServer(&config, &serverState, &stats, now);
+        } else {
+            SimStepClient(&config, pNext, &stats, now);
+        }
+
+        // Clients waiting for the token poll at the retry interval, since every failed attempt maps the global info
+        int64_t delay = config.pfnSchedule(&config, pNext, &rng, now);
+        if ((pNext->kind == SIM_ACTOR_CLIENT) && !pNext->connected && (delay < config.connectRetry)) {
+            delay = config.connectRetry;
+        }
+
+        pNext->nextTime = now + delay;
+        ++steps;
+    }
+    const double wallSeconds = (double)(clock() - wallStart) / CLOCKS_PER_SEC;
+
+    for (size_t i = 1; i < actorCount; ++i) {
+        StcClientCpuDestroy(&actors[i].client);
+    }
+    StcServerCpuDestroy(&serverState.server);
+
+    const double simulatedSeconds = (double)now / 1e9;
+    printf("policy %s, seed %llu, %zu client(s), ring %u %s, %llu steps\n", config.pPolicyName, (unsigned long long)config.seed,
+           config.clientCount, (unsigned)config.textureCount, (config.swapMode == STC_SWAP_MODE_MAILBOX) ? "mailbox" : "fifo",
+           (unsigned long long)steps);
+    printf("simulated %.3f s in %.3f s wall (%.0f frames/s wall)\n", simulatedSeconds, wallSeconds,
+           (wallSeconds > 0.0) ? ((double)stats.published / wallSeconds) : 0.0);
+    printf("published %llu (%.1f/s), read %llu (%.1f/s), handshakes %llu, server resets %llu\n",
+           (unsigned long long)stats.published, (double)stats.published / simulatedSeconds, (unsigned long long)stats.read,
+           (double)stats.read / simulatedSeconds, (unsigned long long)stats.handshakes, (unsigned long long)stats.serverResets);
+    printf("skipped %llu server frames no client wanted yet\n", (unsigned long long)stats.notWanted);
+    printf("%-22s %10s %12s %12s %12s %12s\n", "ns", "count", "mean", "p50", "p99", "max");
+    SimHistogramPrint("connect wait", &stats.connectWait);
+    SimHistogramPrint("handshake latency", &stats.handshakeLatency);
+    SimHistogramPrint("server ring-full stall", &stats.serverStall);
+    SimHistogramPrint("client frame gap", &stats.clientGap);
+    SimHistogramPrint("publish-to-read age", &stats.frameAge);
+
+    return 0;
+}